@@ -0,0 +1,85 @@
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+#include <sys/resource.h>
+
+#include "bench_util.hpp"
+#include "parsing/parser.hpp"
+#include "tokenization/tokenize.hpp"
+
+/// Подсчёт всех выделений через operator new за время работы бенчмарка.
+static size_t g_allocations = 0;
+static size_t g_allocatedBytes = 0;
+
+void* operator new(size_t size) {
+    ++g_allocations;
+    g_allocatedBytes += size;
+    if (void* ptr = std::malloc(size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+static long peakRssKb() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+/// Число выделений памяти, пиковый RSS и время освобождения AST на большом входе.
+/// Пиковый RSS общий для процесса, поэтому дерево строится один раз.
+/// Использование: alloc_bench [число функций]
+int main(int argc, char** argv) {
+    int functions = argc > 1 ? std::atoi(argv[1]) : 50000;
+
+    std::string source = bench::MixedProgram(functions);
+    long rssBefore = peakRssKb();
+    std::printf("input: %d functions, %.2f MB\n", functions, source.size() / 1e6);
+
+    size_t allocsBefore = g_allocations;
+    size_t bytesBefore = g_allocatedBytes;
+    auto start = std::chrono::steady_clock::now();
+
+    Lexer lexer(source);
+    Parser parser(lexer);
+    auto tree = parser.parse();
+
+    std::chrono::duration<double> parseTime = std::chrono::steady_clock::now() - start;
+    size_t allocs = g_allocations - allocsBefore;
+    size_t bytes = g_allocatedBytes - bytesBefore;
+    long rssAfter = peakRssKb();
+
+    start = std::chrono::steady_clock::now();
+    size_t arenaChunks = tree->arena.ChunkCount();
+    size_t arenaBytes = tree->arena.BytesReserved();
+    tree.reset();
+    std::chrono::duration<double> freeTime = std::chrono::steady_clock::now() - start;
+
+    std::printf("operator new calls       %12zu\n", allocs);
+    std::printf("operator new bytes       %12zu\n", bytes);
+    std::printf("arena chunks / bytes     %12zu / %zu\n", arenaChunks, arenaBytes);
+    std::printf("parse                    %12.3f ms\n", parseTime.count() * 1e3);
+    std::printf("free tree                %12.3f ms\n", freeTime.count() * 1e3);
+    std::printf("peak RSS growth          %12ld KB\n", rssAfter - rssBefore);
+
+    // то же дерево в плоском представлении (после пикового замера выше)
+    start = std::chrono::steady_clock::now();
+    FlatAst flat;
+    Lexer flatLexer(source);
+    Parser flatParser(flatLexer);
+    flatParser.parseFlat(flat);
+    std::chrono::duration<double> flatTime = std::chrono::steady_clock::now() - start;
+    std::printf("flat AST bytes           %12zu\n", flat.MemoryBytes());
+    std::printf("parse into flat AST      %12.3f ms\n", flatTime.count() * 1e3);
+    return 0;
+}
@@ -0,0 +1,413 @@
+#pragma once
+
+#include <cctype>
+#include <istream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+/// Исходные лексер и парсер проекта, до SourceBuffer, TokenKind, Interner
+/// и арены: токены - std::string, читаются посимвольно из std::istream,
+/// парсер решает всё сравнением строк, а вызов от переменной отличает
+/// исключением. Узлы - unique_ptr с именами-строками. Нужны только
+/// parse_bench как точка отсчёта. Порядок проверок и разбора прежний;
+/// убраны Accept, печать и узлы Type, а Comparison стал BinaryExpression.
+namespace baseline {
+
+enum class TokenType {
+    Identifier,
+    Number,
+    Keyword,
+    Operator,
+    Symbol,
+    EndOfFile
+};
+
+struct Token {
+    TokenType type;
+    std::string value;
+};
+
+class Lexer {
+    std::istream& input;
+    char currentChar;
+
+    void advance() {
+        currentChar = input.get();
+    }
+
+    void skipWhitespace() {
+        while (std::isspace(currentChar)) advance();
+    }
+
+    Token readNumber() {
+        std::string value;
+        while (std::isdigit(currentChar)) {
+            value += currentChar;
+            advance();
+        }
+        return {TokenType::Number, value};
+    }
+
+    Token readIdentifier() {
+        std::string value;
+        while (std::isalnum(currentChar) || currentChar == '_') {
+            value += currentChar;
+            advance();
+        }
+        if (value == "if" || value == "else" || value == "declare" || value == "print" || value == "return" ||
+            value == "int" || value == "func") {
+            return {TokenType::Keyword, value};
+        }
+        return {TokenType::Identifier, value};
+    }
+
+    Token readOperator() {
+        char first = currentChar;
+        advance();
+        if (first == '+' || first == '-' || first == '/' || first == '*') {
+            return {TokenType::Operator, std::string(1, first)};
+        }
+        if ((first == '=' || first == '!' || first == '<' || first == '>') && currentChar == '=') {
+            std::string op = std::string(1, first) + "=";
+            advance();
+            return {TokenType::Operator, op};
+        }
+        return {TokenType::Operator, std::string(1, first)};
+    }
+
+public:
+    explicit Lexer(std::istream& in) : input(in), currentChar(' ') { advance(); }
+
+    Token nextToken() {
+        skipWhitespace();
+        if (std::isdigit(currentChar)) {
+            return readNumber();
+        }
+        if (std::isalpha(currentChar)) {
+            return readIdentifier();
+        }
+        if (currentChar == '=' || currentChar == '!' || currentChar == '<' || currentChar == '+' ||
+            currentChar == '-' || currentChar == '*' || currentChar == '/' || currentChar == '>') {
+            return readOperator();
+        }
+        if (std::string(";:{}(),").find(currentChar) != std::string::npos) {
+            char symbol = currentChar;
+            advance();
+            return {TokenType::Symbol, std::string(1, symbol)};
+        }
+        if (input.eof()) {
+            return {TokenType::EndOfFile, ""};
+        }
+        advance();
+        return nextToken();
+    }
+};
+
+struct Node {
+    virtual ~Node() = default;
+};
+
+struct Expression : Node {};
+struct Statement : Node {};
+
+struct Number : Expression {
+    int value;
+    explicit Number(int v) : value(v) {}
+};
+
+struct Variable : Expression {
+    std::string name;
+    explicit Variable(std::string n) : name(std::move(n)) {}
+};
+
+struct FunctionCall : Expression {
+    std::string name;
+    std::vector<std::unique_ptr<Expression>> args;
+    FunctionCall(std::string n, std::vector<std::unique_ptr<Expression>> a) : name(std::move(n)), args(std::move(a)) {}
+};
+
+/// BinaryExpression и Comparison исходного AST: оператор - строка.
+struct BinaryExpression : Expression {
+    std::string op;
+    std::unique_ptr<Expression> left, right;
+    BinaryExpression(std::string o, std::unique_ptr<Expression> l, std::unique_ptr<Expression> r) :
+        op(std::move(o)), left(std::move(l)), right(std::move(r)) {}
+};
+
+struct Parameter : Node {
+    std::string name;
+    explicit Parameter(std::string n) : name(std::move(n)) {}
+};
+
+struct StatementList : Statement {
+    std::vector<std::unique_ptr<Statement>> statements;
+};
+
+struct FunctionDeclaration : Node {
+    std::string name;
+    std::vector<std::unique_ptr<Parameter>> params;
+    std::unique_ptr<StatementList> body;
+    FunctionDeclaration(std::string n, std::vector<std::unique_ptr<Parameter>> p, std::unique_ptr<StatementList> b) :
+        name(std::move(n)), params(std::move(p)), body(std::move(b)) {}
+};
+
+struct ReturnStatement : Statement {
+    std::unique_ptr<Expression> expression;
+    explicit ReturnStatement(std::unique_ptr<Expression> e) : expression(std::move(e)) {}
+};
+
+struct Assignment : Statement {
+    std::string variable;
+    std::unique_ptr<Expression> expression;
+    Assignment(std::string v, std::unique_ptr<Expression> e) : variable(std::move(v)), expression(std::move(e)) {}
+};
+
+struct Declaration : Statement {
+    std::string varName;
+    explicit Declaration(std::string n) : varName(std::move(n)) {}
+};
+
+struct PrintStatement : Statement {
+    std::unique_ptr<Expression> expression;
+    explicit PrintStatement(std::unique_ptr<Expression> e) : expression(std::move(e)) {}
+};
+
+struct IfStatement : Statement {
+    std::unique_ptr<Expression> condition;
+    std::unique_ptr<Statement> thenBranch, elseBranch;
+    IfStatement(std::unique_ptr<Expression> c, std::unique_ptr<Statement> t, std::unique_ptr<Statement> e) :
+        condition(std::move(c)), thenBranch(std::move(t)), elseBranch(std::move(e)) {}
+};
+
+struct ProgramBlock : Node {
+    std::unique_ptr<Statement> statement;
+    std::unique_ptr<FunctionDeclaration> function;
+};
+
+struct ProgramBlocks : Node {
+    std::vector<std::unique_ptr<ProgramBlock>> blocks;
+};
+
+class Parser {
+    Lexer& lexer;
+    Token currentToken;
+
+    void advance() {
+        currentToken = lexer.nextToken();
+    }
+
+    void expect(const char* value, const char* message) {
+        if (currentToken.value != value) throw std::runtime_error(message);
+        advance();
+    }
+
+    std::unique_ptr<ProgramBlock> parseProgramBlock() {
+        auto block = std::make_unique<ProgramBlock>();
+        if (currentToken.value == "func") {
+            block->function = parseFunctionDeclaration();
+        } else {
+            block->statement = parseStatement();
+        }
+        return block;
+    }
+
+    std::unique_ptr<StatementList> parseStatementList() {
+        auto statements = std::make_unique<StatementList>();
+        while (currentToken.value != "}" && currentToken.type != TokenType::EndOfFile) {
+            statements->statements.push_back(parseStatement());
+        }
+        return statements;
+    }
+
+    std::unique_ptr<Statement> parseStatement() {
+        if (currentToken.value == "declare") return parseDeclaration();
+        if (currentToken.value == "if") return parseIfStatement();
+        if (currentToken.value == "print") return parsePrintStatement();
+        if (currentToken.value == "return") return parseReturnStatement();
+        if (currentToken.type == TokenType::Identifier) return parseAssignment();
+        throw std::runtime_error("Ожидался оператор");
+    }
+
+    void parseType() {
+        if (currentToken.type != TokenType::Keyword) throw std::runtime_error("Ожидался тип");
+        if (currentToken.value != "int") throw std::runtime_error("Неизвестный тип " + currentToken.value);
+        advance();
+    }
+
+    std::unique_ptr<FunctionDeclaration> parseFunctionDeclaration() {
+        advance();
+        if (currentToken.type != TokenType::Identifier)
+            throw std::runtime_error("Ожидался идентификатор после 'func'");
+        std::string funcName = currentToken.value;
+        advance();
+        expect("(", "Ожидался '(' после имени функции");
+        std::vector<std::unique_ptr<Parameter>> params;
+        while (currentToken.type == TokenType::Identifier) {
+            std::string paramName = currentToken.value;
+            advance();
+            expect(":", "Ожидался ':' после имени параметра");
+            parseType();
+            params.push_back(std::make_unique<Parameter>(paramName));
+            if (currentToken.value != ",") {
+                break;
+            }
+            advance();
+        }
+        expect(")", "Ожидался ')' после списка параметров");
+        expect(":", "Ожидался ':' после списка параметров и ')'");
+        parseType();
+        expect("{", "Ожидался '{' после типа функции");
+        auto body = parseStatementList();
+        expect("}", "Ожидался '}' в конце функции");
+        return std::make_unique<FunctionDeclaration>(funcName, std::move(params), std::move(body));
+    }
+
+    std::unique_ptr<Expression> parseFunctionCall() {
+        std::string funcName = currentToken.value;
+        advance();
+        if (currentToken.value != "(") {
+            throw std::runtime_error("Ожидался знак '(' вместо " + currentToken.value);
+        }
+        advance();
+        std::vector<std::unique_ptr<Expression>> args;
+        while (currentToken.value != ")") {
+            args.push_back(parseExpression());
+            if (currentToken.value != ",") {
+                break;
+            }
+            advance();
+        }
+        expect(")", "Ожидался знак ')'");
+        return std::make_unique<FunctionCall>(funcName, std::move(args));
+    }
+
+    std::unique_ptr<Statement> parseAssignment() {
+        std::string varName = currentToken.value;
+        advance();
+        if (currentToken.value != "=") throw std::runtime_error("Ожидался знак '=' вместо [ " + currentToken.value + "]");
+        advance();
+        auto expr = parseExpression();
+        expect(";", "Ожидалась ';'");
+        return std::make_unique<Assignment>(varName, std::move(expr));
+    }
+
+    std::unique_ptr<Statement> parsePrintStatement() {
+        advance();
+        expect("(", "Ожидалась '('");
+        auto expr = parseExpression();
+        expect(")", "parsePrintStatement(): Ожидалась ')'");
+        expect(";", "Ожидалась ';'");
+        return std::make_unique<PrintStatement>(std::move(expr));
+    }
+
+    std::unique_ptr<Statement> parseReturnStatement() {
+        advance();
+        auto expr = parseExpression();
+        expect(";", "Ожидалась ';'");
+        return std::make_unique<ReturnStatement>(std::move(expr));
+    }
+
+    std::unique_ptr<Statement> parseDeclaration() {
+        advance();
+        if (currentToken.type != TokenType::Identifier)
+            throw std::runtime_error("Ожидался идентификатор после 'declare'");
+        std::string varName = currentToken.value;
+        advance();
+        expect(":", "Ожидался ':' после имени переменной");
+        expect("int", "Ожидался тип 'int' после ':'");
+        expect(";", "Ожидалась ';' после объявления переменной");
+        return std::make_unique<Declaration>(varName);
+    }
+
+    std::unique_ptr<Statement> parseIfStatement() {
+        advance();
+        expect("(", "Ожидалась '(' после if");
+        auto condition = parseExpression();
+        expect(")", "parseIfStatement():Ожидалась ')' после условия");
+        expect("{", "Ожидалась '{' перед блоком if");
+        auto thenBody = parseStatementList();
+        expect("}", "Ожидалась '}' после блока if");
+        std::unique_ptr<StatementList> elseBody;
+        if (currentToken.value == "else") {
+            advance();
+            expect("{", "Ожидалась '{' перед блоком else");
+            elseBody = parseStatementList();
+            expect("}", "Ожидалась '}' после блока else");
+        }
+        return std::make_unique<IfStatement>(std::move(condition), std::move(thenBody), std::move(elseBody));
+    }
+
+    std::unique_ptr<Expression> parseExpression() {
+        auto left = parseSubAdd();
+        while (currentToken.value == "==" || currentToken.value == ">=" || currentToken.value == "!=" ||
+               currentToken.value == "<" || currentToken.value == ">" || currentToken.value == "<=") {
+            std::string op = currentToken.value;
+            advance();
+            auto right = parseSubAdd();
+            left = std::make_unique<BinaryExpression>(op, std::move(left), std::move(right));
+        }
+        return left;
+    }
+
+    std::unique_ptr<Expression> parseSubAdd() {
+        auto left = parseTerm();
+        while (currentToken.value == "+" || currentToken.value == "-") {
+            std::string op = currentToken.value;
+            advance();
+            auto right = parseTerm();
+            left = std::make_unique<BinaryExpression>(op, std::move(left), std::move(right));
+        }
+        return left;
+    }
+
+    std::unique_ptr<Expression> parseTerm() {
+        auto left = parseFactor();
+        while (currentToken.value == "*" || currentToken.value == "/") {
+            std::string op = currentToken.value;
+            advance();
+            auto right = parseFactor();
+            left = std::make_unique<BinaryExpression>(op, std::move(left), std::move(right));
+        }
+        return left;
+    }
+
+    std::unique_ptr<Expression> parseFactor() {
+        if (currentToken.type == TokenType::Number) {
+            int value = std::stoi(currentToken.value);
+            advance();
+            return std::make_unique<Number>(value);
+        }
+        if (currentToken.type == TokenType::Identifier) {
+            std::string name = currentToken.value;
+            // как в исходном парсере: переменная - это неудавшийся вызов
+            try {
+                return parseFunctionCall();
+            } catch (...) {
+            }
+            return std::make_unique<Variable>(name);
+        }
+        if (currentToken.value == "(") {
+            advance();
+            auto expr = parseExpression();
+            expect(")", "parseFactor(): Ожидалась ')'");
+            return expr;
+        }
+        throw std::runtime_error("Ожидалось выражение");
+    }
+
+public:
+    explicit Parser(Lexer& lex) : lexer(lex) { advance(); }
+
+    std::unique_ptr<ProgramBlocks> parse() {
+        auto blocks = std::make_unique<ProgramBlocks>();
+        while (currentToken.value != "}" && currentToken.type != TokenType::EndOfFile) {
+            blocks->blocks.push_back(parseProgramBlock());
+        }
+        return blocks;
+    }
+};
+
+} // namespace baseline
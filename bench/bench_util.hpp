@@ -0,0 +1,213 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+/// Общие утилиты бенчмарков: таймер и генераторы больших входных программ.
+namespace bench {
+
+/// Лучшее (минимальное) время из `reps` запусков `fn`, в секундах.
+template <class Fn>
+double BestOf(int reps, Fn&& fn) {
+    double best = 1e100;
+    for (int i = 0; i < reps; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+/// Программа из `functions` функций со всеми конструкциями языка;
+/// каждая функция вызывает предыдущую, main - последнюю.
+inline std::string MixedProgram(int functions) {
+    std::string code;
+    code.reserve(static_cast<size_t>(functions) * 320);
+    for (int i = 0; i < functions; ++i) {
+        std::string name = "func_" + std::to_string(i);
+        code += "func " + name + "(value_a: int, value_b: int):int {\n";
+        code += "    declare tmp: int;\n";
+        code += "    tmp = value_a * 3 + value_b - (value_a + 7) / 2;\n";
+        code += "    if (tmp >= value_a + value_b) {\n";
+        if (i > 0) {
+            code += "        tmp = func_" + std::to_string(i - 1) + "(tmp - 1, value_b);\n";
+        } else {
+            code += "        tmp = tmp * 2;\n";
+        }
+        code += "    } else {\n";
+        code += "        tmp = 11;\n";
+        code += "    }\n";
+        code += "    print(tmp);\n";
+        code += "    return tmp;\n";
+        code += "}\n\n";
+    }
+    code += "func main():int {\n";
+    code += "    declare x: int;\n";
+    code += "    x = func_" + std::to_string(functions > 0 ? functions - 1 : 0) + "(3, 4);\n";
+    code += "    return 0;\n";
+    code += "}\n";
+    return code;
+}
+
+/// Длинные арифметические выражения и сравнения над константами:
+/// нагрузка почти целиком ложится на разбор операторов.
+inline std::string ConstantExpressionProgram(int statements) {
+    std::string code = "func main():int {\n    declare x: int;\n";
+    code.reserve(static_cast<size_t>(statements) * 80);
+    for (int i = 0; i < statements; ++i) {
+        std::string n = std::to_string(i % 97 + 1);
+        code += "    x = " + n + " * 3 + 7 - (" + n + " + 2) / 5 * 4 - 1 + " + n + " <= 1000 + " + n + ";\n";
+    }
+    code += "    return 0;\n}\n";
+    return code;
+}
+
+/// Выражения, где почти каждый операнд - переменная.
+inline std::string VariableExpressionProgram(int statements) {
+    std::string code = "func main():int {\n    declare alpha: int;\n    declare beta: int;\n    declare gamma: int;\n";
+    code.reserve(static_cast<size_t>(statements) * 90);
+    for (int i = 0; i < statements; ++i) {
+        code += "    alpha = beta * gamma + alpha - (beta + gamma) / alpha * beta - gamma + alpha <= beta + gamma;\n";
+    }
+    code += "    return alpha;\n}\n";
+    return code;
+}
+
+/// Глубоко вложенные скобки, вложенные вызовы и длинные цепочки `a + b + ...`:
+/// проверяет, что разбор выражения не зависит от глубины рекурсии.
+/// `depth` подобран так, чтобы рекурсивный парсер тоже справлялся.
+inline std::string DeepExpressionProgram(int statements, int depth) {
+    std::string code = "func id(v: int):int {\n    return v;\n}\n\n";
+    code += "func main():int {\n    declare x: int;\n";
+    for (int i = 0; i < statements; ++i) {
+        switch (i % 3) {
+            case 0:
+                code += "    x = " + std::string(depth, '(') + "x";
+                for (int d = 0; d < depth; ++d) {
+                    code += d % 2 ? " * 2)" : " + 1)";
+                }
+                break;
+            case 1:
+                code += "    x = ";
+                for (int d = 0; d < depth; ++d) {
+                    code += "id(";
+                }
+                code += "x" + std::string(depth, ')');
+                break;
+            default:
+                code += "    x = x";
+                for (int d = 0; d < depth * 4; ++d) {
+                    code += d % 4 == 3 ? " * x" : " + x";
+                }
+                break;
+        }
+        code += ";\n";
+    }
+    code += "    return x;\n}\n";
+    return code;
+}
+
+/// Нагрузка на арифметику: рекурсивная цепочка глубины `depth`, на каждом
+/// уровне `statements` присваиваний с длинными выражениями; main повторяет
+/// цепочку `repeats` раз. Накопленное значение передаётся вниз параметром.
+inline std::string ArithmeticProgram(int depth, int statements, int repeats) {
+    std::string code = "func work(n: int, acc: int):int {\n    if (n > 0) {\n";
+    for (int i = 0; i < statements; ++i) {
+        code += "        acc = acc * 3 + n - (acc / 7) * 2 + " + std::to_string(i) + " - n * 2;\n";
+        code += "        flag = acc > n * 5 + 1;\n";
+    }
+    code += "        r = work(n - 1, acc);\n    } else {\n        r = acc;\n    }\n}\n\n";
+    code += "func main():int {\n    declare x: int;\n";
+    for (int i = 0; i < repeats; ++i) {
+        code += "    x = x + work(" + std::to_string(depth) + ", " + std::to_string(i) + ");\n";
+    }
+    code += "    return x;\n}\n";
+    return code;
+}
+
+/// Нагрузка на вызовы: почти пустое тело, вся работа - вызов и возврат.
+inline std::string CallProgram(int depth, int repeats) {
+    std::string code =
+        "func leaf(v: int):int {\n    v = v + 1;\n}\n\n"
+        "func count(n: int):int {\n"
+        "    if (n > 0) {\n        r = leaf(leaf(count(n - 1)));\n    } else {\n        r = 0;\n    }\n}\n\n"
+        "func main():int {\n    declare x: int;\n";
+    for (int i = 0; i < repeats; ++i) {
+        code += "    x = x + count(" + std::to_string(depth) + ");\n";
+    }
+    code += "    return x;\n}\n";
+    return code;
+}
+
+/// Много вызовов маленьких функций с return, которые стоят целым
+/// выражением присваивания: цель для встраивания на -O2.
+inline std::string SmallCallProgram(int depth, int repeats) {
+    std::string code =
+        "func wrap(v: int):int {\n"
+        "    if (v > 1000) {\n        v = v - 1000;\n    } else {\n        v = v + 3;\n    }\n    return v;\n}\n\n"
+        "func mix(a: int, b: int):int {\n    s = a * 2 + b;\n    return s - a;\n}\n\n"
+        "func step(n: int, acc: int):int {\n"
+        "    if (n > 0) {\n        acc = wrap(acc);\n        acc = mix(acc, n);\n        r = step(n - 1, acc);\n"
+        "    } else {\n        r = acc;\n    }\n}\n\n"
+        "func main():int {\n    declare x: int;\n";
+    for (int i = 0; i < repeats; ++i) {
+        code += "    x = x + step(" + std::to_string(depth) + ", " + std::to_string(i) + ");\n";
+    }
+    code += "    return x;\n}\n";
+    return code;
+}
+
+/// Рекурсивная функция, которую вызывают с константными коэффициентами:
+/// цель для специализации на -O2.
+inline std::string ConstantArgsProgram(int depth, int repeats) {
+    std::string code =
+        "func scaled(n: int, k: int, bias: int):int {\n"
+        "    if (n > 0) {\n"
+        "        r = scaled(n - 1, k, bias) + k * k * n + bias * k - k / 2 + (bias - k) * (k + 1);\n"
+        "    } else {\n        r = bias;\n    }\n}\n\n"
+        "func main():int {\n    declare x: int;\n";
+    for (int i = 0; i < repeats; ++i) {
+        code += "    x = x + scaled(" + std::to_string(depth) + ", " + std::to_string(2 + i % 3) + ", 7);\n";
+    }
+    code += "    return x;\n}\n";
+    return code;
+}
+
+/// Хвостовая рекурсия: `return step(...)` исполняется в одном кадре,
+/// а каждый уровень печатает "expression = v".
+inline std::string TailCallProgram(int depth, int repeats) {
+    std::string code =
+        "func step(n: int, acc: int):int {\n"
+        "    if (n > 0) {\n        return step(n - 1, acc + n - 3);\n    } else {\n        r = acc;\n    }\n}\n\n"
+        "func main():int {\n    declare x: int;\n";
+    for (int i = 0; i < repeats; ++i) {
+        code += "    x = x + step(" + std::to_string(depth) + ", " + std::to_string(i) + ");\n";
+    }
+    code += "    return x;\n}\n";
+    return code;
+}
+
+/// Рекурсия, которой нужны собственные кадры: в каждом вызове fib
+/// живут свои `n` и `r`.
+inline std::string RecursiveProgram(int n, int repeats) {
+    std::string code =
+        "func fib(n: int):int {\n"
+        "    if (n < 2) {\n        r = n;\n    } else {\n        r = fib(n - 1) + fib(n - 2);\n    }\n}\n\n"
+        "func main():int {\n    declare x: int;\n";
+    for (int i = 0; i < repeats; ++i) {
+        code += "    x = x + fib(" + std::to_string(n) + ");\n";
+    }
+    code += "    return x;\n}\n";
+    return code;
+}
+
+inline void Report(const char* name, size_t bytes, double seconds) {
+    std::printf("%-28s %10.3f ms  %9.1f MB/s\n",
+                name, seconds * 1e3, static_cast<double>(bytes) / seconds / 1e6);
+}
+
+} // namespace bench
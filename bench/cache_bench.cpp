@@ -0,0 +1,61 @@
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "bench_util.hpp"
+#include "parsing/ast.hpp"
+#include "parsing/ast_cache.hpp"
+#include "parsing/parser.hpp"
+#include "tokenization/tokenize.hpp"
+
+/// Загрузка из бинарного кэша против полного лексинга и разбора.
+/// Использование: cache_bench [число функций] [число повторов]
+int main(int argc, char** argv) {
+    int functions = argc > 1 ? std::atoi(argv[1]) : 20000;
+    int reps = argc > 2 ? std::atoi(argv[2]) : 5;
+    const std::string path = "cache_bench.astc";
+
+    std::string source = bench::MixedProgram(functions);
+    std::printf("mixed input: %d functions, %.2f MB\n", functions, source.size() / 1e6);
+
+    uint64_t hash = AstCache::HashSource(source);
+    {
+        FlatAst flat;
+        Lexer lexer(source);
+        Parser parser(lexer);
+        parser.parseFlat(flat);
+        AstCache::Store(path, hash, source.size(), flat);
+    }
+
+    double parseTime = bench::BestOf(reps, [&] {
+        Lexer lexer(source);
+        Parser parser(lexer);
+        auto tree = parser.parse();
+    });
+    bench::Report("lex+parse", source.size(), parseTime);
+
+    double hashTime = bench::BestOf(reps, [&] {
+        volatile uint64_t h = AstCache::HashSource(source);
+        (void)h;
+    });
+    bench::Report("hash source", source.size(), hashTime);
+
+    double loadTime = bench::BestOf(reps, [&] {
+        FlatAst flat;
+        if (!AstCache::Load(path, hash, source.size(), flat)) {
+            std::printf("cache miss\n");
+        }
+    });
+    bench::Report("load flat", source.size(), loadTime);
+
+    double expandTime = bench::BestOf(reps, [&] {
+        FlatAst flat;
+        AstCache::Load(path, hash, source.size(), flat);
+        auto tree = ExpandFlatAst(flat);
+    });
+    bench::Report("load + expand tree", source.size(), expandTime);
+
+    std::printf("speedup (hash + load + expand vs parse): %.1fx\n", parseTime / (hashTime + expandTime));
+    std::remove(path.c_str());
+    return 0;
+}
@@ -0,0 +1,58 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "bench_util.hpp"
+#include "parsing/parser.hpp"
+#include "tokenization/tokenize.hpp"
+#include "visitors/llvm_codegen_visitor.hpp"
+
+namespace {
+
+double Since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+/// Время построения LLVM IR и конвейера LLVM (verifyModule и проходы
+/// уровня -O0..-O3) на большом модуле, и сколько в нём инструкций до
+/// и после проходов.
+/// Использование: codegen_bench [число функций] [число повторов]
+int main(int argc, char** argv) {
+    int functions = argc > 1 ? std::atoi(argv[1]) : 5000;
+    int reps = argc > 2 ? std::atoi(argv[2]) : 3;
+
+    std::string source = bench::MixedProgram(functions);
+    Lexer lexer(source);
+    Parser parser(lexer);
+    auto tree = parser.parse();
+    std::printf("input: %d functions, %.2f MB\n", functions, source.size() / 1e6);
+
+    for (int level = 0; level <= 3; ++level) {
+        double codegen = 1e100;
+        double pipeline = 1e100;
+        size_t before = 0;
+        size_t after = 0;
+        for (int i = 0; i < reps; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            LLVMCodeGenVisitor llvmVisitor;
+            tree->Accept(&llvmVisitor);
+            codegen = std::min(codegen, Since(start));
+            before = llvmVisitor.instructionCount();
+
+            start = std::chrono::steady_clock::now();
+            std::string errors;
+            if (!llvmVisitor.optimize(level, false, errors)) {
+                std::printf("invalid module: %s\n", errors.c_str());
+                return 1;
+            }
+            pipeline = std::min(pipeline, Since(start));
+            after = llvmVisitor.instructionCount();
+        }
+        std::printf("-O%d  codegen %9.3f ms (%zu instructions)  pipeline %9.3f ms (%zu instructions)  total %9.3f ms\n",
+                    level, codegen * 1e3, before, pipeline * 1e3, after, (codegen + pipeline) * 1e3);
+    }
+    return 0;
+}
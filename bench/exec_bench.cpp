@@ -0,0 +1,178 @@
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "bench_util.hpp"
+#include "jit/program_jit.hpp"
+#include "jit/tiered_jit.hpp"
+#include "parsing/parser.hpp"
+#include "passes/pass_manager.hpp"
+#include "tokenization/tokenize.hpp"
+#include "visitors/flat_interpreter.hpp"
+#include "visitors/interpreter.hpp"
+#include "visitors/resolver.hpp"
+#include "vm/bytecode_compiler.hpp"
+#include "vm/vm.hpp"
+
+namespace {
+
+/// Вывод программы во время замера копится в памяти, а не идёт в терминал;
+/// заодно по нему сверяются движки.
+class CaptureOutput {
+public:
+    CaptureOutput() : saved_(std::cout.rdbuf(buffer_.rdbuf())) {}
+    ~CaptureOutput() { std::cout.rdbuf(saved_); }
+    std::string Text() const { return buffer_.str(); }
+
+private:
+    std::ostringstream buffer_;
+    std::streambuf* saved_;
+};
+
+/// Машинный код ProgramJit печатает через printf, мимо std::cout: на время
+/// замера stdout уходит в /dev/null.
+class DiscardStdout {
+public:
+    DiscardStdout() {
+        std::fflush(stdout);
+        saved_ = dup(STDOUT_FILENO);
+        int null = open("/dev/null", O_WRONLY);
+        dup2(null, STDOUT_FILENO);
+        close(null);
+    }
+    ~DiscardStdout() {
+        std::fflush(stdout);
+        dup2(saved_, STDOUT_FILENO);
+        close(saved_);
+    }
+
+private:
+    int saved_;
+};
+
+void Compare(const char* name, const std::string& source, int reps) {
+    Lexer lexer(source);
+    Parser parser(lexer);
+    auto tree = parser.parse();
+    Resolver().Resolve(tree.get());
+    std::printf("%s: %.1f KB of source\n", name, source.size() / 1e3);
+
+    std::string expected, actual;
+    double interpTime = bench::BestOf(reps, [&] {
+        CaptureOutput capture;
+        Interpreter interpreter;
+        tree->Accept(&interpreter);
+        expected = capture.Text();
+    });
+    std::printf("  %-26s %10.3f ms\n", "Interpreter", interpTime * 1e3);
+
+    Lexer optimizedLexer(source);
+    Parser optimizedParser(optimizedLexer);
+    auto optimized = optimizedParser.parse();
+    // на -O2 программа без ввода может вычислиться целиком во время компиляции,
+    // поэтому время проходов печатается рядом
+    double passTime = bench::BestOf(1, [&] {
+        PassManager::ForLevel(2).Run(optimized.get());
+    });
+    Resolver().Resolve(optimized.get());
+    std::string optimizedOutput;
+    double optimizedTime = bench::BestOf(reps, [&] {
+        CaptureOutput capture;
+        Interpreter interpreter;
+        optimized->Accept(&interpreter);
+        optimizedOutput = capture.Text();
+    });
+    std::printf("  %-26s %10.3f ms\n", "-O2 passes", passTime * 1e3);
+    std::printf("  %-26s %10.3f ms  %6.2fx\n", "Interpreter -O2", optimizedTime * 1e3, interpTime / optimizedTime);
+    if (optimizedOutput != expected) {
+        std::printf("  MISMATCH: -O2 output differs from Interpreter\n");
+    }
+
+    std::string memoizedOutput;
+    double memoizedTime = bench::BestOf(reps, [&] {
+        CaptureOutput capture;
+        Interpreter interpreter(true);
+        tree->Accept(&interpreter);
+        memoizedOutput = capture.Text();
+    });
+    std::printf("  %-26s %10.3f ms  %6.2fx\n", "Interpreter --memoize", memoizedTime * 1e3, interpTime / memoizedTime);
+    if (memoizedOutput != expected) {
+        std::printf("  MISMATCH: --memoize output differs from Interpreter\n");
+    }
+
+    // компиляция горячих функций входит в замер, как и при запуске
+    std::string tieredOutput;
+    double tieredTime = bench::BestOf(reps, [&] {
+        CaptureOutput capture;
+        TieredJit jit;
+        Interpreter interpreter(false, &jit);
+        tree->Accept(&interpreter);
+        tieredOutput = capture.Text();
+    });
+    std::printf("  %-26s %10.3f ms  %6.2fx\n", "Interpreter tiered", tieredTime * 1e3, interpTime / tieredTime);
+    if (tieredOutput != expected) {
+        std::printf("  MISMATCH: tiered output differs from Interpreter\n");
+    }
+
+    // компиляция всей программы входит в замер; вывод сверяет Check
+    std::string reason = ProgramJit::Check(tree.get());
+    if (reason.empty()) {
+        double jitTime = bench::BestOf(reps, [&] {
+            DiscardStdout discard;
+            ProgramJit jit;
+            jit.Run(tree.get(), 1, false);
+        });
+        std::printf("  %-26s %10.3f ms  %6.2fx\n", "ProgramJit", jitTime * 1e3, interpTime / jitTime);
+    } else {
+        std::printf("  %-26s runs in Interpreter: %s\n", "ProgramJit", reason.c_str());
+    }
+
+    FlatAst flat;
+    FlatAstBuilder builder(flat);
+    for (ProgramBlock* block : tree->blocks) {
+        builder.AddProgramBlock(block);
+    }
+    double flatTime = bench::BestOf(reps, [&] {
+        CaptureOutput capture;
+        FlatInterpreter(flat).Run();
+    });
+    std::printf("  %-26s %10.3f ms  %6.2fx\n", "FlatInterpreter", flatTime * 1e3, interpTime / flatTime);
+
+    BytecodeProgram bytecode;
+    double compileTime = bench::BestOf(reps, [&] {
+        bytecode = BytecodeCompiler().Compile(tree.get());
+    });
+    double vmTime = bench::BestOf(reps, [&] {
+        CaptureOutput capture;
+        Vm(bytecode).Run();
+        actual = capture.Text();
+    });
+    std::printf("  %-26s %10.3f ms  (%zu instructions)\n",
+                "bytecode compile", compileTime * 1e3, bytecode.code.size());
+    std::printf("  %-26s %10.3f ms  %6.2fx\n", "Vm", vmTime * 1e3, interpTime / vmTime);
+    if (actual != expected) {
+        std::printf("  MISMATCH: Vm output differs from Interpreter\n");
+    }
+}
+
+} // namespace
+
+/// Время исполнения одной и той же программы разными движками.
+/// Использование: exec_bench [масштаб] [число повторов]
+int main(int argc, char** argv) {
+    int scale = argc > 1 ? std::atoi(argv[1]) : 5;
+    int reps = argc > 2 ? std::atoi(argv[2]) : 5;
+
+    Compare("arithmetic-heavy", bench::ArithmeticProgram(1000, 8, 20 * scale), reps);
+    Compare("call-heavy", bench::CallProgram(1000, 100 * scale), reps);
+    Compare("small-calls", bench::SmallCallProgram(1000, 20 * scale), reps);
+    Compare("constant-args", bench::ConstantArgsProgram(1000, 20 * scale), reps);
+    Compare("tail-calls", bench::TailCallProgram(2000, 2 * scale), reps);
+    Compare("recursive", bench::RecursiveProgram(18 + scale / 5, scale), reps);
+    return 0;
+}
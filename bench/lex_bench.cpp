@@ -0,0 +1,55 @@
+#include <cstdlib>
+#include <string>
+
+#include "bench_util.hpp"
+#include "tokenization/char_scan.hpp"
+#include "tokenization/tokenize.hpp"
+
+/// Вход в стиле генераторов кода: глубокие отступы, длинные имена и числа.
+static std::string generatedStyleProgram(int statements) {
+    std::string indent(24, ' ');
+    std::string code = "func generated_entry_point_0001():int {\n" + indent + "declare accumulator_value_0001: int;\n";
+    for (int i = 0; i < statements; ++i) {
+        std::string n = std::to_string(1000000 + i);
+        code += indent + "accumulator_value_0001 = accumulator_value_0001 + " + n + " * generated_coefficient_" +
+                std::to_string(i % 13) + "_value   -   " + n + ";\n";
+    }
+    code += indent + "return 0;\n}\n";
+    return code;
+}
+
+/// Скорость лексера (байт/с) для каждой реализации классификации символов.
+/// Использование: lex_bench [размер входа] [число повторов]
+int main(int argc, char** argv) {
+    int size = argc > 1 ? std::atoi(argv[1]) : 20000;
+    int reps = argc > 2 ? std::atoi(argv[2]) : 7;
+
+    struct Input {
+        const char* name;
+        std::string source;
+    } inputs[] = {
+        {"mixed", bench::MixedProgram(size)},
+        {"generated-style", generatedStyleProgram(size * 4)},
+    };
+
+    charscan::ScanMode modes[] = {charscan::ScanMode::Scalar, charscan::ScanMode::SSE2, charscan::ScanMode::AVX2};
+    charscan::ScanMode best = charscan::BestSupportedMode();
+
+    for (const Input& input : inputs) {
+        std::printf("%s input: %.2f MB\n", input.name, input.source.size() / 1e6);
+        for (charscan::ScanMode mode : modes) {
+            charscan::SetMode(mode);
+            if (charscan::ActiveMode() != mode) {
+                continue;
+            }
+            double seconds = bench::BestOf(reps, [&] {
+                Lexer lexer(input.source);
+                while (lexer.nextToken().type != TokenType::EndOfFile) {
+                }
+            });
+            bench::Report(charscan::ModeName(mode), input.source.size(), seconds);
+        }
+    }
+    charscan::SetMode(best);
+    return 0;
+}
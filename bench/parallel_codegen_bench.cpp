@@ -0,0 +1,87 @@
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/FileSystem.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "bench_util.hpp"
+#include "parsing/parser.hpp"
+#include "tokenization/tokenize.hpp"
+#include "util/thread_pool.hpp"
+#include "visitors/llvm_codegen_visitor.hpp"
+#include "visitors/parallel_codegen.hpp"
+
+namespace {
+
+double Since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+/// Полное время от AST до объектных файлов (кодогенерация, проходы -O2,
+/// машинный код): один модуль против ParallelCodeGen на 1, 2, 4, 8
+/// потоках. Объектные файлы пишутся во временные и удаляются.
+/// Использование: parallel_codegen_bench [число функций] [число повторов]
+int main(int argc, char** argv) {
+    int functions = argc > 1 ? std::atoi(argv[1]) : 5000;
+    int reps = argc > 2 ? std::atoi(argv[2]) : 3;
+    const int level = 2;
+
+    std::string source = bench::MixedProgram(functions);
+    Lexer lexer(source);
+    Parser parser(lexer);
+    auto tree = parser.parse();
+    std::printf("input: %d functions, %.2f MB, -O%d\n", functions, source.size() / 1e6, level);
+
+    // частей не больше, чем потоков
+    std::vector<std::string> objects;
+    for (int i = 0; i < 8; ++i) {
+        llvm::SmallString<128> path;
+        llvm::sys::fs::createTemporaryFile("parallel_codegen_bench", "o", path);
+        objects.emplace_back(path);
+    }
+    auto emit = [&](size_t part, LLVMCodeGenVisitor& llvmVisitor, std::string& errors) {
+        return llvmVisitor.setHostTarget(level, errors) && llvmVisitor.optimize(level, false, errors) &&
+               llvmVisitor.emitNative(objects[part], false, errors);
+    };
+
+    double serial = 1e100;
+    for (int i = 0; i < reps; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        LLVMCodeGenVisitor llvmVisitor;
+        tree->Accept(&llvmVisitor);
+        std::string errors;
+        if (!emit(0, llvmVisitor, errors)) {
+            std::printf("serial: %s\n", errors.c_str());
+            return 1;
+        }
+        serial = std::min(serial, Since(start));
+    }
+    std::printf("one module         %9.3f ms\n", serial * 1e3);
+
+    for (size_t threads : {1, 2, 4, 8}) {
+        double best = 1e100;
+        size_t parts = 0;
+        for (int i = 0; i < reps; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            ThreadPool pool(threads);
+            ParallelCodeGen codegen(tree.get(), pool);
+            std::string errors = codegen.run(emit);
+            if (!errors.empty()) {
+                std::printf("%zu threads: %s\n", threads, errors.c_str());
+                return 1;
+            }
+            best = std::min(best, Since(start));
+            parts = codegen.parts();
+        }
+        std::printf("%zu threads, %zu parts %9.3f ms  (x%.2f)\n", threads, parts, best * 1e3, serial / best);
+    }
+    for (const std::string& path : objects) {
+        llvm::sys::fs::remove(path);
+    }
+    return 0;
+}
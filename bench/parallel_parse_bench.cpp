@@ -0,0 +1,46 @@
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+#include "bench_util.hpp"
+#include "parsing/parallel_parser.hpp"
+#include "parsing/parser.hpp"
+#include "tokenization/tokenize.hpp"
+#include "util/thread_pool.hpp"
+
+/// Ускорение параллельного разбора в зависимости от числа потоков.
+/// Использование: parallel_parse_bench [число функций] [число повторов] [макс. потоков]
+int main(int argc, char** argv) {
+    int functions = argc > 1 ? std::atoi(argv[1]) : 100000;
+    int reps = argc > 2 ? std::atoi(argv[2]) : 3;
+    size_t maxThreads = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 8;
+
+    std::string source = bench::MixedProgram(functions);
+    std::printf("mixed input: %d functions, %.2f MB, hardware threads: %u\n",
+                functions, source.size() / 1e6, std::thread::hardware_concurrency());
+
+    double serial = bench::BestOf(reps, [&] {
+        Lexer lexer(source);
+        Parser parser(lexer);
+        auto tree = parser.parse();
+    });
+    bench::Report("serial Parser", source.size(), serial);
+
+    double split = bench::BestOf(reps, [&] {
+        auto chunks = ParallelParser::splitTopLevel(source);
+    });
+    bench::Report("split only", source.size(), split);
+
+    for (size_t threads = 1; threads <= maxThreads; threads *= 2) {
+        ThreadPool pool(threads);
+        double time = bench::BestOf(reps, [&] {
+            auto tree = ParallelParser(source, pool).parse();
+        });
+        char name[32];
+        std::snprintf(name, sizeof(name), "parallel, %zu threads", threads);
+        bench::Report(name, source.size(), time);
+        std::printf("%-28s %10.2fx vs serial\n", "", serial / time);
+    }
+    return 0;
+}
@@ -0,0 +1,84 @@
+#include <cstdlib>
+#include <sstream>
+#include <string>
+
+#include "baseline_parser.hpp"
+#include "bench_util.hpp"
+#include "parsing/parser.hpp"
+#include "tokenization/tokenize.hpp"
+
+namespace {
+
+/// Время исходного парсера (baseline_parser.hpp) и текущего на одном
+/// входе и во сколько раз текущий быстрее.
+void CompareParse(const std::string& source, int reps) {
+    double baselineTime = bench::BestOf(reps, [&] {
+        std::istringstream input(source);
+        baseline::Lexer lexer(input);
+        baseline::Parser parser(lexer);
+        auto tree = parser.parse();
+    });
+    bench::Report("lex+parse baseline", source.size(), baselineTime);
+
+    double parseTime = bench::BestOf(reps, [&] {
+        Lexer lexer(source);
+        Parser parser(lexer);
+        auto tree = parser.parse();
+    });
+    bench::Report("lex+parse", source.size(), parseTime);
+    std::printf("%-28s %10.2fx\n", "speedup", baselineTime / parseTime);
+}
+
+} // namespace
+
+/// Пропускная способность лексера и парсера на больших сгенерированных
+/// входах: исходные строковые лексер и парсер против текущих.
+/// Использование: parse_bench [число функций] [число повторов]
+int main(int argc, char** argv) {
+    int functions = argc > 1 ? std::atoi(argv[1]) : 20000;
+    int reps = argc > 2 ? std::atoi(argv[2]) : 5;
+
+    std::string source = bench::MixedProgram(functions);
+    std::printf("mixed input: %d functions, %.2f MB\n", functions, source.size() / 1e6);
+
+    size_t baselineTokens = 0;
+    double baselineLexTime = bench::BestOf(reps, [&] {
+        std::istringstream input(source);
+        baseline::Lexer lexer(input);
+        baselineTokens = 0;
+        while (lexer.nextToken().type != baseline::TokenType::EndOfFile) {
+            ++baselineTokens;
+        }
+    });
+    bench::Report("lex baseline", source.size(), baselineLexTime);
+
+    size_t tokens = 0;
+    double lexTime = bench::BestOf(reps, [&] {
+        Lexer lexer(source);
+        tokens = 0;
+        while (lexer.nextToken().type != TokenType::EndOfFile) {
+            ++tokens;
+        }
+    });
+    bench::Report("lex", source.size(), lexTime);
+    std::printf("%-28s %10.2fx\n", "speedup", baselineLexTime / lexTime);
+    if (tokens != baselineTokens) {
+        std::printf("MISMATCH: %zu tokens, baseline %zu\n", tokens, baselineTokens);
+    }
+    std::printf("%-28s %10zu tokens\n", "", tokens);
+
+    CompareParse(source, reps);
+
+    std::string constants = bench::ConstantExpressionProgram(functions * 4);
+    std::printf("constant expressions: %.2f MB\n", constants.size() / 1e6);
+    CompareParse(constants, reps);
+
+    std::string variables = bench::VariableExpressionProgram(functions * 4);
+    std::printf("variable expressions: %.2f MB\n", variables.size() / 1e6);
+    CompareParse(variables, reps);
+
+    std::string deep = bench::DeepExpressionProgram(functions / 4, 200);
+    std::printf("deep expressions (depth 200): %.2f MB\n", deep.size() / 1e6);
+    CompareParse(deep, reps);
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include "native_check.hpp"
+
+#include "../passes/definite_reads.hpp"
+
+std::string NativeCheck::Check(FunctionDeclaration* func) {
+    DefiniteReads reads(definite_);
+    func->Accept(&reads);
+    for (size_t i = 0; i < func->params.size(); ++i) {
+        // у параметров с одинаковыми именами одна ячейка
+        if (func->params[i]->slot != i) {
+            return "repeated parameter name";
+        }
+        seen_.insert(func->params[i]->name);
+    }
+    func->body->Accept(this);
+    return reason_;
+}
+
+void NativeCheck::Visit(Assignment* assignment) {
+    AstWalker::Visit(assignment);
+    seen_.insert(assignment->variable);
+}
+
+void NativeCheck::Visit(Declaration* declaration) {
+    // без циклов всё, что может исполниться раньше, стоит выше по тексту
+    if (!seen_.insert(declaration->varName).second) {
+        Reject("declare of a variable that may already exist");
+    }
+}
+
+void NativeCheck::Visit(ReturnStatement* returnStatement) {
+    if (returnStatement->tailCall != nullptr) {
+        Reject("tail call");
+    }
+    AstWalker::Visit(returnStatement);
+}
+
+void NativeCheck::Visit(Variable* expression) {
+    if (definite_.count(expression) == 0) {
+        Reject("variable " + std::string(Interner::Global().Name(expression->name)) + " may be undefined");
+    }
+}
+
+void NativeCheck::Visit(BinaryExpression* expression) {
+    if (expression->op != "+" && expression->op != "-" && expression->op != "*" && expression->op != "/") {
+        Reject("unknown operator " + std::string(expression->op));
+    }
+    AstWalker::Visit(expression);
+}
+
+void NativeCheck::Visit(Comparison* expression) {
+    static const std::unordered_set<std::string_view> known = {"==", "!=", "<", ">", "<=", ">="};
+    if (known.count(expression->op) == 0) {
+        Reject("unknown operator " + std::string(expression->op));
+    }
+    AstWalker::Visit(expression);
+}
+
+void NativeCheck::Visit(FunctionCall* functionCall) {
+    AstWalker::Visit(functionCall);
+    std::string name(Interner::Global().Name(functionCall->name));
+    FunctionDeclaration* callee = functionCall->name < functions_.size() ? functions_[functionCall->name] : nullptr;
+    if (callee == nullptr) {
+        Reject("calls unknown function " + name);
+    } else if (callee->params.size() != functionCall->args.size()) {
+        Reject("wrong argument number for " + name);
+    } else {
+        callees_[functionCall] = callee;
+    }
+}
+
+void NativeCheck::Reject(std::string reason) {
+    if (reason_.empty()) {
+        reason_ = std::move(reason);
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "../parsing/ast.hpp"
+#include "../passes/ast_walker.hpp"
+
+/// Исполнится ли функция без ошибок Interpreter при любых аргументах
+/// (см. TieredJit и ProgramJit); заодно находит, кого вызывает каждый
+/// вызов. Нужны ячейки Resolver.
+class NativeCheck : public AstWalker {
+public:
+    /// `functions` - функции, известные Interpreter, по SymbolId.
+    NativeCheck(const std::vector<FunctionDeclaration*>& functions,
+                std::unordered_map<const FunctionCall*, FunctionDeclaration*>& callees) :
+        functions_(functions), callees_(callees) {}
+
+    /// Пустая строка, если функцию можно компилировать, иначе причина.
+    std::string Check(FunctionDeclaration* func);
+
+    void Visit(Assignment* assignment) override;
+    void Visit(Declaration* declaration) override;
+    void Visit(ReturnStatement* returnStatement) override;
+    void Visit(Variable* expression) override;
+    void Visit(BinaryExpression* expression) override;
+    void Visit(Comparison* expression) override;
+    void Visit(FunctionCall* functionCall) override;
+
+private:
+    void Reject(std::string reason);
+
+    const std::vector<FunctionDeclaration*>& functions_;
+    std::unordered_map<const FunctionCall*, FunctionDeclaration*>& callees_;
+    std::unordered_set<const Variable*> definite_;
+    std::unordered_set<SymbolId> seen_;         // параметры, присвоенные и объявленные выше
+    std::string reason_;
+};
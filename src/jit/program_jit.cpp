@@ -0,0 +1,168 @@
+#include "program_jit.hpp"
+
+#include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/Support/TargetSelect.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "native_check.hpp"
+#include "../visitors/llvm_codegen_visitor.hpp"
+
+namespace {
+
+void JitDivide(int left, int right) {
+    // Interpreter печатает через std::endl: всё, что напечатано до
+    // падения, должно дойти до вывода
+    std::fflush(stdout);
+    volatile int divisor = right;
+    volatile int quotient = left / divisor;
+    (void)quotient;
+    // INT_MIN / -1 падает не на всех процессорах
+    std::abort();
+}
+
+double Since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+std::string ProgramJit::Check(ProgramBlocks* blocks) {
+    // Interpreter регистрирует функции по порядку и исполняет main, как
+    // только до неё дойдёт: функции ниже main ей не видны
+    std::vector<FunctionDeclaration*> functions(Interner::Global().Size(), nullptr);
+    SymbolId mainId = Interner::Global().Intern("main");
+    FunctionDeclaration* main = nullptr;
+    for (ProgramBlock* block : blocks->blocks) {
+        FunctionDeclaration* func = block->function;
+        if (func == nullptr) {
+            continue;
+        }
+        if (func->name == mainId) {
+            if (main != nullptr) {
+                return "main is declared more than once";
+            }
+            main = func;
+        }
+        if (main == func || main == nullptr) {
+            if (functions.size() <= func->name) {
+                functions.resize(func->name + 1, nullptr);
+            }
+            if (functions[func->name] == nullptr) {
+                functions[func->name] = func;
+            }
+        }
+    }
+    if (main == nullptr) {
+        return "no main";
+    }
+    if (!main->params.empty()) {
+        return "main has parameters";
+    }
+
+    std::unordered_set<FunctionDeclaration*> checked = {main};
+    std::deque<FunctionDeclaration*> queue = {main};
+    while (!queue.empty()) {
+        FunctionDeclaration* func = queue.front();
+        queue.pop_front();
+        std::string name(Interner::Global().Name(func->name));
+        std::unordered_map<const FunctionCall*, FunctionDeclaration*> callees;
+        std::string reason = NativeCheck(functions, callees).Check(func);
+        if (!reason.empty()) {
+            return name + ": " + reason;
+        }
+        for (auto& [call, callee] : callees) {
+            if (checked.insert(callee).second) {
+                queue.push_back(callee);
+            }
+        }
+    }
+    return "";
+}
+
+bool ProgramJit::Run(ProgramBlocks* blocks, int optLevel, bool optSize) {
+    static std::once_flag targets;
+    std::call_once(targets, [] {
+        llvm::InitializeNativeTarget();
+        llvm::InitializeNativeTargetAsmPrinter();
+    });
+    auto start = std::chrono::steady_clock::now();
+    auto machine = llvm::orc::JITTargetMachineBuilder::detectHost();
+    if (!machine) {
+        error_ = llvm::toString(machine.takeError());
+        return false;
+    }
+    machine->setCodeGenOptLevel(LLVMCodeGenVisitor::codeGenLevel(optLevel));
+    auto jit = llvm::orc::LLJITBuilder().setJITTargetMachineBuilder(std::move(*machine)).create();
+    if (!jit) {
+        error_ = llvm::toString(jit.takeError());
+        return false;
+    }
+
+    llvm::orc::ThreadSafeModule module;
+    {
+        LLVMCodeGenVisitor codegen(/*forJit=*/true);
+        blocks->Accept(&codegen);
+        codegen_ms_ = Since(start);
+        start = std::chrono::steady_clock::now();
+        codegen.setTarget((*jit)->getTargetTriple(), (*jit)->getDataLayout());
+        if (!codegen.optimize(optLevel, optSize, error_)) {
+            return false;
+        }
+        module = codegen.takeModule();
+        optimize_ms_ = Since(start);
+    }
+
+    start = std::chrono::steady_clock::now();
+    llvm::orc::JITDylib& dylib = (*jit)->getMainJITDylib();
+    // printf и остальное из libc - из самого процесса
+    auto host = llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(
+        (*jit)->getDataLayout().getGlobalPrefix());
+    if (!host) {
+        error_ = llvm::toString(host.takeError());
+        return false;
+    }
+    dylib.addGenerator(std::move(*host));
+    llvm::orc::MangleAndInterner mangle((*jit)->getExecutionSession(), (*jit)->getDataLayout());
+    llvm::orc::SymbolMap runtime;
+    runtime[mangle(LLVMCodeGenVisitor::kDivideName)] = llvm::JITEvaluatedSymbol(
+        llvm::pointerToJITTargetAddress(&JitDivide), llvm::JITSymbolFlags::Exported);
+    llvm::Error error = dylib.define(llvm::orc::absoluteSymbols(std::move(runtime)));
+    if (!error) {
+        error = (*jit)->addIRModule(std::move(module));
+    }
+    // машинный код строится при первом поиске символа
+    llvm::Expected<llvm::JITEvaluatedSymbol> symbol =
+        error ? llvm::Expected<llvm::JITEvaluatedSymbol>(std::move(error)) : (*jit)->lookup("main");
+    if (!symbol) {
+        error_ = llvm::toString(symbol.takeError());
+        return false;
+    }
+    auto main = reinterpret_cast<int (*)()>(static_cast<uintptr_t>(symbol->getAddress()));
+    machine_ms_ = Since(start);
+
+    std::cout.flush();
+    start = std::chrono::steady_clock::now();
+    exit_code_ = main();
+    std::fflush(stdout);
+    run_ms_ = Since(start);
+    return true;
+}
+
+void ProgramJit::PrintReport(std::ostream& out) const {
+    char line[256];
+    std::snprintf(line, sizeof(line),
+                  "jit: compiled in %.3f ms (codegen %.3f ms, LLVM passes %.3f ms, machine code %.3f ms), "
+                  "ran in %.3f ms\n",
+                  codegen_ms_ + optimize_ms_ + machine_ms_, codegen_ms_, optimize_ms_, machine_ms_, run_ms_);
+    out << line;
+}
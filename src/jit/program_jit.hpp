@@ -0,0 +1,41 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+
+#include "../parsing/ast.hpp"
+
+/// Исполнение всей программы машинным кодом (--engine=jit): модуль
+/// LLVMCodeGenVisitor в режиме forJit проходит конвейер LLVM того же
+/// уровня, что и output.ll, загружается в ORC LLJIT, printf берётся из
+/// самого процесса, и вызывается main. Ни output.ll, ни clang не нужны.
+///
+/// Вывод совпадает с Interpreter, поэтому машинным кодом исполняются
+/// только программы, которые одобрил Check: функции, достижимые из main,
+/// проходят NativeCheck (как в TieredJit), а main одна и без параметров.
+/// Остальные исполняет Interpreter.
+class ProgramJit {
+public:
+    /// Пустая строка, если программа исполнится машинным кодом с тем же
+    /// выводом, что и в Interpreter, иначе причина. Нужны ячейки Resolver.
+    static std::string Check(ProgramBlocks* blocks);
+
+    /// Компилирует программу уровнем `optLevel` (`optSize` - -Os) и
+    /// исполняет main. false - модуль не собрался, причина в Error();
+    /// тогда ничего не напечатано.
+    bool Run(ProgramBlocks* blocks, int optLevel, bool optSize);
+
+    /// Результат main.
+    int ExitCode() const { return exit_code_; }
+    const std::string& Error() const { return error_; }
+    /// Сколько заняли кодогенерация, конвейер LLVM, машинный код и исполнение.
+    void PrintReport(std::ostream& out) const;
+
+private:
+    int exit_code_ = 0;
+    std::string error_;
+    double codegen_ms_ = 0;
+    double optimize_ms_ = 0;
+    double machine_ms_ = 0;
+    double run_ms_ = 0;
+};
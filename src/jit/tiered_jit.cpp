@@ -0,0 +1,174 @@
+#include "tiered_jit.hpp"
+
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <cstdio>
+#include <mutex>
+
+#include "native_check.hpp"
+#include "../visitors/interpreter.hpp"
+#include "../visitors/llvm_codegen_visitor.hpp"
+
+namespace {
+
+// функции Interpreter, которые зовёт машинный код (см. LLVMCodeGenVisitor::generateTier)
+void TierPrint(Interpreter* interpreter, int value) {
+    interpreter->PrintFromNative(value);
+}
+
+void TierEcho(Interpreter* interpreter, int value) {
+    interpreter->EchoFromNative(value);
+}
+
+int TierCall(Interpreter* interpreter, FunctionDeclaration* func, const int* args, int entry) {
+    return interpreter->CallFromNative(func, args, entry);
+}
+
+void TierDivide(int left, int right) {
+    // то же деление, что и в Interpreter, - с тем же падением
+    volatile int divisor = right;
+    volatile int quotient = left / divisor;
+    (void)quotient;
+}
+
+} // namespace
+
+TieredJit::TieredJit(uint64_t threshold) : threshold_(threshold), start_(std::chrono::steady_clock::now()) {
+    // имена после проходов уже в Interner: новых во время исполнения не бывает
+    size_ = Interner::Global().Size();
+    tiers_ = std::make_unique<Tier[]>(size_);
+    table_ = std::make_unique<NativeFunction[]>(size_);
+
+    static std::once_flag targets;
+    std::call_once(targets, [] {
+        llvm::InitializeNativeTarget();
+        llvm::InitializeNativeTargetAsmPrinter();
+    });
+    auto jit = llvm::orc::LLJITBuilder().create();
+    if (!jit) {
+        jit_error_ = llvm::toString(jit.takeError());
+        return;
+    }
+    jit_ = std::move(*jit);
+
+    llvm::orc::MangleAndInterner mangle(jit_->getExecutionSession(), jit_->getDataLayout());
+    auto symbol = [](auto* function) {
+        return llvm::JITEvaluatedSymbol(llvm::pointerToJITTargetAddress(function), llvm::JITSymbolFlags::Exported);
+    };
+    llvm::orc::SymbolMap runtime;
+    runtime[mangle(LLVMCodeGenVisitor::kTierPrintName)] = symbol(&TierPrint);
+    runtime[mangle(LLVMCodeGenVisitor::kTierEchoName)] = symbol(&TierEcho);
+    runtime[mangle(LLVMCodeGenVisitor::kTierCallName)] = symbol(&TierCall);
+    runtime[mangle(LLVMCodeGenVisitor::kDivideName)] = symbol(&TierDivide);
+    if (llvm::Error error = jit_->getMainJITDylib().define(llvm::orc::absoluteSymbols(std::move(runtime)))) {
+        jit_error_ = llvm::toString(std::move(error));
+        jit_.reset();
+    }
+}
+
+TieredJit::~TieredJit() = default;
+
+TieredJit::NativeFunction TieredJit::Promote(FunctionDeclaration* func, Tier& tier,
+                                             const std::vector<FunctionDeclaration*>& functions) {
+    switch (tier.state) {
+        case State::Cold:
+            tier.hotAt = Elapsed();
+            hot_.push_back(func);
+            Submit(func, tier, functions);
+            return nullptr;
+        case State::Compiling:
+            if (!tier.done.load(std::memory_order_acquire)) {
+                return nullptr;
+            }
+            if (tier.compiled == nullptr) {
+                tier.state = State::Interpreted;
+                return nullptr;
+            }
+            // с этого момента код видят и Interpreter, и другой машинный код
+            tier.state = State::Native;
+            tier.native = tier.compiled;
+            tier.nativeAt = Elapsed();
+            table_[func->name] = tier.native;
+            return tier.native;
+        default:
+            return nullptr;
+    }
+}
+
+void TieredJit::Submit(FunctionDeclaration* func, Tier& tier, const std::vector<FunctionDeclaration*>& functions) {
+    if (jit_ == nullptr) {
+        tier.state = State::Interpreted;
+        tier.reason = "JIT unavailable: " + jit_error_;
+        return;
+    }
+    // функции регистрируются до вызова и больше не меняются, поэтому
+    // вызовы разрешаются здесь, а фоновый поток только читает дерево
+    std::unordered_map<const FunctionCall*, FunctionDeclaration*> callees;
+    tier.reason = NativeCheck(functions, callees).Check(func);
+    if (!tier.reason.empty()) {
+        tier.state = State::Interpreted;
+        return;
+    }
+    tier.state = State::Compiling;
+    std::string name = "tier." + std::string(Interner::Global().Name(func->name));
+    tier.job = pool_.Submit([this, func, &tier, name = std::move(name), callees = std::move(callees)] {
+        Compile(func, tier, name, callees);
+    });
+}
+
+void TieredJit::Compile(FunctionDeclaration* func, Tier& tier, const std::string& name,
+                        const std::unordered_map<const FunctionCall*, FunctionDeclaration*>& callees) {
+    auto start = std::chrono::steady_clock::now();
+    LLVMCodeGenVisitor codegen;
+    codegen.setTarget(jit_->getTargetTriple(), jit_->getDataLayout());
+    codegen.generateTier(func, name, callees, table_.get());
+
+    std::string errors;
+    if (!codegen.optimize(2, false, errors)) {
+        tier.reason = "invalid IR: " + errors;
+        tier.done.store(true, std::memory_order_release);
+        return;
+    }
+
+    llvm::Error error = jit_->addIRModule(codegen.takeModule());
+    llvm::Expected<llvm::JITEvaluatedSymbol> symbol =
+        error ? llvm::Expected<llvm::JITEvaluatedSymbol>(std::move(error)) : jit_->lookup(name);
+    if (symbol) {
+        tier.compiled = reinterpret_cast<NativeFunction>(static_cast<uintptr_t>(symbol->getAddress()));
+    } else {
+        tier.reason = llvm::toString(symbol.takeError());
+    }
+    tier.compileMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    tier.done.store(true, std::memory_order_release);
+}
+
+void TieredJit::PrintReport(std::ostream& out) {
+    out << "tiered: " << hot_.size() << " functions reached " << threshold_ << " calls\n";
+    char line[256];
+    for (FunctionDeclaration* func : hot_) {
+        Tier& tier = tiers_[func->name];
+        if (tier.job.valid()) {
+            tier.job.wait();
+        }
+        std::string name(Interner::Global().Name(func->name));
+        std::snprintf(line, sizeof(line), "  %s: hot at %.3f ms, ", name.c_str(), tier.hotAt);
+        out << line;
+        if (tier.state == State::Native) {
+            std::snprintf(line, sizeof(line), "compiled in %.3f ms, native from %.3f ms after %llu interpreted calls\n",
+                          tier.compileMs, tier.nativeAt, static_cast<unsigned long long>(tier.calls));
+        } else if (tier.compiled != nullptr) {
+            std::snprintf(line, sizeof(line), "compiled in %.3f ms, not called afterwards\n", tier.compileMs);
+        } else {
+            std::snprintf(line, sizeof(line), "stays interpreted: ");
+            out << line << tier.reason << "\n";
+            continue;
+        }
+        out << line;
+    }
+}
+
+double TieredJit::Elapsed() const {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_).count();
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../parsing/ast.hpp"
+#include "../util/thread_pool.hpp"
+
+class Interpreter;
+
+namespace llvm::orc {
+class LLJIT;
+}
+
+/// Многоуровневое исполнение (--engine=tiered): Interpreter считает
+/// вызовы каждой функции, и функция, которую вызвали `threshold` раз,
+/// компилируется в фоновом потоке через ORC LLJIT (см.
+/// LLVMCodeGenVisitor::generateTier). Пока код не готов, функция
+/// исполняется обходом AST; дальше Interpreter вызывает машинный код,
+/// а тот - другие готовые функции напрямую и остальные через
+/// Interpreter. Вывод от этого не меняется.
+///
+/// Компилируются функции, которые исполняются без ошибок Interpreter
+/// при любых аргументах: каждое чтение переменной точно определено,
+/// declare не встречает существующую переменную, вызываемые функции
+/// найдены и получают верное число аргументов. Функции с хвостовыми
+/// вызовами остаются в Interpreter: там хвостовая рекурсия не растит
+/// стек, а в машинном коде после вызова ещё печатается "expression = v".
+class TieredJit {
+public:
+    /// Машинный код функции: аргументы подряд в `args`, `entry` -
+    /// "последнее значение" при входе.
+    using NativeFunction = int (*)(Interpreter* interpreter, const int* args, int entry);
+
+    static constexpr uint64_t kDefaultThreshold = 1000;
+
+    explicit TieredJit(uint64_t threshold = kDefaultThreshold);
+    ~TieredJit();
+
+    TieredJit(const TieredJit&) = delete;
+    TieredJit& operator=(const TieredJit&) = delete;
+
+    /// Считает вызов `func`; машинный код функции или nullptr, если его
+    /// пока нет. `functions` - функции Interpreter по SymbolId.
+    NativeFunction Enter(FunctionDeclaration* func, const std::vector<FunctionDeclaration*>& functions);
+
+    /// Какие функции стали горячими и когда перешли на машинный код.
+    /// Дожидается компиляций, которые ещё идут.
+    void PrintReport(std::ostream& out);
+
+private:
+    enum class State {
+        Cold,           // вызовов меньше порога
+        Compiling,      // в очереди или компилируется
+        Native,         // машинный код опубликован
+        Interpreted,    // не компилируется, reason - почему
+    };
+
+    struct Tier {
+        uint64_t calls = 0;
+        NativeFunction native = nullptr;     // опубликованный код
+        State state = State::Cold;
+        std::atomic<bool> done{false};      // фоновая компиляция закончилась
+        // пишет фоновый поток до done
+        NativeFunction compiled = nullptr;
+        std::string reason;
+        double compileMs = 0;
+        // пишет поток Interpreter
+        double hotAt = 0;                   // мс от старта, когда вызовов стало threshold
+        double nativeAt = 0;                // первый вызов машинного кода
+        std::future<void> job;
+    };
+
+    NativeFunction Promote(FunctionDeclaration* func, Tier& tier, const std::vector<FunctionDeclaration*>& functions);
+    /// Проверяет функцию и ставит её компиляцию в очередь.
+    void Submit(FunctionDeclaration* func, Tier& tier, const std::vector<FunctionDeclaration*>& functions);
+    /// Фоновая задача: строит, оптимизирует и загружает модуль `name`.
+    void Compile(FunctionDeclaration* func, Tier& tier, const std::string& name,
+                 const std::unordered_map<const FunctionCall*, FunctionDeclaration*>& callees);
+    double Elapsed() const;
+
+    uint64_t threshold_;
+    std::chrono::steady_clock::time_point start_;
+    std::unique_ptr<llvm::orc::LLJIT> jit_;
+    std::string jit_error_;
+    std::unique_ptr<Tier[]> tiers_;                 // индекс - SymbolId
+    std::unique_ptr<NativeFunction[]> table_;       // то же; его читает машинный код
+    size_t size_ = 0;
+    std::vector<FunctionDeclaration*> hot_;         // в порядке, в котором стали горячими
+    // последним: его деструктор дожидается задач, которые пользуются jit_
+    ThreadPool pool_{1};
+};
+
+inline TieredJit::NativeFunction TieredJit::Enter(FunctionDeclaration* func,
+                                                  const std::vector<FunctionDeclaration*>& functions) {
+    if (func->name >= size_) {
+        return nullptr;
+    }
+    Tier& tier = tiers_[func->name];
+    if (tier.native == nullptr && ++tier.calls >= threshold_) {
+        return Promote(func, tier, functions);
+    }
+    return tier.native;
+}
@@ -1,7 +1,9 @@
 #include <iostream>
 #include <string>
 #include <sstream>
+#include <stdexcept>
 #include <fstream>
+#include <vector>
 
 #include "parsing/ast.hpp"
 #include "parsing/parser.hpp"
@@ -9,13 +11,32 @@
 #include "program.hpp"
 
 int main(int argc, const char **argv) {
-    if (argc != 3) {
-        std::cout << "Wrong number of parameters: must be 2 - file to execute and file to print ast tree to.\n";
+    ProgramOptions options;
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.size() < 2 || arg[0] != '-') {
+            files.push_back(arg);
+        } else if (!options.Parse(arg)) {
+            std::cout << "Unknown option: " << arg << "\n" << ProgramOptions::Usage();
+            return 0;
+        }
+    }
+
+    if (files.size() != 2) {
+        std::cout << "Wrong number of parameters: must be 2 - file to execute and file to print ast tree to.\n"
+                  << ProgramOptions::Usage();
         return 0;
     }
 
-    std::string progname = argv[1];
-    std::string astname = argv[2];
-    Program prog(progname, astname);
-    prog.Run();
+    std::string progname = files[0];
+    std::string astname = files[1];
+    try {
+        Program prog(progname, astname, options);
+        return prog.Run();
+    } catch (const std::runtime_error& error) {
+        // например, исходник не открылся (SourceBuffer::FromFile)
+        std::cerr << error.what() << "\n";
+        return 1;
+    }
 }
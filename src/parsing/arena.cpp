@@ -0,0 +1,79 @@
+#include "arena.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+void Arena::Grow(size_t atLeast) {
+    size_t size = std::max(nextChunkSize_, atLeast + sizeof(Chunk));
+    nextChunkSize_ = std::min(nextChunkSize_ * 2, kMaxChunk);
+
+    Chunk* chunk = static_cast<Chunk*>(std::malloc(size));
+    if (chunk == nullptr) {
+        throw std::bad_alloc();
+    }
+    chunk->next = chunks_;
+    chunk->size = size;
+    chunks_ = chunk;
+    reserved_ += size;
+
+    cur_ = reinterpret_cast<char*>(chunk + 1);
+    end_ = reinterpret_cast<char*>(chunk) + size;
+}
+
+void Arena::Release() {
+    while (chunks_ != nullptr) {
+        Chunk* next = chunks_->next;
+        std::free(chunks_);
+        chunks_ = next;
+    }
+    cur_ = end_ = nullptr;
+    reserved_ = 0;
+    nextChunkSize_ = kMinChunk;
+}
+
+void Arena::Reset() {
+    if (chunks_ == nullptr) {
+        return;
+    }
+    // оставляем самый старый блок: он последний в списке
+    while (chunks_->next != nullptr) {
+        Chunk* next = chunks_->next;
+        std::free(chunks_);
+        chunks_ = next;
+    }
+    reserved_ = chunks_->size;
+    cur_ = reinterpret_cast<char*>(chunks_ + 1);
+    end_ = reinterpret_cast<char*>(chunks_) + chunks_->size;
+}
+
+void Arena::Absorb(Arena& other) {
+    if (other.chunks_ == nullptr) {
+        return;
+    }
+    // блоки другой арены вставляются за текущим, текущий блок остаётся активным
+    Chunk* last = other.chunks_;
+    while (last->next != nullptr) {
+        last = last->next;
+    }
+    if (chunks_ == nullptr) {
+        chunks_ = other.chunks_;
+        cur_ = other.cur_;
+        end_ = other.end_;
+    } else {
+        last->next = chunks_->next;
+        chunks_->next = other.chunks_;
+    }
+    reserved_ += other.reserved_;
+    other.chunks_ = nullptr;
+    other.cur_ = other.end_ = nullptr;
+    other.reserved_ = 0;
+    other.nextChunkSize_ = kMinChunk;
+}
+
+size_t Arena::ChunkCount() const {
+    size_t count = 0;
+    for (Chunk* chunk = chunks_; chunk != nullptr; chunk = chunk->next) {
+        ++count;
+    }
+    return count;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <utility>
+
+/// Непрерывный массив узлов, выделенный в арене. Владения нет:
+/// память принадлежит арене, деструкторы элементов не вызываются.
+template <class T>
+class NodeList {
+public:
+    NodeList() = default;
+    NodeList(T* data, uint32_t size) : data_(data), size_(size) {}
+
+    T* begin() const { return data_; }
+    T* end() const { return data_ + size_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    T& operator[](size_t i) const { return data_[i]; }
+
+private:
+    T* data_ = nullptr;
+    uint32_t size_ = 0;
+};
+
+/// Арена для узлов AST: выделение - сдвиг указателя, освобождение всего
+/// дерева - возврат нескольких больших блоков. Деструкторы узлов не
+/// вызываются, поэтому узлы хранят только тривиально разрушаемые поля
+/// (указатели в ту же арену, NodeList, SymbolId, числа).
+class Arena {
+public:
+    Arena() = default;
+    ~Arena() { Release(); }
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* Allocate(size_t size, size_t align) {
+        uintptr_t aligned = (reinterpret_cast<uintptr_t>(cur_) + align - 1) & ~(uintptr_t)(align - 1);
+        if (cur_ == nullptr || aligned + size > reinterpret_cast<uintptr_t>(end_)) {
+            Grow(size + align);
+            aligned = (reinterpret_cast<uintptr_t>(cur_) + align - 1) & ~(uintptr_t)(align - 1);
+        }
+        cur_ = reinterpret_cast<char*>(aligned + size);
+        return reinterpret_cast<void*>(aligned);
+    }
+
+    template <class T, class... Args>
+    T* Make(Args&&... args) {
+        return new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    template <class T>
+    NodeList<T> MakeList(const T* items, size_t count) {
+        if (count == 0) {
+            return {};
+        }
+        T* data = static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+        std::memcpy(static_cast<void*>(data), items, sizeof(T) * count);
+        return NodeList<T>(data, static_cast<uint32_t>(count));
+    }
+
+    /// Освобождает все блоки, кроме первого, - арену можно переиспользовать.
+    void Reset();
+
+    /// Забирает блоки другой арены (она становится пустой); узлы остаются на месте.
+    void Absorb(Arena& other);
+
+    size_t BytesReserved() const { return reserved_; }
+    size_t ChunkCount() const;
+
+private:
+    struct Chunk {
+        Chunk* next;
+        size_t size;
+    };
+
+    static constexpr size_t kMinChunk = 64 * 1024;
+    static constexpr size_t kMaxChunk = 4 * 1024 * 1024;
+
+    void Grow(size_t atLeast);
+    void Release();
+
+    Chunk* chunks_ = nullptr;   // последний выделенный блок - первый в списке
+    char* cur_ = nullptr;
+    char* end_ = nullptr;
+    size_t nextChunkSize_ = kMinChunk;
+    size_t reserved_ = 0;
+};
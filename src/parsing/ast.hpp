@@ -6,10 +6,18 @@
 #include <vector>
 #include <fstream>
 #include <map>
+#include "../tokenization/interner.hpp"
+#include "arena.hpp"
 #include "../visitors/visitor.hpp"
 // #include "../visitors/interpreter.hpp"
 #include "../visitors/print_visitor.hpp"
 
+/// Номер ячейки в кадре функции, который назначает Resolver;
+/// kNoSlot - имя не объявлено и не присваивается в этой функции.
+constexpr uint32_t kNoSlot = UINT32_MAX;
+
+/// Все узлы живут в арене ProgramBlocks и никогда не разрушаются по одному,
+/// поэтому поля узлов - только указатели, NodeList и тривиальные значения.
 class ASTNode { 
 public: 
     virtual ~ASTNode() = default; 
@@ -30,10 +38,13 @@ public:
 
 class FunctionCall : public Expression {
     public:
-    std::string name;
-    std::vector<std::unique_ptr<Expression>> args;
-    FunctionCall(std::string name, std::vector<std::unique_ptr<Expression>> args) :
-        name(name), args(std::move(args)) {}
+    SymbolId name;
+    NodeList<Expression*> args;
+    /// Заполняет Interpreter при первом успешном вызове: функция найдена
+    /// и число аргументов совпало, повторно это не проверяется.
+    FunctionDeclaration* target = nullptr;
+    FunctionCall(SymbolId name, NodeList<Expression*> args) :
+        name(name), args(args) {}
     void Accept (Visitor* visitor) override {
         visitor->Visit(this);
     }
@@ -51,28 +62,29 @@ public:
 
 class Variable : public Expression {
 public:
-    std::string name;
-    explicit Variable(std::string n) : name(std::move(n)) {}
+    SymbolId name;
+    uint32_t slot = kNoSlot;
+    explicit Variable(SymbolId n) : name(n) {}
     void Accept (Visitor* visitor) override {
         visitor->Visit(this);
     }
 };
 class BinaryExpression : public Expression {
 public:
-    std::string op;
-    std::unique_ptr<Expression> left, right;
-    BinaryExpression(std::string o, std::unique_ptr<Expression> l, std::unique_ptr<Expression> r)
-        : op(std::move(o)), left(std::move(l)), right(std::move(r)) {}
+    std::string_view op;    // статическое написание, см. TokenSpelling
+    Expression *left, *right;
+    BinaryExpression(std::string_view o, Expression* l, Expression* r)
+        : op(o), left(l), right(r) {}
     void Accept (Visitor* visitor) override {
         visitor->Visit(this);
     }
 };
 class Comparison : public Expression {
 public:
-    std::unique_ptr<Expression> left, right;
-    std::string op;
-    Comparison(std::string o, std::unique_ptr<Expression> l, std::unique_ptr<Expression> r)
-        : left(std::move(l)), op(std::move(o)), right(std::move(r)) {}
+    Expression *left, *right;
+    std::string_view op;    // статическое написание, см. TokenSpelling
+    Comparison(std::string_view o, Expression* l, Expression* r)
+        : left(l), op(o), right(r) {}
     void Accept (Visitor* visitor) override {
         visitor->Visit(this);
     }
@@ -98,12 +110,13 @@ public:
 
 class Parameter : public ASTNode {
 public: 
-    std::string name;
-    std::unique_ptr<Type> type;
-    Parameter(std::string nm, 
-        std::unique_ptr<Type> tp) :
+    SymbolId name;
+    Type* type;
+    uint32_t slot = kNoSlot;
+    Parameter(SymbolId nm, 
+        Type* tp) :
         name(nm),
-         type(std::move(tp)) {}
+         type(tp) {}
     void Accept (Visitor* visitor) override {
         visitor->Visit(this);
     }
@@ -113,12 +126,13 @@ public:
 
 class FunctionDeclaration : public ASTNode {
     public:
-    std::string name;
-    std::vector<std::unique_ptr<Parameter>> params;
-    std::unique_ptr<StatementList> body;
-    std::unique_ptr<Type> returnType;
-    FunctionDeclaration(std::string name, std::vector<std::unique_ptr<Parameter>> params, std::unique_ptr<StatementList> body, std::unique_ptr<Type> returnTp) :
-        name(name), params(std::move(params)), body(std::move(body)), returnType(std::move(returnTp)) {}
+    SymbolId name;
+    NodeList<Parameter*> params;
+    StatementList* body;
+    Type* returnType;
+    uint32_t frameSize = 0;     // число ячеек кадра (параметры и локальные), см. Resolver
+    FunctionDeclaration(SymbolId name, NodeList<Parameter*> params, StatementList* body, Type* returnTp) :
+        name(name), params(params), body(body), returnType(returnTp) {}
     void Accept (Visitor* visitor) override {
         visitor->Visit(this);
     }
@@ -130,9 +144,11 @@ class Statement : public ASTNode {};
 
 class ReturnStatement : public Statement {
     public:
-    std::unique_ptr<Expression> expression;
-    ReturnStatement(std::unique_ptr<Expression> expr) :
-        expression(std::move(expr)) {}
+    Expression* expression;
+    /// Заполняет Resolver: `expression` - сам вызов функции (хвостовой вызов).
+    FunctionCall* tailCall = nullptr;
+    ReturnStatement(Expression* expr) :
+        expression(expr) {}
     void Accept (Visitor* visitor) override {
         visitor->Visit(this);
     }
@@ -142,27 +158,33 @@ class ReturnStatement : public Statement {
 
 class Assignment : public Statement {
 public:
-    std::string variable;
-    std::unique_ptr<Expression> expression;
-    Assignment(std::string var, std::unique_ptr<Expression> expr)
-        : variable(std::move(var)), expression(std::move(expr)) {}
+    SymbolId variable;
+    Expression* expression;
+    uint32_t slot = kNoSlot;
+    /// Присваивание стоит на месте `return e` встроенной функции (см. Inliner):
+    /// интерпретаторы печатают "expression = <значение>", как return,
+    /// но из функции не выходят.
+    bool inlinedReturn = false;
+    Assignment(SymbolId var, Expression* expr)
+        : variable(var), expression(expr) {}
     void Accept (Visitor* visitor) override {
         visitor->Visit(this);
     }
 };
 class Declaration : public Statement {
 public:
-    std::string varName;
-    Declaration(std::string name) : varName(name) {}
+    SymbolId varName;
+    uint32_t slot = kNoSlot;
+    Declaration(SymbolId name) : varName(name) {}
     void Accept (Visitor* visitor) override {
         visitor->Visit(this);
     }
 };
 class PrintStatement : public Statement {
 public:
-    std::unique_ptr<Expression> expression;
-    explicit PrintStatement(std::unique_ptr<Expression> expr) :
-         expression(std::move(expr)) {}
+    Expression* expression;
+    explicit PrintStatement(Expression* expr) :
+         expression(expr) {}
     void Accept (Visitor* visitor) override {
         visitor->Visit(this);
     }
@@ -170,12 +192,12 @@ public:
 
 class IfStatement : public Statement {
 public:
-    std::unique_ptr<Expression> condition;
-    std::unique_ptr<Statement> thenBranch;
-    std::unique_ptr<Statement> elseBranch;
+    Expression* condition;
+    Statement* thenBranch;
+    Statement* elseBranch;
 
-    IfStatement(std::unique_ptr<Expression> cond, std::unique_ptr<Statement> thenB, std::unique_ptr<Statement> elseB = nullptr)
-        : condition(std::move(cond)), thenBranch(std::move(thenB)), elseBranch(std::move(elseB)) {}
+    IfStatement(Expression* cond, Statement* thenB, Statement* elseB = nullptr)
+        : condition(cond), thenBranch(thenB), elseBranch(elseB) {}
     void Accept (Visitor* visitor) override {
         visitor->Visit(this);
     }
@@ -183,7 +205,9 @@ public:
 
 class StatementList : public Statement {
 public:
-    std::vector<std::unique_ptr<Statement>> statements;
+    NodeList<Statement*> statements;
+    StatementList() = default;
+    explicit StatementList(NodeList<Statement*> stmnts) : statements(stmnts) {}
     void Accept (Visitor* visitor) override {
         visitor->Visit(this);
     }
@@ -192,29 +216,32 @@ public:
 
 class ProgramBlock : public ASTNode {
 public:
-    std::unique_ptr<Statement> statement = nullptr;
-    std::unique_ptr<FunctionDeclaration> function = nullptr;
-    ProgramBlock(std::unique_ptr<Statement> sttmnt) :
-        statement(std::move(sttmnt)) {}
-    ProgramBlock(std::unique_ptr<FunctionDeclaration> func) :
-        function(std::move(func)) {}
-    ProgramBlock(std::unique_ptr<Statement> sttmnt, std::unique_ptr<FunctionDeclaration> func) :
-        statement(std::move(sttmnt)), function(std::move(func)) {}
+    Statement* statement = nullptr;
+    FunctionDeclaration* function = nullptr;
+    ProgramBlock(Statement* sttmnt) :
+        statement(sttmnt) {}
+    ProgramBlock(FunctionDeclaration* func) :
+        function(func) {}
+    ProgramBlock(Statement* sttmnt, FunctionDeclaration* func) :
+        statement(sttmnt), function(func) {}
 
     void Accept (Visitor* visitor) override {
         if (statement != nullptr) {
-            visitor->Visit(statement.get());
+            visitor->Visit(statement);
         } else {
-            visitor->Visit(function.get());
+            visitor->Visit(function);
         }
     }   
     ProgramBlock(ProgramBlock&&) = default;
 
 };
 
+/// Корень дерева: владеет ареной, в которой лежат все остальные узлы,
+/// поэтому разрушение дерева - освобождение нескольких блоков арены.
 class ProgramBlocks : public ASTNode {
 public:
-    std::vector<std::unique_ptr<ProgramBlock>> blocks;
+    Arena arena;
+    NodeList<ProgramBlock*> blocks;
     void Accept (Visitor* visitor) override {
         visitor->Visit(this);
     }
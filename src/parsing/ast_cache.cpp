@@ -0,0 +1,344 @@
+#include "ast_cache.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "../tokenization/interner.hpp"
+#include "../tokenization/source_buffer.hpp"
+
+namespace {
+
+constexpr char kMagic[8] = {'M', 'C', 'A', 'S', 'T', 'C', '\0', '\0'};
+// 2: stmtC у Assign - флаг Assignment::inlinedReturn
+constexpr uint32_t kVersion = 2;
+
+struct AstCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t nameCount;
+    uint64_t sourceHash;
+    uint64_t sourceSize;
+    uint64_t nameBytes;
+    uint32_t exprCount;
+    uint32_t stmtCount;
+    uint32_t blockCount;
+    uint32_t refCount;
+    uint32_t functionCount;
+    uint32_t itemCount;
+};
+
+size_t AlignUp(size_t offset) {
+    return (offset + 7) & ~size_t(7);
+}
+
+class Writer {
+public:
+    template <class T>
+    void Put(const T* data, size_t count) {
+        bytes.append(reinterpret_cast<const char*>(data), sizeof(T) * count);
+        bytes.resize(AlignUp(bytes.size()), '\0');
+    }
+
+    std::string bytes;
+};
+
+class Reader {
+public:
+    Reader(const char* data, size_t size) : data(data), size(size) {}
+
+    template <class T>
+    bool Get(T* out, size_t count) {
+        size_t bytes = sizeof(T) * count;
+        if (bytes > size - offset) {
+            return false;
+        }
+        if (bytes != 0) {
+            std::memcpy(static_cast<void*>(out), data + offset, bytes);
+        }
+        offset = AlignUp(offset + bytes);
+        if (offset > size) {
+            offset = size;
+        }
+        return true;
+    }
+
+    template <class T>
+    bool Get(std::vector<T>& out, size_t count) {
+        if (count > (size - offset) / sizeof(T)) {
+            return false;   // не выделяем память под заведомо обрезанный файл
+        }
+        out.resize(count);
+        return Get(out.data(), count);
+    }
+
+    const char* Take(size_t bytes) {
+        if (bytes > size - offset) {
+            return nullptr;
+        }
+        const char* start = data + offset;
+        offset = std::min(AlignUp(offset + bytes), size);
+        return start;
+    }
+
+    bool AtEnd() const { return offset == size; }
+
+private:
+    const char* data;
+    size_t size;
+    size_t offset = 0;
+};
+
+/// Проверяет, что все индексы в массивах в границах и дети стоят раньше
+/// родителей (на это опирается ExpandFlatAst), - повреждённый кэш
+/// отбрасывается, а не роняет компилятор.
+bool Validate(const FlatAst& ast, uint32_t nameCount) {
+    const uint32_t exprCount = static_cast<uint32_t>(ast.exprKind.size());
+    const uint32_t stmtCount = static_cast<uint32_t>(ast.stmtKind.size());
+    const uint32_t blockCount = static_cast<uint32_t>(ast.blockBegin.size());
+    const uint64_t refCount = ast.refs.size();
+
+    for (uint32_t i = 0; i < exprCount; ++i) {
+        uint32_t a = ast.exprA[i];
+        uint32_t b = ast.exprB[i];
+        switch (ast.exprKind[i]) {
+            case FlatExprKind::Number:
+                break;
+            case FlatExprKind::Variable:
+                if (a >= nameCount) return false;
+                break;
+            case FlatExprKind::Binary:
+                if (a >= i || b >= i || ast.exprOp[i] > static_cast<uint8_t>(BinaryOp::Div)) return false;
+                break;
+            case FlatExprKind::Compare:
+                if (a >= i || b >= i || ast.exprOp[i] > static_cast<uint8_t>(CompareOp::Ge)) return false;
+                break;
+            case FlatExprKind::Call: {
+                if (a >= nameCount || b >= refCount || b + 1 + uint64_t(ast.refs[b]) > refCount) return false;
+                for (uint32_t arg = 0; arg < ast.refs[b]; ++arg) {
+                    if (ast.refs[b + 1 + arg] >= i) return false;
+                }
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+
+    for (uint32_t i = 0; i < blockCount; ++i) {
+        if (uint64_t(ast.blockBegin[i]) + ast.blockSize[i] > refCount) return false;
+        for (uint32_t j = 0; j < ast.blockSize[i]; ++j) {
+            if (ast.BlockStmt(i, j) >= stmtCount) return false;
+        }
+    }
+
+    auto blockBefore = [&](FlatRef block, uint32_t stmt) {
+        if (block >= blockCount) return false;
+        for (uint32_t j = 0; j < ast.blockSize[block]; ++j) {
+            if (ast.BlockStmt(block, j) >= stmt) return false;
+        }
+        return true;
+    };
+
+    for (uint32_t i = 0; i < stmtCount; ++i) {
+        uint32_t a = ast.stmtA[i];
+        switch (ast.stmtKind[i]) {
+            case FlatStmtKind::Declare:
+                if (a >= nameCount) return false;
+                break;
+            case FlatStmtKind::Assign:
+                if (a >= nameCount || ast.stmtB[i] >= exprCount) return false;
+                break;
+            case FlatStmtKind::Print:
+            case FlatStmtKind::Return:
+                if (a >= exprCount) return false;
+                break;
+            case FlatStmtKind::If:
+                if (a >= exprCount || !blockBefore(ast.stmtB[i], i)) return false;
+                if (ast.stmtC[i] != kNoFlatRef && !blockBefore(ast.stmtC[i], i)) return false;
+                break;
+            default:
+                return false;
+        }
+    }
+
+    for (const FlatFunction& func : ast.functions) {
+        if (func.name >= nameCount || func.body >= blockCount) return false;
+        if (uint64_t(func.params) + func.paramCount > refCount) return false;
+        for (uint32_t i = 0; i < func.paramCount; ++i) {
+            if (ast.FunctionParam(func, i) >= nameCount) return false;
+        }
+    }
+
+    for (const FlatItem& item : ast.items) {
+        if (item.ref >= (item.isFunction ? ast.functions.size() : size_t(stmtCount))) return false;
+    }
+    return true;
+}
+
+/// Переводит номера имён из файла в номера Interner::Global() этого процесса.
+void RemapSymbols(FlatAst& ast, const std::vector<SymbolId>& remap) {
+    for (size_t i = 0; i < ast.exprKind.size(); ++i) {
+        if (ast.exprKind[i] == FlatExprKind::Variable || ast.exprKind[i] == FlatExprKind::Call) {
+            ast.exprA[i] = remap[ast.exprA[i]];
+        }
+    }
+    for (size_t i = 0; i < ast.stmtKind.size(); ++i) {
+        if (ast.stmtKind[i] == FlatStmtKind::Declare || ast.stmtKind[i] == FlatStmtKind::Assign) {
+            ast.stmtA[i] = remap[ast.stmtA[i]];
+        }
+    }
+    for (FlatFunction& func : ast.functions) {
+        func.name = remap[func.name];
+        for (uint32_t i = 0; i < func.paramCount; ++i) {
+            ast.refs[func.params + i] = remap[ast.refs[func.params + i]];
+        }
+    }
+}
+
+} // namespace
+
+uint64_t AstCache::HashSource(std::string_view source) {
+    uint64_t hash = 14695981039346656037ull;
+    const char* p = source.data();
+    const char* end = p + source.size();
+    for (; end - p >= 8; p += 8) {
+        uint64_t word;
+        std::memcpy(&word, p, sizeof(word));
+        hash ^= word;
+        hash *= 1099511628211ull;
+        hash ^= hash >> 29;
+    }
+    for (; p < end; ++p) {
+        hash ^= static_cast<unsigned char>(*p);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+bool AstCache::Load(const std::string& path, uint64_t sourceHash, uint64_t sourceSize, FlatAst& out) {
+    SourceBuffer file;
+    try {
+        file = SourceBuffer::FromFile(path);
+    } catch (const std::runtime_error&) {
+        return false;
+    }
+
+    Reader reader(file.Data(), file.Size());
+    AstCacheHeader header;
+    if (!reader.Get(&header, 1) || std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+        header.version != kVersion || header.sourceHash != sourceHash || header.sourceSize != sourceSize) {
+        return false;
+    }
+
+    std::vector<uint32_t> lengths;
+    if (!reader.Get(lengths, header.nameCount)) {
+        return false;
+    }
+    const char* names = reader.Take(header.nameBytes);
+    if (names == nullptr) {
+        return false;
+    }
+
+    FlatAst ast;
+    std::vector<uint32_t> items;
+    bool ok = reader.Get(ast.exprKind, header.exprCount) && reader.Get(ast.exprOp, header.exprCount) &&
+              reader.Get(ast.exprA, header.exprCount) && reader.Get(ast.exprB, header.exprCount) &&
+              reader.Get(ast.stmtKind, header.stmtCount) && reader.Get(ast.stmtA, header.stmtCount) &&
+              reader.Get(ast.stmtB, header.stmtCount) && reader.Get(ast.stmtC, header.stmtCount) &&
+              reader.Get(ast.blockBegin, header.blockCount) && reader.Get(ast.blockSize, header.blockCount) &&
+              reader.Get(ast.refs, header.refCount) && reader.Get(ast.functions, header.functionCount) &&
+              reader.Get(items, uint64_t(header.itemCount) * 2) && reader.AtEnd();
+    if (!ok) {
+        return false;
+    }
+    ast.items.reserve(header.itemCount);
+    for (uint32_t i = 0; i < header.itemCount; ++i) {
+        ast.items.push_back({items[2 * i] != 0, items[2 * i + 1]});
+    }
+
+    if (!Validate(ast, header.nameCount)) {
+        return false;
+    }
+
+    std::vector<SymbolId> remap(header.nameCount);
+    uint64_t offset = 0;
+    for (uint32_t i = 0; i < header.nameCount; ++i) {
+        if (lengths[i] > header.nameBytes - offset) {
+            return false;
+        }
+        remap[i] = Interner::Global().Intern(std::string_view(names + offset, lengths[i]));
+        offset += lengths[i];
+    }
+    RemapSymbols(ast, remap);
+
+    out = std::move(ast);
+    return true;
+}
+
+bool AstCache::Store(const std::string& path, uint64_t sourceHash, uint64_t sourceSize, const FlatAst& ast) {
+    const Interner& interner = Interner::Global();
+
+    AstCacheHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.nameCount = static_cast<uint32_t>(interner.Size());
+    header.sourceHash = sourceHash;
+    header.sourceSize = sourceSize;
+    header.exprCount = static_cast<uint32_t>(ast.exprKind.size());
+    header.stmtCount = static_cast<uint32_t>(ast.stmtKind.size());
+    header.blockCount = static_cast<uint32_t>(ast.blockBegin.size());
+    header.refCount = static_cast<uint32_t>(ast.refs.size());
+    header.functionCount = static_cast<uint32_t>(ast.functions.size());
+    header.itemCount = static_cast<uint32_t>(ast.items.size());
+
+    std::vector<uint32_t> lengths;
+    std::string names;
+    for (SymbolId id = 0; id < header.nameCount; ++id) {
+        std::string_view name = interner.Name(id);
+        lengths.push_back(static_cast<uint32_t>(name.size()));
+        names += name;
+    }
+    header.nameBytes = names.size();
+
+    std::vector<uint32_t> items;
+    items.reserve(ast.items.size() * 2);
+    for (const FlatItem& item : ast.items) {
+        items.push_back(item.isFunction ? 1 : 0);
+        items.push_back(item.ref);
+    }
+
+    Writer writer;
+    writer.Put(&header, 1);
+    writer.Put(lengths.data(), lengths.size());
+    writer.Put(names.data(), names.size());
+    writer.Put(ast.exprKind.data(), ast.exprKind.size());
+    writer.Put(ast.exprOp.data(), ast.exprOp.size());
+    writer.Put(ast.exprA.data(), ast.exprA.size());
+    writer.Put(ast.exprB.data(), ast.exprB.size());
+    writer.Put(ast.stmtKind.data(), ast.stmtKind.size());
+    writer.Put(ast.stmtA.data(), ast.stmtA.size());
+    writer.Put(ast.stmtB.data(), ast.stmtB.size());
+    writer.Put(ast.stmtC.data(), ast.stmtC.size());
+    writer.Put(ast.blockBegin.data(), ast.blockBegin.size());
+    writer.Put(ast.blockSize.data(), ast.blockSize.size());
+    writer.Put(ast.refs.data(), ast.refs.size());
+    writer.Put(ast.functions.data(), ast.functions.size());
+    writer.Put(items.data(), items.size());
+
+    // пишем во временный файл, чтобы параллельный запуск не прочитал половину кэша
+    std::string tmpPath = path + ".tmp";
+    FILE* file = std::fopen(tmpPath.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    bool written = std::fwrite(writer.bytes.data(), 1, writer.bytes.size(), file) == writer.bytes.size();
+    written = std::fclose(file) == 0 && written;
+    if (!written || std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
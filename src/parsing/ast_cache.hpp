@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "flat_ast.hpp"
+
+/// Бинарный кэш разобранной программы, который лежит рядом с исходником
+/// (`<файл>.astc`). Внутри лежат массивы FlatAst как есть, плюс имена
+/// идентификаторов. Загрузка - это mmap и memcpy массивов, без лексера и
+/// парсера. Кэш действителен, только если хэш и размер исходника совпадают
+/// с записанными.
+///
+/// Формат (числа в порядке байт машины, секции выровнены на 8):
+///   заголовок AstCacheHeader
+///   длины имён (uint32 * nameCount), символы имён подряд
+///   exprKind, exprOp (по байту), exprA, exprB (uint32)
+///   stmtKind (байт), stmtA, stmtB, stmtC (uint32)
+///   blockBegin, blockSize, refs (uint32)
+///   functions (4 * uint32), items (isFunction, ref: 2 * uint32)
+class AstCache {
+public:
+    /// Вариант FNV-1a 64, который берёт текст по 8 байт; вместе с размером
+    /// исходника это ключ кэша.
+    static uint64_t HashSource(std::string_view source);
+
+    static std::string PathFor(const std::string& sourceFile) { return sourceFile + ".astc"; }
+
+    /// Читает кэш в `out`. Возвращает false, если файла нет, он повреждён или
+    /// сделан для другого исходника; тогда `out` не трогается.
+    /// Имена заново регистрируются в Interner::Global(), и номера
+    /// в массивах переводятся в номера текущего процесса.
+    static bool Load(const std::string& path, uint64_t sourceHash, uint64_t sourceSize, FlatAst& out);
+
+    /// Записывает кэш через временный файл и rename. Ошибки записи
+    /// не считаются фатальными: тогда возвращается false.
+    static bool Store(const std::string& path, uint64_t sourceHash, uint64_t sourceSize, const FlatAst& ast);
+};
@@ -0,0 +1,306 @@
+#include "flat_ast.hpp"
+
+#include <stdexcept>
+#include <string>
+
+#include "ast.hpp"
+
+BinaryOp BinaryOpFromSpelling(std::string_view op) {
+    switch (op[0]) {
+        case '+': return BinaryOp::Add;
+        case '-': return BinaryOp::Sub;
+        case '*': return BinaryOp::Mul;
+        case '/': return BinaryOp::Div;
+        default: throw std::runtime_error("Неизвестная бинарная операция " + std::string(op));
+    }
+}
+
+CompareOp CompareOpFromSpelling(std::string_view op) {
+    if (op == "==") return CompareOp::Eq;
+    if (op == "!=") return CompareOp::Ne;
+    if (op == "<") return CompareOp::Lt;
+    if (op == ">") return CompareOp::Gt;
+    if (op == "<=") return CompareOp::Le;
+    if (op == ">=") return CompareOp::Ge;
+    throw std::runtime_error("Неизвестная операция сравнения " + std::string(op));
+}
+
+std::string_view Spelling(BinaryOp op) {
+    switch (op) {
+        case BinaryOp::Add: return "+";
+        case BinaryOp::Sub: return "-";
+        case BinaryOp::Mul: return "*";
+        default: return "/";
+    }
+}
+
+std::string_view Spelling(CompareOp op) {
+    switch (op) {
+        case CompareOp::Eq: return "==";
+        case CompareOp::Ne: return "!=";
+        case CompareOp::Lt: return "<";
+        case CompareOp::Gt: return ">";
+        case CompareOp::Le: return "<=";
+        default: return ">=";
+    }
+}
+
+FlatRef FlatAst::AddExpr(FlatExprKind kind, uint8_t op, uint32_t a, uint32_t b) {
+    exprKind.push_back(kind);
+    exprOp.push_back(op);
+    exprA.push_back(a);
+    exprB.push_back(b);
+    return static_cast<FlatRef>(exprKind.size() - 1);
+}
+
+FlatRef FlatAst::AddStmt(FlatStmtKind kind, uint32_t a, uint32_t b, uint32_t c) {
+    stmtKind.push_back(kind);
+    stmtA.push_back(a);
+    stmtB.push_back(b);
+    stmtC.push_back(c);
+    return static_cast<FlatRef>(stmtKind.size() - 1);
+}
+
+FlatRef FlatAst::AddBlock(const uint32_t* stmts, uint32_t count) {
+    blockBegin.push_back(static_cast<uint32_t>(refs.size()));
+    blockSize.push_back(count);
+    refs.insert(refs.end(), stmts, stmts + count);
+    return static_cast<FlatRef>(blockBegin.size() - 1);
+}
+
+size_t FlatAst::MemoryBytes() const {
+    return exprKind.capacity() * sizeof(FlatExprKind) + exprOp.capacity() +
+           (exprA.capacity() + exprB.capacity()) * sizeof(uint32_t) +
+           stmtKind.capacity() * sizeof(FlatStmtKind) +
+           (stmtA.capacity() + stmtB.capacity() + stmtC.capacity()) * sizeof(uint32_t) +
+           (blockBegin.capacity() + blockSize.capacity() + refs.capacity()) * sizeof(uint32_t) +
+           functions.capacity() * sizeof(FlatFunction) + items.capacity() * sizeof(FlatItem);
+}
+
+namespace {
+
+/// Обходит обычное дерево и складывает узлы в FlatAst; результат каждого
+/// Visit - индекс построенного узла в `result`.
+class FlatLowering : public Visitor {
+public:
+    explicit FlatLowering(FlatAst& out) : out(out) {}
+
+    FlatRef Lower(ASTNode* node) {
+        node->Accept(this);
+        return result;
+    }
+
+    void Visit(ASTNode* node) override {}
+    void Visit(std::string& program) override {}
+    void Visit(ProgramBlocks* programBlocks) override {}
+    void Visit(ProgramBlock* programBlock) override {}
+    void Visit(Parameter* parameter) override {}
+    void Visit(Type* type) override {}
+    void Visit(Statement* statement) override {}
+    void Visit(Expression* expression) override {}
+
+    void Visit(FunctionDeclaration* func) override {
+        FlatFunction flat;
+        flat.name = func->name;
+        flat.params = static_cast<FlatRef>(out.refs.size());
+        flat.paramCount = static_cast<uint32_t>(func->params.size());
+        for (Parameter* param : func->params) {
+            out.refs.push_back(param->name);
+        }
+        flat.body = Lower(func->body);
+        out.functions.push_back(flat);
+        result = static_cast<FlatRef>(out.functions.size() - 1);
+    }
+
+    void Visit(StatementList* list) override {
+        size_t mark = scratch.size();
+        for (Statement* statement : list->statements) {
+            scratch.push_back(Lower(statement));
+        }
+        result = out.AddBlock(scratch.data() + mark, static_cast<uint32_t>(scratch.size() - mark));
+        scratch.resize(mark);
+    }
+
+    void Visit(Assignment* assignment) override {
+        FlatRef expr = Lower(assignment->expression);
+        result = out.AddStmt(FlatStmtKind::Assign, assignment->variable, expr, assignment->inlinedReturn ? 1 : kNoFlatRef);
+    }
+    void Visit(Declaration* declaration) override {
+        result = out.AddStmt(FlatStmtKind::Declare, declaration->varName);
+    }
+    void Visit(PrintStatement* print) override {
+        result = out.AddStmt(FlatStmtKind::Print, Lower(print->expression));
+    }
+    void Visit(ReturnStatement* ret) override {
+        result = out.AddStmt(FlatStmtKind::Return, Lower(ret->expression));
+    }
+    void Visit(IfStatement* statement) override {
+        FlatRef cond = Lower(statement->condition);
+        FlatRef thenBlock = Lower(statement->thenBranch);
+        FlatRef elseBlock = statement->elseBranch ? Lower(statement->elseBranch) : kNoFlatRef;
+        result = out.AddStmt(FlatStmtKind::If, cond, thenBlock, elseBlock);
+    }
+
+    void Visit(Number* number) override {
+        result = out.AddExpr(FlatExprKind::Number, 0, static_cast<uint32_t>(number->value), 0);
+    }
+    void Visit(Variable* variable) override {
+        result = out.AddExpr(FlatExprKind::Variable, 0, variable->name, 0);
+    }
+    void Visit(BinaryExpression* expression) override {
+        FlatRef left = Lower(expression->left);
+        FlatRef right = Lower(expression->right);
+        result = out.AddExpr(FlatExprKind::Binary, static_cast<uint8_t>(BinaryOpFromSpelling(expression->op)), left, right);
+    }
+    void Visit(Comparison* expression) override {
+        FlatRef left = Lower(expression->left);
+        FlatRef right = Lower(expression->right);
+        result = out.AddExpr(FlatExprKind::Compare, static_cast<uint8_t>(CompareOpFromSpelling(expression->op)), left, right);
+    }
+    void Visit(FunctionCall* call) override {
+        size_t mark = scratch.size();
+        for (Expression* arg : call->args) {
+            scratch.push_back(Lower(arg));
+        }
+        FlatRef args = static_cast<FlatRef>(out.refs.size());
+        out.refs.push_back(static_cast<uint32_t>(scratch.size() - mark));
+        out.refs.insert(out.refs.end(), scratch.begin() + mark, scratch.end());
+        scratch.resize(mark);
+        result = out.AddExpr(FlatExprKind::Call, 0, call->name, args);
+    }
+
+private:
+    FlatAst& out;
+    FlatRef result = kNoFlatRef;
+    std::vector<uint32_t> scratch;
+};
+
+} // namespace
+
+void FlatAstBuilder::AddProgramBlock(ProgramBlock* block) {
+    FlatLowering lowering(out);
+    if (block->function != nullptr) {
+        out.items.push_back({true, lowering.Lower(block->function)});
+    } else {
+        out.items.push_back({false, lowering.Lower(block->statement)});
+    }
+}
+
+namespace {
+
+class FlatExpander {
+public:
+    FlatExpander(const FlatAst& flat, Arena& arena) : flat(flat), arena(arena) {}
+
+    void ExpandExpressions() {
+        exprs.resize(flat.exprKind.size());
+        for (size_t i = 0; i < exprs.size(); ++i) {
+            uint32_t a = flat.exprA[i];
+            uint32_t b = flat.exprB[i];
+            switch (flat.exprKind[i]) {
+                case FlatExprKind::Number:
+                    exprs[i] = arena.Make<Number>(flat.NumberValue(static_cast<FlatRef>(i)));
+                    break;
+                case FlatExprKind::Variable:
+                    exprs[i] = arena.Make<Variable>(a);
+                    break;
+                case FlatExprKind::Binary:
+                    exprs[i] = arena.Make<BinaryExpression>(Spelling(static_cast<BinaryOp>(flat.exprOp[i])), exprs[a], exprs[b]);
+                    break;
+                case FlatExprKind::Compare:
+                    exprs[i] = arena.Make<Comparison>(Spelling(static_cast<CompareOp>(flat.exprOp[i])), exprs[a], exprs[b]);
+                    break;
+                case FlatExprKind::Call: {
+                    uint32_t count = flat.refs[b];
+                    args.clear();
+                    for (uint32_t arg = 0; arg < count; ++arg) {
+                        args.push_back(exprs[flat.refs[b + 1 + arg]]);
+                    }
+                    exprs[i] = arena.Make<FunctionCall>(a, arena.MakeList(args.data(), args.size()));
+                    break;
+                }
+            }
+        }
+    }
+
+    void ExpandStatements() {
+        stmts.resize(flat.stmtKind.size());
+        for (size_t i = 0; i < stmts.size(); ++i) {
+            uint32_t a = flat.stmtA[i];
+            switch (flat.stmtKind[i]) {
+                case FlatStmtKind::Declare:
+                    stmts[i] = arena.Make<Declaration>(a);
+                    break;
+                case FlatStmtKind::Assign: {
+                    auto* assignment = arena.Make<Assignment>(a, exprs[flat.stmtB[i]]);
+                    assignment->inlinedReturn = flat.stmtC[i] != kNoFlatRef;
+                    stmts[i] = assignment;
+                    break;
+                }
+                case FlatStmtKind::Print:
+                    stmts[i] = arena.Make<PrintStatement>(exprs[a]);
+                    break;
+                case FlatStmtKind::Return:
+                    stmts[i] = arena.Make<ReturnStatement>(exprs[a]);
+                    break;
+                case FlatStmtKind::If: {
+                    StatementList* elseBlock = flat.stmtC[i] == kNoFlatRef ? nullptr : Block(flat.stmtC[i]);
+                    stmts[i] = arena.Make<IfStatement>(exprs[a], Block(flat.stmtB[i]), elseBlock);
+                    break;
+                }
+            }
+        }
+    }
+
+    /// Блоки собираются по требованию: на каждый ссылаются ровно один раз,
+    /// и к этому моменту все его операторы уже построены.
+    StatementList* Block(FlatRef block) {
+        uint32_t count = flat.blockSize[block];
+        body.clear();
+        for (uint32_t i = 0; i < count; ++i) {
+            body.push_back(stmts[flat.BlockStmt(block, i)]);
+        }
+        return arena.Make<StatementList>(arena.MakeList(body.data(), body.size()));
+    }
+
+    FunctionDeclaration* Function(const FlatFunction& func) {
+        std::vector<Parameter*> params;
+        params.reserve(func.paramCount);
+        for (uint32_t i = 0; i < func.paramCount; ++i) {
+            params.push_back(arena.Make<Parameter>(flat.FunctionParam(func, i), arena.Make<Type>(Types::INT)));
+        }
+        return arena.Make<FunctionDeclaration>(func.name, arena.MakeList(params.data(), params.size()),
+                                               Block(func.body), arena.Make<Type>(Types::INT));
+    }
+
+    Statement* TopStatement(FlatRef stmt) { return stmts[stmt]; }
+
+private:
+    const FlatAst& flat;
+    Arena& arena;
+    std::vector<Expression*> exprs;
+    std::vector<Statement*> stmts;
+    std::vector<Expression*> args;
+    std::vector<Statement*> body;
+};
+
+} // namespace
+
+std::unique_ptr<ProgramBlocks> ExpandFlatAst(const FlatAst& flat) {
+    auto program = std::make_unique<ProgramBlocks>();
+    FlatExpander expander(flat, program->arena);
+    expander.ExpandExpressions();
+    expander.ExpandStatements();
+
+    std::vector<ProgramBlock*> blocks;
+    blocks.reserve(flat.items.size());
+    for (const FlatItem& item : flat.items) {
+        if (item.isFunction) {
+            blocks.push_back(program->arena.Make<ProgramBlock>(expander.Function(flat.functions[item.ref])));
+        } else {
+            blocks.push_back(program->arena.Make<ProgramBlock>(expander.TopStatement(item.ref)));
+        }
+    }
+    program->blocks = program->arena.MakeList<ProgramBlock*>(blocks.data(), blocks.size());
+    return program;
+}
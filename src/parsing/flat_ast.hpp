@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "../tokenization/interner.hpp"
+
+/// Плоское представление AST: узлы одного вида лежат в непрерывных массивах
+/// (structure-of-arrays) и ссылаются на детей 32-битными индексами.
+/// Нет vtable, unique_ptr и строк: выражение занимает 10 байт,
+/// оператор хранится как однобайтовый enum.
+
+using FlatRef = uint32_t;
+constexpr FlatRef kNoFlatRef = UINT32_MAX;
+
+enum class BinaryOp : uint8_t {
+    Add,
+    Sub,
+    Mul,
+    Div,
+};
+
+enum class CompareOp : uint8_t {
+    Eq,
+    Ne,
+    Lt,
+    Gt,
+    Le,
+    Ge,
+};
+
+BinaryOp BinaryOpFromSpelling(std::string_view op);
+CompareOp CompareOpFromSpelling(std::string_view op);
+std::string_view Spelling(BinaryOp op);
+std::string_view Spelling(CompareOp op);
+
+enum class FlatExprKind : uint8_t {
+    Number,     // a - значение
+    Variable,   // a - SymbolId
+    Binary,     // op - BinaryOp, a/b - левый/правый операнды
+    Compare,    // op - CompareOp, a/b - левый/правый операнды
+    Call,       // a - SymbolId функции, b - начало аргументов в refs (refs[b] - их число)
+};
+
+enum class FlatStmtKind : uint8_t {
+    Declare,    // a - SymbolId
+    Assign,     // a - SymbolId, b - выражение, c - не kNoFlatRef для Assignment::inlinedReturn
+    Print,      // a - выражение
+    Return,     // a - выражение
+    If,         // a - условие, b - блок then, c - блок else или kNoFlatRef
+};
+
+struct FlatFunction {
+    SymbolId name;
+    FlatRef params;     // начало SymbolId параметров в refs
+    uint32_t paramCount;
+    FlatRef body;       // блок
+};
+
+/// Элемент верхнего уровня программы: функция или оператор.
+struct FlatItem {
+    bool isFunction;
+    FlatRef ref;
+};
+
+class FlatAst {
+public:
+    // выражения
+    std::vector<FlatExprKind> exprKind;
+    std::vector<uint8_t> exprOp;
+    std::vector<uint32_t> exprA;
+    std::vector<uint32_t> exprB;
+
+    // операторы
+    std::vector<FlatStmtKind> stmtKind;
+    std::vector<uint32_t> stmtA;
+    std::vector<uint32_t> stmtB;
+    std::vector<uint32_t> stmtC;
+
+    // блоки - отрезки refs с номерами операторов
+    std::vector<uint32_t> blockBegin;
+    std::vector<uint32_t> blockSize;
+
+    std::vector<FlatFunction> functions;
+    std::vector<FlatItem> items;
+
+    /// Общий пул индексов: аргументы вызовов, параметры функций, операторы блоков.
+    std::vector<uint32_t> refs;
+
+    FlatRef AddExpr(FlatExprKind kind, uint8_t op, uint32_t a, uint32_t b);
+    FlatRef AddStmt(FlatStmtKind kind, uint32_t a, uint32_t b = kNoFlatRef, uint32_t c = kNoFlatRef);
+    FlatRef AddBlock(const uint32_t* stmts, uint32_t count);
+
+    int32_t NumberValue(FlatRef expr) const { return static_cast<int32_t>(exprA[expr]); }
+    uint32_t CallArgCount(FlatRef expr) const { return refs[exprB[expr]]; }
+    FlatRef CallArg(FlatRef expr, uint32_t i) const { return refs[exprB[expr] + 1 + i]; }
+    SymbolId FunctionParam(const FlatFunction& func, uint32_t i) const { return refs[func.params + i]; }
+    FlatRef BlockStmt(FlatRef block, uint32_t i) const { return refs[blockBegin[block] + i]; }
+
+    size_t MemoryBytes() const;
+};
+
+class ProgramBlock;
+class ProgramBlocks;
+
+/// Переводит блоки верхнего уровня обычного AST в FlatAst.
+class FlatAstBuilder {
+public:
+    explicit FlatAstBuilder(FlatAst& out) : out(out) {}
+    void AddProgramBlock(ProgramBlock* block);
+
+private:
+    FlatAst& out;
+};
+
+/// Обратное преобразование: строит обычное дерево в собственной арене.
+/// Дети в FlatAst всегда стоят раньше родителей, поэтому хватает
+/// одного прохода по массивам без рекурсии.
+std::unique_ptr<ProgramBlocks> ExpandFlatAst(const FlatAst& flat);
@@ -0,0 +1,222 @@
+#include "parallel_parser.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <future>
+
+#include "parser.hpp"
+#include "../tokenization/char_scan.hpp"
+#include "../util/thread_pool.hpp"
+
+namespace {
+
+/// Переписывает номера имён в поддереве по таблице `remap`.
+class SymbolRemapper : public Visitor {
+public:
+    explicit SymbolRemapper(const std::vector<SymbolId>& remap) : remap(remap) {}
+
+    void Visit(ASTNode* node) override {}
+    void Visit(std::string& program) override {}
+    void Visit(ProgramBlock* programBlock) override {}
+    void Visit(Type* type) override {}
+    void Visit(Statement* statement) override {}
+    void Visit(Expression* expression) override {}
+
+    void Visit(ProgramBlocks* programBlocks) override {
+        for (ProgramBlock* block : programBlocks->blocks) {
+            if (block->function != nullptr) {
+                block->function->Accept(this);
+            } else {
+                block->statement->Accept(this);
+            }
+        }
+    }
+
+    void Visit(FunctionDeclaration* func) override {
+        func->name = remap[func->name];
+        for (Parameter* param : func->params) {
+            param->Accept(this);
+        }
+        func->body->Accept(this);
+    }
+    void Visit(Parameter* parameter) override {
+        parameter->name = remap[parameter->name];
+    }
+
+    void Visit(StatementList* list) override {
+        for (Statement* statement : list->statements) {
+            statement->Accept(this);
+        }
+    }
+    void Visit(Assignment* assignment) override {
+        assignment->variable = remap[assignment->variable];
+        assignment->expression->Accept(this);
+    }
+    void Visit(Declaration* declaration) override {
+        declaration->varName = remap[declaration->varName];
+    }
+    void Visit(PrintStatement* print) override {
+        print->expression->Accept(this);
+    }
+    void Visit(ReturnStatement* ret) override {
+        ret->expression->Accept(this);
+    }
+    void Visit(IfStatement* statement) override {
+        statement->condition->Accept(this);
+        statement->thenBranch->Accept(this);
+        if (statement->elseBranch != nullptr) {
+            statement->elseBranch->Accept(this);
+        }
+    }
+
+    void Visit(Number* number) override {}
+    void Visit(Variable* variable) override {
+        variable->name = remap[variable->name];
+    }
+    void Visit(BinaryExpression* expression) override {
+        expression->left->Accept(this);
+        expression->right->Accept(this);
+    }
+    void Visit(Comparison* expression) override {
+        expression->left->Accept(this);
+        expression->right->Accept(this);
+    }
+    void Visit(FunctionCall* call) override {
+        call->name = remap[call->name];
+        for (Expression* arg : call->args) {
+            arg->Accept(this);
+        }
+    }
+
+private:
+    const std::vector<SymbolId>& remap;
+};
+
+/// Пачка соседних функций, которую разбирает один поток.
+struct Batch {
+    std::string_view text;
+    Interner names;
+    std::vector<SymbolId> remap;
+    std::unique_ptr<ProgramBlocks> tree;
+};
+
+} // namespace
+
+std::vector<std::string_view> ParallelParser::splitTopLevel(std::string_view source) {
+    std::vector<std::string_view> chunks;
+    const char* p = source.data();
+    const char* end = p + source.size();
+    const char* chunkStart = p;
+    int depth = 0;
+
+    while (p < end) {
+        if (depth > 0) {
+            // внутри тела важны только скобки: имена и числа их не содержат
+            while (p < end && *p != '{' && *p != '}') {
+                ++p;
+            }
+            if (p == end) {
+                break;
+            }
+            depth += *p == '{' ? 1 : -1;
+            ++p;
+            continue;
+        }
+
+        char c = *p;
+        if (charscan::IsAlpha(c)) {
+            const char* wordEnd = charscan::SkipIdent(p, end);
+            if (wordEnd - p == 4 && std::memcmp(p, "func", 4) == 0 && p != chunkStart) {
+                chunks.emplace_back(chunkStart, p - chunkStart);
+                chunkStart = p;
+            }
+            p = wordEnd;
+            continue;
+        }
+        if (charscan::IsDigit(c)) {
+            p = charscan::SkipDigits(p, end);
+            continue;
+        }
+        if (c == '{') {
+            ++depth;
+        } else if (c == '}') {
+            break;  // на лишней '}' парсер останавливается - хвост не делим
+        }
+        ++p;
+    }
+    chunks.emplace_back(chunkStart, end - chunkStart);
+    return chunks;
+}
+
+std::unique_ptr<ProgramBlocks> ParallelParser::parse() {
+    if (pool.Size() <= 1 || source.size() < 2 * kMinBatchBytes) {
+        Lexer lexer(source);
+        Parser parser(lexer);
+        return parser.parse();
+    }
+
+    size_t target = std::max(kMinBatchBytes, source.size() / (pool.Size() * 4));
+    std::vector<std::string_view> texts;
+    for (std::string_view chunk : splitTopLevel(source)) {
+        if (!texts.empty() && texts.back().size() < target) {
+            texts.back() = std::string_view(texts.back().data(), texts.back().size() + chunk.size());
+        } else {
+            texts.push_back(chunk);
+        }
+    }
+
+    if (texts.size() <= 1) {
+        Lexer lexer(source);
+        Parser parser(lexer);
+        return parser.parse();
+    }
+
+    std::vector<Batch> batches(texts.size());
+    std::vector<std::future<void>> done;
+    done.reserve(batches.size());
+    for (size_t i = 0; i < batches.size(); ++i) {
+        Batch& batch = batches[i];
+        batch.text = texts[i];
+        done.push_back(pool.Submit([&batch] {
+            Lexer lexer(batch.text, batch.names);
+            Parser parser(lexer);
+            batch.tree = parser.parse();
+        }));
+    }
+    // сначала дожидаемся всех задач: они ссылаются на batches
+    for (auto& future : done) {
+        future.wait();
+    }
+    for (auto& future : done) {
+        future.get();   // первая по исходнику ошибка разбора
+    }
+
+    // номера раздаются в порядке первого появления имени в исходнике - как у Parser
+    Interner& global = Interner::Global();
+    for (Batch& batch : batches) {
+        batch.remap.resize(batch.names.Size());
+        for (SymbolId id = 0; id < batch.names.Size(); ++id) {
+            batch.remap[id] = global.Intern(batch.names.Name(id));
+        }
+    }
+
+    done.clear();
+    for (Batch& batch : batches) {
+        done.push_back(pool.Submit([&batch] {
+            SymbolRemapper remapper(batch.remap);
+            batch.tree->Accept(&remapper);
+        }));
+    }
+    for (auto& future : done) {
+        future.get();
+    }
+
+    auto result = std::make_unique<ProgramBlocks>();
+    std::vector<ProgramBlock*> blocks;
+    for (Batch& batch : batches) {
+        blocks.insert(blocks.end(), batch.tree->blocks.begin(), batch.tree->blocks.end());
+        result->arena.Absorb(batch.tree->arena);
+    }
+    result->blocks = result->arena.MakeList(blocks.data(), blocks.size());
+    return result;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "ast.hpp"
+
+class ThreadPool;
+
+/// Разбор программы на нескольких потоках. Исходник заранее режется
+/// на куски по границам `func` верхнего уровня (по балансу фигурных скобок),
+/// соседние функции собираются в пачки примерно равного размера, и каждая
+/// пачка разбирается обычным Parser в своей арене со своей таблицей имён.
+/// Затем номера имён переводятся в Interner::Global() в порядке исходника,
+/// поэтому они совпадают с последовательным разбором, а блоки склеиваются
+/// в исходном порядке.
+class ParallelParser {
+public:
+    ParallelParser(std::string_view source, ThreadPool& pool) : source(source), pool(pool) {}
+
+    std::unique_ptr<ProgramBlocks> parse();
+
+    /// Куски исходника, каждый (кроме, возможно, первого) начинается с `func`
+    /// верхнего уровня; вместе они покрывают весь текст.
+    static std::vector<std::string_view> splitTopLevel(std::string_view source);
+
+    /// Пачки меньше этого размера не делятся: на маленьком входе
+    /// работа потоков не окупается.
+    static constexpr size_t kMinBatchBytes = 64 * 1024;
+
+private:
+    std::string_view source;
+    ThreadPool& pool;
+};
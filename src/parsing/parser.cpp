@@ -1,79 +1,104 @@
 #include "parser.hpp"
+#include <charconv>
 #include <iostream>
 
+static int parseInt(std::string_view text) {
+    int value = 0;
+    auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (ec != std::errc() || ptr != text.data() + text.size()) {
+        throw std::runtime_error("Некорректное число " + std::string(text));
+    }
+    return value;
+}
+
 std::unique_ptr<ProgramBlocks> Parser::parse() {
     return parseProgramBlocks();
 }
 
 std::unique_ptr<ProgramBlocks> Parser::parseProgramBlocks() {
     auto blocks = std::make_unique<ProgramBlocks>();
+    arena = &blocks->arena;
     
-    while (currentToken.value != "}" && currentToken.type != TokenType::EndOfFile) {
-        blocks->blocks.push_back(parseProgramBlock());
+    size_t mark = listScratch.size();
+    while (currentToken.kind != TokenKind::RBrace && currentToken.kind != TokenKind::EndOfFile) {
+        listScratch.push_back(parseProgramBlock());
     }
+    blocks->blocks = finishList<ProgramBlock>(mark);
 
+    arena = nullptr;
     return blocks;
 }
 
-std::unique_ptr<ProgramBlock> Parser::parseProgramBlock() {
-    if (currentToken.value == "func") {
-        return std::make_unique<ProgramBlock>(parseFunctionDeclaration());
-    } else {
-        return std::make_unique<ProgramBlock>(parseStatement());
+void Parser::parseFlat(FlatAst& out) {
+    Arena scratch;
+    arena = &scratch;
+    FlatAstBuilder builder(out);
+
+    while (currentToken.kind != TokenKind::RBrace && currentToken.kind != TokenKind::EndOfFile) {
+        builder.AddProgramBlock(parseProgramBlock());
+        scratch.Reset();
     }
+
+    arena = nullptr;
 }
 
-std::unique_ptr<StatementList> Parser::parseStatementList() {
-    auto statements = std::make_unique<StatementList>();
-    
-    while (currentToken.value != "}" && currentToken.type != TokenType::EndOfFile) {
-        statements->statements.push_back(parseStatement());
+ProgramBlock* Parser::parseProgramBlock() {
+    switch (currentToken.kind) {
+        case TokenKind::KwFunc:
+            return make<ProgramBlock>(parseFunctionDeclaration());
+        default:
+            return make<ProgramBlock>(parseStatement());
+    }
+}
+
+StatementList* Parser::parseStatementList() {
+    size_t mark = listScratch.size();
+    while (currentToken.kind != TokenKind::RBrace && currentToken.kind != TokenKind::EndOfFile) {
+        listScratch.push_back(parseStatement());
     }
 
-    return statements;
+    return make<StatementList>(finishList<Statement>(mark));
 }
 
 
-std::unique_ptr<Statement> Parser::parseStatement() {
-    if (currentToken.value == "declare") {
-        return parseDeclaration();
-    }
-    if (currentToken.value == "if") {
-        return parseIfStatement();
-    }
-    if (currentToken.value == "print") {
-        return parsePrintStatement();
-    }
-    if (currentToken.value == "return") {
-        return parseReturnStatement();
-    }
-    if (currentToken.type == TokenType::Identifier) {
-        return parseAssignment(); 
+Statement* Parser::parseStatement() {
+    switch (currentToken.kind) {
+        case TokenKind::KwDeclare:
+            return parseDeclaration();
+        case TokenKind::KwIf:
+            return parseIfStatement();
+        case TokenKind::KwPrint:
+            return parsePrintStatement();
+        case TokenKind::KwReturn:
+            return parseReturnStatement();
+        case TokenKind::Identifier:
+            return parseAssignment(); 
+        default:
+            throw std::runtime_error("Ожидался оператор");
     }
-
-    throw std::runtime_error("Ожидался оператор");
 }
 
-std::unique_ptr<Type> Parser::parseType() {
+Type* Parser::parseType() {
     if (currentToken.type != TokenType::Keyword)
         throw std::runtime_error("Ожидался тип");
 
-    if (currentToken.value == "int") {
-        advance();
-        return std::make_unique<Type>(Types::INT);
-    } else {//if float... 
-        throw std::runtime_error("Неизвестный тип " + currentToken.value);  
+    switch (currentToken.kind) {
+        case TokenKind::KwInt:
+            advance();
+            return make<Type>(Types::INT);
+        default: //if float... 
+            throw std::runtime_error("Неизвестный тип " + std::string(currentToken.value));  
     }
 }
 
-std::unique_ptr<Parameter> Parser::parseParameter() {
-    if (currentToken.type != TokenType::Identifier)
+Parameter* Parser::parseParameter() {
+    if (currentToken.kind != TokenKind::Identifier)
         throw std::runtime_error("Ожидалось имя параметра");
     
-    std::string paramName = currentToken.value;
+    SymbolId paramName = currentToken.symbol;
     advance();
     
-    if (currentToken.value != ":")
+    if (currentToken.kind != TokenKind::Colon)
         throw std::runtime_error("Ожидался ':' после имени параметра");
 
     advance();
@@ -82,270 +107,314 @@ std::unique_ptr<Parameter> Parser::parseParameter() {
     
     /// `advance()` called in `parseType()`, so we don't need to call it here
     
-    return std::make_unique<Parameter>(paramName, std::move(type));
+    return make<Parameter>(paramName, type);
 }
 
-std::unique_ptr<FunctionDeclaration> Parser::parseFunctionDeclaration() {
+FunctionDeclaration* Parser::parseFunctionDeclaration() {
     advance(); /// Пропускаем "func" 
     
-    if (currentToken.type != TokenType::Identifier)
+    if (currentToken.kind != TokenKind::Identifier)
         throw std::runtime_error("Ожидался идентификатор после 'func'");
 
-    std::string funcName = currentToken.value;
+    SymbolId funcName = currentToken.symbol;
     advance();
 
-    if (currentToken.value != "(")
+    if (currentToken.kind != TokenKind::LParen)
         throw std::runtime_error("Ожидался '(' после имени функции");
 
     advance();
-    std::vector<std::unique_ptr<Parameter>> params{};
-    while (currentToken.type == TokenType::Identifier) {
+    size_t mark = listScratch.size();
+    while (currentToken.kind == TokenKind::Identifier) {
         // std::cout << "param " << currentToken.value;
-        params.push_back(parseParameter());
+        listScratch.push_back(parseParameter());
 
         // advance(); // skip int                       
-        if (currentToken.value != ",") {             
+        if (currentToken.kind != TokenKind::Comma) {             
             break;                                   
         }                                            
         advance(); // skip ,                         
     }
 
-    if (currentToken.value != ")")
+    if (currentToken.kind != TokenKind::RParen)
         throw std::runtime_error("Ожидался ')' после списка параметров");
 
     advance();
+    NodeList<Parameter*> params = finishList<Parameter>(mark);
 
-    if (currentToken.value != ":")
+    if (currentToken.kind != TokenKind::Colon)
         throw std::runtime_error("Ожидался ':' после списка параметров и ')'");
 
     advance();
 
     auto returnTp = parseType();
 
-    if (currentToken.value != "{")
+    if (currentToken.kind != TokenKind::LBrace)
         throw std::runtime_error("Ожидался '{' после типа функции");
 
     advance();
 
-    std::unique_ptr<StatementList> body = parseStatementList();
+    StatementList* body = parseStatementList();
 
-    if (currentToken.value != "}")
-        throw std::runtime_error("Ожидался '}' в конце функции " + funcName);
+    if (currentToken.kind != TokenKind::RBrace)
+        throw std::runtime_error("Ожидался '}' в конце функции " + std::string(lexer.symbols().Name(funcName)));
 
     advance();
     
-    return std::make_unique<FunctionDeclaration>(funcName, std::move(params), std::move(body), std::move(returnTp));
+    return make<FunctionDeclaration>(funcName, params, body, returnTp);
 }
 
-std::unique_ptr<Expression> Parser::parseFunctionCall() {
-    std::string funcName = currentToken.value;
+Statement* Parser::parseAssignment() {
+    SymbolId varName = currentToken.symbol;
     advance();
-
-    if (currentToken.value != "(") {
-        throw std::runtime_error("Ожидался знак '(' вместо " + currentToken.value);
-    }
-    advance();
-
-    std::vector<std::unique_ptr<Expression>> params{};
-    while (currentToken.value != ")") {
-        params.push_back(parseExpression());
-        // advance();
-        if (currentToken.value != ",") {             
-            break;                                   
-        }                                            
-        advance(); // skip ,                         
-    }
-
-    if (currentToken.value != ")") {
-        throw std::runtime_error("Ожидался знак ')'");
-    }
-    advance();
-    
-    // if (currentToken.value != ";") {
-    //     throw std::runtime_error("Ожидалась ';;'");
-    // }
-    
-    // advance();
-    
-    return std::make_unique<FunctionCall>(funcName, std::move(params));
-}
-
-
-std::unique_ptr<Statement> Parser::parseAssignment() {
-    std::string varName = currentToken.value;
-    advance();
-    if (currentToken.value != "=") throw std::runtime_error("Ожидался знак '=' вместо [ " + currentToken.value + "]");
+    if (currentToken.kind != TokenKind::Assign) throw std::runtime_error("Ожидался знак '=' вместо [ " + std::string(currentToken.value) + "]");
     advance();
     auto expr = parseExpression();
-    if (currentToken.value != ";") throw std::runtime_error("Ожидалась ';'");
+    if (currentToken.kind != TokenKind::Semicolon) throw std::runtime_error("Ожидалась ';'");
     advance();
-    return std::make_unique<Assignment>(varName, std::move(expr));
+    return make<Assignment>(varName, expr);
 }
 
-std::unique_ptr<Statement> Parser::parsePrintStatement() {
+Statement* Parser::parsePrintStatement() {
     advance();
-    if (currentToken.value != "(") throw std::runtime_error("Ожидалась '('");
+    if (currentToken.kind != TokenKind::LParen) throw std::runtime_error("Ожидалась '('");
     advance();
     auto var = parseExpression();
-    if (currentToken.value != ")") throw std::runtime_error("parsePrintStatement(): Ожидалась ')'");
+    if (currentToken.kind != TokenKind::RParen) throw std::runtime_error("parsePrintStatement(): Ожидалась ')'");
     advance();
-    if (currentToken.value != ";") throw std::runtime_error("Ожидалась ';'");
+    if (currentToken.kind != TokenKind::Semicolon) throw std::runtime_error("Ожидалась ';'");
     advance();
-    return std::make_unique<PrintStatement>(std::move(var));
+    return make<PrintStatement>(var);
 }
 
-std::unique_ptr<Statement> Parser::parseReturnStatement() {
+Statement* Parser::parseReturnStatement() {
     advance(); // пропускаем "return"
     
     auto expr = parseExpression();
     
-    if (currentToken.value != ";") throw std::runtime_error("Ожидалась ';'");
+    if (currentToken.kind != TokenKind::Semicolon) throw std::runtime_error("Ожидалась ';'");
     
     advance();
 
-    return std::make_unique<ReturnStatement>(std::move(expr));
+    return make<ReturnStatement>(expr);
 }
 
-std::unique_ptr<Statement> Parser::parseDeclaration() {
+Statement* Parser::parseDeclaration() {
     advance(); // Пропускаем "declare"
     
-    if (currentToken.type != TokenType::Identifier)
+    if (currentToken.kind != TokenKind::Identifier)
         throw std::runtime_error("Ожидался идентификатор после 'declare'");
 
-    std::string varName = currentToken.value;
+    SymbolId varName = currentToken.symbol;
     advance();
 
-    if (currentToken.value != ":")
+    if (currentToken.kind != TokenKind::Colon)
         throw std::runtime_error("Ожидался ':' после имени переменной");
 
     advance();
 
-    if (currentToken.value != "int") // пока поддерживаем только int
+    if (currentToken.kind != TokenKind::KwInt) // пока поддерживаем только int
         throw std::runtime_error("Ожидался тип 'int' после ':'");
 
     advance();
 
-    if (currentToken.value != ";")
+    if (currentToken.kind != TokenKind::Semicolon)
         throw std::runtime_error("Ожидалась ';' после объявления переменной");
 
     advance();
     
-    return std::make_unique<Declaration>(varName);
+    return make<Declaration>(varName);
 }
 
-std::unique_ptr<IfStatement> Parser::parseIfStatement() {
+IfStatement* Parser::parseIfStatement() {
     advance(); // Пропускаем "if"
 
-    if (currentToken.value != "(") throw std::runtime_error("Ожидалась '(' после if");
+    if (currentToken.kind != TokenKind::LParen) throw std::runtime_error("Ожидалась '(' после if");
     advance();
     
     auto condition = parseExpression(); // Условие
-    if (currentToken.value != ")") throw std::runtime_error("parseIfStatement():Ожидалась ')' после условия");
+    if (currentToken.kind != TokenKind::RParen) throw std::runtime_error("parseIfStatement():Ожидалась ')' после условия");
     advance();
 
-    if (currentToken.value != "{") throw std::runtime_error("Ожидалась '{' перед блоком if");
+    if (currentToken.kind != TokenKind::LBrace) throw std::runtime_error("Ожидалась '{' перед блоком if");
     advance();
 
     auto thenBody = parseStatementList(); // Тело if
-    if (currentToken.value != "}") throw std::runtime_error("Ожидалась '}' после блока if");
+    if (currentToken.kind != TokenKind::RBrace) throw std::runtime_error("Ожидалась '}' после блока if");
     advance();
 
-    std::unique_ptr<StatementList> elseBody = nullptr;
-    if (currentToken.value == "else") {
+    StatementList* elseBody = nullptr;
+    if (currentToken.kind == TokenKind::KwElse) {
         advance();
-        if (currentToken.value != "{") throw std::runtime_error("Ожидалась '{' перед блоком else");
+        if (currentToken.kind != TokenKind::LBrace) throw std::runtime_error("Ожидалась '{' перед блоком else");
         advance();
         
         elseBody = parseStatementList(); // Тело else
-        if (currentToken.value != "}") throw std::runtime_error("Ожидалась '}' после блока else");
+        if (currentToken.kind != TokenKind::RBrace) throw std::runtime_error("Ожидалась '}' после блока else");
         advance();
     }
 
-    return std::make_unique<IfStatement>(std::move(condition), std::move(thenBody), std::move(elseBody));
+    return make<IfStatement>(condition, thenBody, elseBody);
 }
 
-std::unique_ptr<Expression> Parser::parseExpression() {
-    auto left = parseSubAdd();
-
-    while ( currentToken.value == "==" || 
-            currentToken.value == ">=" || 
-            currentToken.value == "!=" || 
-            currentToken.value == "<" || 
-            currentToken.value == ">" || 
-            currentToken.value == "<=") {
-        std::string op = currentToken.value;
-        advance();
-        auto right = parseSubAdd();
-        left = std::make_unique<Comparison>(op, std::move(left), std::move(right));
+namespace {
+
+/// Приоритет бинарного оператора; 0 - токен не является бинарным оператором.
+int binaryPrecedence(TokenKind kind) {
+    switch (kind) {
+        case TokenKind::EqualEqual:
+        case TokenKind::NotEqual:
+        case TokenKind::Less:
+        case TokenKind::Greater:
+        case TokenKind::LessEqual:
+        case TokenKind::GreaterEqual:
+            return 1;
+        case TokenKind::Plus:
+        case TokenKind::Minus:
+            return 2;
+        case TokenKind::Star:
+        case TokenKind::Slash:
+            return 3;
+        default:
+            return 0;
     }
-
-    return left;
 }
 
-std::unique_ptr<Expression> Parser::parseSubAdd() {
-    auto left = parseTerm();
-
-    while (currentToken.value == "+" || currentToken.value == "-") {
-        std::string op = currentToken.value;
-        advance();
-        auto right = parseTerm();
-        left = std::make_unique<BinaryExpression>(op, std::move(left), std::move(right));
+} // namespace
+
+/// Разбор выражения методом приоритета операторов с явными стеками операндов
+/// и операторов: ни длина цепочки `a + b + ...`, ни глубина скобок и вложенных
+/// вызовов не расходуют нативный стек. Деревья совпадают с прежним
+/// рекурсивным спуском: все операторы левоассоциативны, сравнения имеют
+/// наименьший приоритет, затем `+ -`, затем `* /`.
+Expression* Parser::parseExpression() {
+    const size_t operandBase = operandStack.size();
+    const size_t operatorBase = operatorStack.size();
+    bool expectOperand = true;
+
+    for (;;) {
+        if (expectOperand) {
+            switch (currentToken.kind) {
+                case TokenKind::Number:
+                    operandStack.push_back(make<Number>(parseInt(currentToken.value)));
+                    advance();
+                    expectOperand = false;
+                    break;
+                case TokenKind::Identifier: {
+                    SymbolId name = currentToken.symbol;
+                    if (lexer.peekToken().kind != TokenKind::LParen) {
+                        operandStack.push_back(make<Variable>(name));
+                        advance();
+                        expectOperand = false;
+                        break;
+                    }
+                    advance(); // имя функции
+                    advance(); // '('
+                    if (currentToken.kind == TokenKind::RParen) {
+                        advance();
+                        operandStack.push_back(make<FunctionCall>(name, NodeList<Expression*>()));
+                        expectOperand = false;
+                        break;
+                    }
+                    operatorStack.push_back({PendingOp::Call, TokenKind::LParen, name, listScratch.size()});
+                    break;
+                }
+                case TokenKind::LParen:
+                    operatorStack.push_back({PendingOp::Paren, TokenKind::LParen, 0, 0});
+                    advance();
+                    break;
+                default:
+                    throw std::runtime_error("Ожидалось выражение");
+            }
+            continue;
+        }
+
+        int precedence = binaryPrecedence(currentToken.kind);
+        if (precedence > 0) {
+            while (operatorStack.size() > operatorBase &&
+                   operatorStack.back().kind == PendingOp::Binary &&
+                   binaryPrecedence(operatorStack.back().op) >= precedence) {
+                reduceBinary();
+            }
+            operatorStack.push_back({PendingOp::Binary, currentToken.kind, 0, 0});
+            advance();
+            expectOperand = true;
+            continue;
+        }
+
+        if (currentToken.kind != TokenKind::RParen && currentToken.kind != TokenKind::Comma) {
+            break;
+        }
+
+        while (operatorStack.size() > operatorBase && operatorStack.back().kind == PendingOp::Binary) {
+            reduceBinary();
+        }
+        if (operatorStack.size() == operatorBase) {
+            break;  // ')' или ',' принадлежат внешней конструкции
+        }
+
+        PendingOp open = operatorStack.back();
+        if (currentToken.kind == TokenKind::Comma) {
+            if (open.kind != PendingOp::Call) {
+                throw std::runtime_error("parseFactor(): Ожидалась ')'");
+            }
+            listScratch.push_back(operandStack.back());
+            operandStack.pop_back();
+            advance();
+            expectOperand = true;
+            continue;
+        }
+
+        operatorStack.pop_back();
+        advance(); // ')'
+        if (open.kind == PendingOp::Call) {
+            listScratch.push_back(operandStack.back());
+            operandStack.pop_back();
+            operandStack.push_back(make<FunctionCall>(open.callee, finishList<Expression>(open.argMark)));
+        }
     }
 
-    return left;
-}
-
-std::unique_ptr<Expression> Parser::parseTerm() {
-    auto left = parseFactor();
-
-    while (currentToken.value == "*" || currentToken.value == "/") {
-        std::string op = currentToken.value;
-        advance();
-        auto right = parseFactor();
-        left = std::make_unique<BinaryExpression>(op, std::move(left), std::move(right));
+    while (operatorStack.size() > operatorBase) {
+        if (operatorStack.back().kind == PendingOp::Paren) {
+            throw std::runtime_error("parseFactor(): Ожидалась ')'");
+        }
+        if (operatorStack.back().kind == PendingOp::Call) {
+            throw std::runtime_error("Ожидался знак ')'");
+        }
+        reduceBinary();
     }
 
-    return left;
+    Expression* result = operandStack.back();
+    operandStack.resize(operandBase);
+    return result;
 }
 
-std::unique_ptr<Expression> Parser::parseFactor() {
-    if (currentToken.type == TokenType::Number) {
-        int value = std::stoi(currentToken.value);
-        advance();
-        return std::make_unique<Number>(value);
-    }
-
-    if (currentToken.type == TokenType::Identifier) {
-        std::string name = currentToken.value;
-        try {
-            auto funcCall = parseFunctionCall();
-            return funcCall;
-        } catch (...) { }
+void Parser::reduceBinary() {
+    TokenKind op = operatorStack.back().op;
+    operatorStack.pop_back();
+    Expression* right = operandStack.back();
+    operandStack.pop_back();
+    Expression* left = operandStack.back();
 
-        return std::make_unique<Variable>(name);
-    }
-
-    if (currentToken.value == "(") {
-        advance();
-        auto expr = parseExpression();
-        if (currentToken.value != ")") throw std::runtime_error("parseFactor(): Ожидалась ')'");
-        advance();
-        return expr;
+    if (binaryPrecedence(op) == 1) {
+        operandStack.back() = make<Comparison>(TokenSpelling(op), left, right);
+    } else {
+        operandStack.back() = make<BinaryExpression>(TokenSpelling(op), left, right);
     }
-
-    throw std::runtime_error("Ожидалось выражение");
 }
 
-std::unique_ptr<Expression> Parser::parsePrimary() {
-    if (currentToken.type == TokenType::Number) {
-        int value = std::stoi(currentToken.value);
-        advance();
-        return std::make_unique<Number>(value);
-    }
-    if (currentToken.type == TokenType::Identifier) {
-        std::string name = currentToken.value;
-        advance();
-        return std::make_unique<Variable>(name);
+Expression* Parser::parsePrimary() {
+    switch (currentToken.kind) {
+        case TokenKind::Number: {
+            int value = parseInt(currentToken.value);
+            advance();
+            return make<Number>(value);
+        }
+        case TokenKind::Identifier: {
+            SymbolId name = currentToken.symbol;
+            advance();
+            return make<Variable>(name);
+        }
+        default:
+            throw std::runtime_error("Ожидалось число или переменная");
     }
-    throw std::runtime_error("Ожидалось число или переменная");
 }
\ No newline at end of file
@@ -7,42 +7,74 @@
 
 #include "../tokenization/tokenize.hpp"
 #include "ast.hpp"
+#include "flat_ast.hpp"
 
 class Parser {
 private:
     Lexer& lexer;
     Token currentToken;
 
+    Arena* arena = nullptr;                 // арена дерева, которое сейчас строится
+    std::vector<ASTNode*> listScratch;      // общий стек для сборки NodeList
+
+    /// Незакрытая конструкция на стеке операторов parseExpression.
+    struct PendingOp {
+        enum Kind { Binary, Paren, Call } kind;
+        TokenKind op;           // для Binary
+        SymbolId callee;        // для Call
+        size_t argMark;         // для Call: начало аргументов в listScratch
+    };
+    std::vector<Expression*> operandStack;
+    std::vector<PendingOp> operatorStack;
+
     void advance() { 
         currentToken = lexer.nextToken(); 
     }
 
+    template <class T, class... Args>
+    T* make(Args&&... args) {
+        return arena->Make<T>(std::forward<Args>(args)...);
+    }
+
+    /// Переносит элементы стека, начиная с `mark`, в массив арены.
+    template <class T>
+    NodeList<T*> finishList(size_t mark) {
+        size_t count = listScratch.size() - mark;
+        T** items = static_cast<T**>(arena->Allocate(sizeof(T*) * count, alignof(T*)));
+        for (size_t i = 0; i < count; ++i) {
+            items[i] = static_cast<T*>(listScratch[mark + i]);
+        }
+        listScratch.resize(mark);
+        return NodeList<T*>(count == 0 ? nullptr : items, static_cast<uint32_t>(count));
+    }
+
     std::unique_ptr<ProgramBlocks> parseProgramBlocks();
-    std::unique_ptr<ProgramBlock> parseProgramBlock();
+    ProgramBlock* parseProgramBlock();
 
-    std::unique_ptr<StatementList> parseStatementList();
-    std::unique_ptr<FunctionDeclaration> parseFunctionDeclaration();
-    std::unique_ptr<Statement> parseStatement();
+    StatementList* parseStatementList();
+    FunctionDeclaration* parseFunctionDeclaration();
+    Statement* parseStatement();
 
-    std::unique_ptr<Parameter> parseParameter();
-    std::unique_ptr<Type> parseType();
+    Parameter* parseParameter();
+    Type* parseType();
     
-    std::unique_ptr<IfStatement> parseIfStatement();
-    std::unique_ptr<Statement> parseDeclaration();
-    std::unique_ptr<Statement> parsePrintStatement();
-    std::unique_ptr<Statement> parseAssignment();
-    std::unique_ptr<Statement> parseReturnStatement();
+    IfStatement* parseIfStatement();
+    Statement* parseDeclaration();
+    Statement* parsePrintStatement();
+    Statement* parseAssignment();
+    Statement* parseReturnStatement();
 
-    std::unique_ptr<Expression> parseExpression();
-    std::unique_ptr<Expression> parseSubAdd();
-    std::unique_ptr<Expression> parseTerm();
-    std::unique_ptr<Expression> parseFactor();
-    std::unique_ptr<Expression> parseFunctionCall();
-    std::unique_ptr<Expression> parsePrimary();
+    Expression* parseExpression();
+    Expression* parsePrimary();
+    void reduceBinary();
 
 
 public:
     Parser(Lexer& lex) : lexer(lex) { advance(); }
 
     std::unique_ptr<ProgramBlocks> parse();
+
+    /// Разбор сразу в плоское представление: каждый блок верхнего уровня
+    /// строится во временной арене, переводится в `out`, и арена переиспользуется.
+    void parseFlat(FlatAst& out);
 };
@@ -0,0 +1,127 @@
+#include "ast_cloner.hpp"
+
+#include <vector>
+
+#include "../parsing/ast.hpp"
+
+Expression* AstCloner::Clone(Expression* expression) {
+    expression->Accept(this);
+    return expression_;
+}
+
+Statement* AstCloner::Clone(Statement* statement) {
+    statement->Accept(this);
+    return statement_;
+}
+
+FunctionDeclaration* AstCloner::Clone(FunctionDeclaration* func, SymbolId name) {
+    std::vector<Parameter*> params;
+    params.reserve(func->params.size());
+    for (Parameter* param : func->params) {
+        params.push_back(arena_.Make<Parameter>(Rename(param->name), arena_.Make<Type>(param->type->type)));
+    }
+    auto* body = static_cast<StatementList*>(Clone(func->body));
+    return arena_.Make<FunctionDeclaration>(name, arena_.MakeList(params.data(), params.size()), body,
+                                            arena_.Make<Type>(func->returnType->type));
+}
+
+SymbolId AstCloner::Rename(SymbolId name) const {
+    auto it = renames_.find(name);
+    return it != renames_.end() ? it->second : name;
+}
+
+void AstCloner::Visit(ASTNode* node) {
+    // cannot go here
+}
+
+void AstCloner::Visit(std::string& program) {
+}
+
+void AstCloner::Visit(ProgramBlocks* programBlocks) {
+    // cannot go here
+}
+
+void AstCloner::Visit(ProgramBlock* programBlock) {
+    // cannot go here
+}
+
+void AstCloner::Visit(FunctionDeclaration* func) {
+    // копируется через Clone(func, name)
+}
+
+void AstCloner::Visit(Parameter* parameter) {
+}
+
+void AstCloner::Visit(Type* type) {
+}
+
+void AstCloner::Visit(StatementList* statementList) {
+    std::vector<Statement*> statements;
+    statements.reserve(statementList->statements.size());
+    for (Statement* statement : statementList->statements) {
+        statements.push_back(Clone(statement));
+    }
+    statement_ = arena_.Make<StatementList>(arena_.MakeList(statements.data(), statements.size()));
+}
+
+void AstCloner::Visit(Statement* statement) {
+    // cannot go here
+}
+
+void AstCloner::Visit(Assignment* assignment) {
+    auto* copy = arena_.Make<Assignment>(Rename(assignment->variable), Clone(assignment->expression));
+    copy->inlinedReturn = assignment->inlinedReturn;
+    statement_ = copy;
+}
+
+void AstCloner::Visit(Declaration* declaration) {
+    statement_ = arena_.Make<Declaration>(Rename(declaration->varName));
+}
+
+void AstCloner::Visit(PrintStatement* printStatement) {
+    statement_ = arena_.Make<PrintStatement>(Clone(printStatement->expression));
+}
+
+void AstCloner::Visit(ReturnStatement* returnStatement) {
+    statement_ = arena_.Make<ReturnStatement>(Clone(returnStatement->expression));
+}
+
+void AstCloner::Visit(IfStatement* statement) {
+    Expression* condition = Clone(statement->condition);
+    Statement* thenBranch = Clone(statement->thenBranch);
+    Statement* elseBranch = statement->elseBranch != nullptr ? Clone(statement->elseBranch) : nullptr;
+    statement_ = arena_.Make<IfStatement>(condition, thenBranch, elseBranch);
+}
+
+void AstCloner::Visit(Expression* expression) {
+    // cannot go here
+}
+
+void AstCloner::Visit(Number* expression) {
+    expression_ = arena_.Make<Number>(expression->value);
+}
+
+void AstCloner::Visit(Variable* expression) {
+    expression_ = arena_.Make<Variable>(Rename(expression->name));
+}
+
+void AstCloner::Visit(BinaryExpression* expression) {
+    Expression* left = Clone(expression->left);
+    Expression* right = Clone(expression->right);
+    expression_ = arena_.Make<BinaryExpression>(expression->op, left, right);
+}
+
+void AstCloner::Visit(Comparison* expression) {
+    Expression* left = Clone(expression->left);
+    Expression* right = Clone(expression->right);
+    expression_ = arena_.Make<Comparison>(expression->op, left, right);
+}
+
+void AstCloner::Visit(FunctionCall* functionCall) {
+    std::vector<Expression*> args;
+    args.reserve(functionCall->args.size());
+    for (Expression* arg : functionCall->args) {
+        args.push_back(Clone(arg));
+    }
+    expression_ = arena_.Make<FunctionCall>(functionCall->name, arena_.MakeList(args.data(), args.size()));
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <unordered_map>
+
+#include "../tokenization/interner.hpp"
+#include "../visitors/visitor.hpp"
+
+class Arena;
+
+/// Глубокая копия функций, операторов и выражений в арене программы.
+/// Имена переменных (параметры, присваивания, объявления, чтения)
+/// переводятся через `renames`, имена вне таблицы остаются прежними.
+/// Слоты и цели вызовов не копируются: их заново заполнят Resolver
+/// и Interpreter.
+class AstCloner : public Visitor {
+public:
+    AstCloner(Arena& arena, const std::unordered_map<SymbolId, SymbolId>& renames) :
+        arena_(arena), renames_(renames) {}
+
+    Expression* Clone(Expression* expression);
+    Statement* Clone(Statement* statement);
+    /// Копия функции под новым именем `name`.
+    FunctionDeclaration* Clone(FunctionDeclaration* func, SymbolId name);
+
+    void Visit(ASTNode* node) override;
+    void Visit(std::string& program) override;
+
+    void Visit(ProgramBlocks* programBlocks) override;
+    void Visit(ProgramBlock* programBlock) override;
+
+    void Visit(FunctionDeclaration* func) override;
+    void Visit(Parameter* parameter) override;
+    void Visit(Type* type) override;
+
+    void Visit(StatementList* statementList) override;
+
+    void Visit(Statement* statement) override;
+    void Visit(Assignment* assignment) override;
+    void Visit(Declaration* declaration) override;
+    void Visit(PrintStatement* printStatement) override;
+    void Visit(ReturnStatement* returnStatement) override;
+    void Visit(IfStatement* statement) override;
+
+    void Visit(Expression* expression) override;
+    void Visit(Number* expression) override;
+    void Visit(Variable* expression) override;
+    void Visit(BinaryExpression* expression) override;
+    void Visit(Comparison* expression) override;
+    void Visit(FunctionCall* functionCall) override;
+
+private:
+    SymbolId Rename(SymbolId name) const;
+
+    Arena& arena_;
+    const std::unordered_map<SymbolId, SymbolId>& renames_;
+    Expression* expression_ = nullptr;      // результат Visit для выражений
+    Statement* statement_ = nullptr;        // результат Visit для операторов
+};
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class ProgramBlocks;
+
+/// Оптимизирующий проход по AST, который запускается между разбором
+/// и любым движком исполнения или кодогенерацией. Проход переписывает
+/// дерево на месте; новые узлы берутся из арены ProgramBlocks.
+/// Наблюдаемое поведение программы (вывод, сообщения об ошибках,
+/// результаты вызовов) проход сохранять обязан.
+class AstPass {
+public:
+    virtual ~AstPass() = default;
+    virtual const char* Name() const = 0;
+    /// Возвращает число сделанных изменений (свёрток, замен, удалений).
+    virtual size_t Run(ProgramBlocks* program) = 0;
+
+    /// Подробности последнего запуска по строке на событие (например,
+    /// какие вызовы встроены); печатаются вместе с --pass-stats.
+    const std::vector<std::string>& Remarks() const { return remarks_; }
+
+protected:
+    std::vector<std::string> remarks_;
+};
@@ -0,0 +1,99 @@
+#include "ast_walker.hpp"
+
+#include "../parsing/ast.hpp"
+
+Expression* AstWalker::Rewrite(Expression* expression) {
+    replacement_ = nullptr;
+    expression->Accept(this);
+    Expression* result = replacement_ != nullptr ? replacement_ : expression;
+    replacement_ = nullptr;
+    return result;
+}
+
+void AstWalker::Visit(ASTNode* node) {
+    // cannot go here
+}
+
+void AstWalker::Visit(std::string& program) {
+}
+
+void AstWalker::Visit(ProgramBlocks* programBlocks) {
+    for (ProgramBlock* block : programBlocks->blocks) {
+        if (block->function != nullptr) {
+            block->function->Accept(this);
+        }
+    }
+}
+
+void AstWalker::Visit(ProgramBlock* programBlock) {
+    // cannot go here
+}
+
+void AstWalker::Visit(FunctionDeclaration* func) {
+    func->body->Accept(this);
+}
+
+void AstWalker::Visit(Parameter* parameter) {
+}
+
+void AstWalker::Visit(Type* type) {
+}
+
+void AstWalker::Visit(StatementList* statementList) {
+    for (Statement* statement : statementList->statements) {
+        statement->Accept(this);
+    }
+}
+
+void AstWalker::Visit(Statement* statement) {
+    // cannot go here
+}
+
+void AstWalker::Visit(Assignment* assignment) {
+    assignment->expression = Rewrite(assignment->expression);
+}
+
+void AstWalker::Visit(Declaration* declaration) {
+}
+
+void AstWalker::Visit(PrintStatement* printStatement) {
+    printStatement->expression = Rewrite(printStatement->expression);
+}
+
+void AstWalker::Visit(ReturnStatement* returnStatement) {
+    returnStatement->expression = Rewrite(returnStatement->expression);
+}
+
+void AstWalker::Visit(IfStatement* statement) {
+    statement->condition = Rewrite(statement->condition);
+    statement->thenBranch->Accept(this);
+    if (statement->elseBranch != nullptr) {
+        statement->elseBranch->Accept(this);
+    }
+}
+
+void AstWalker::Visit(Expression* expression) {
+    // cannot go here
+}
+
+void AstWalker::Visit(Number* expression) {
+}
+
+void AstWalker::Visit(Variable* expression) {
+}
+
+void AstWalker::Visit(BinaryExpression* expression) {
+    expression->left = Rewrite(expression->left);
+    expression->right = Rewrite(expression->right);
+}
+
+void AstWalker::Visit(Comparison* expression) {
+    expression->left = Rewrite(expression->left);
+    expression->right = Rewrite(expression->right);
+}
+
+void AstWalker::Visit(FunctionCall* functionCall) {
+    for (Expression*& arg : functionCall->args) {
+        arg = Rewrite(arg);
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "../visitors/visitor.hpp"
+
+/// Основа для проходов по AST: по умолчанию обходит все функции
+/// программы и каждое выражение пропускает через Rewrite, поэтому
+/// наследнику достаточно переопределить Visit для интересных узлов.
+/// Операторы верхнего уровня не исполняются и не обходятся.
+///
+/// Узел выражения заменяется так: его Visit вызывает Replace(новый узел),
+/// а Rewrite у родителя подставляет замену на место старого узла.
+class AstWalker : public Visitor {
+public:
+    void Visit(ASTNode* node) override;
+    void Visit(std::string& program) override;
+
+    void Visit(ProgramBlocks* programBlocks) override;
+    void Visit(ProgramBlock* programBlock) override;
+
+    void Visit(FunctionDeclaration* func) override;
+    void Visit(Parameter* parameter) override;
+    void Visit(Type* type) override;
+
+    void Visit(StatementList* statementList) override;
+
+    void Visit(Statement* statement) override;
+    void Visit(Assignment* assignment) override;
+    void Visit(Declaration* declaration) override;
+    void Visit(PrintStatement* printStatement) override;
+    void Visit(ReturnStatement* returnStatement) override;
+    void Visit(IfStatement* statement) override;
+
+    void Visit(Expression* expression) override;
+    void Visit(Number* expression) override;
+    void Visit(Variable* expression) override;
+    void Visit(BinaryExpression* expression) override;
+    void Visit(Comparison* expression) override;
+    void Visit(FunctionCall* functionCall) override;
+
+protected:
+    /// Обходит выражение и возвращает узел, который должен стоять на его месте.
+    Expression* Rewrite(Expression* expression);
+    void Replace(Expression* replacement) { replacement_ = replacement; }
+
+private:
+    Expression* replacement_ = nullptr;
+};
@@ -0,0 +1,85 @@
+#include "call_graph.hpp"
+
+#include <algorithm>
+
+#include "../parsing/ast.hpp"
+
+void CallNames::Visit(ReturnStatement* returnStatement) {
+    tailCall_ = skipTailCalls_ ? returnStatement->tailCall : nullptr;
+    AstWalker::Visit(returnStatement);
+    tailCall_ = nullptr;
+}
+
+void CallNames::Visit(FunctionCall* functionCall) {
+    if (functionCall != tailCall_) {
+        calls.push_back(functionCall->name);
+    }
+    AstWalker::Visit(functionCall);
+}
+
+std::vector<uint32_t> BottomUpOrder(const std::vector<std::vector<uint32_t>>& edges, std::vector<char>& recursive) {
+    const size_t count = edges.size();
+    recursive.assign(count, 0);
+    for (uint32_t v = 0; v < count; ++v) {
+        for (uint32_t w : edges[v]) {
+            recursive[v] = recursive[v] || w == v;
+        }
+    }
+
+    // алгоритм Тарьяна без рекурсии: цепочки вызовов бывают длинными
+    constexpr uint32_t kUnvisited = UINT32_MAX;
+    std::vector<uint32_t> number(count, kUnvisited);
+    std::vector<uint32_t> low(count);
+    std::vector<char> onStack(count);
+    std::vector<uint32_t> stack;
+    std::vector<std::pair<uint32_t, size_t>> work;     // функция и следующее ребро
+    std::vector<uint32_t> order;
+    order.reserve(count);
+    uint32_t counter = 0;
+
+    auto open = [&](uint32_t v) {
+        number[v] = low[v] = counter++;
+        stack.push_back(v);
+        onStack[v] = 1;
+        work.push_back({v, 0});
+    };
+    for (uint32_t root = 0; root < count; ++root) {
+        if (number[root] != kUnvisited) {
+            continue;
+        }
+        open(root);
+        while (!work.empty()) {
+            uint32_t v = work.back().first;
+            size_t& next = work.back().second;
+            if (next < edges[v].size()) {
+                uint32_t w = edges[v][next++];
+                if (number[w] == kUnvisited) {
+                    open(w);
+                } else if (onStack[w]) {
+                    low[v] = std::min(low[v], number[w]);
+                }
+                continue;
+            }
+            work.pop_back();
+            if (!work.empty()) {
+                uint32_t parent = work.back().first;
+                low[parent] = std::min(low[parent], low[v]);
+            }
+            if (low[v] != number[v]) {
+                continue;
+            }
+            size_t begin = stack.size();
+            do {
+                --begin;
+            } while (stack[begin] != v);
+            bool cycle = stack.size() - begin > 1;
+            for (size_t k = begin; k < stack.size(); ++k) {
+                onStack[stack[k]] = 0;
+                recursive[stack[k]] = recursive[stack[k]] || cycle;
+                order.push_back(stack[k]);
+            }
+            stack.resize(begin);
+        }
+    }
+    return order;
+}
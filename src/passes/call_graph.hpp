@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "ast_walker.hpp"
+#include "../tokenization/interner.hpp"
+
+/// Имена функций, которые вызываются из тела. С `skipTailCalls` -
+/// без хвостовых вызовов (ReturnStatement::tailCall, их находит Resolver).
+class CallNames : public AstWalker {
+public:
+    explicit CallNames(bool skipTailCalls = false) : skipTailCalls_(skipTailCalls) {}
+
+    std::vector<SymbolId> calls;
+
+    void Visit(ReturnStatement* returnStatement) override;
+    void Visit(FunctionCall* functionCall) override;
+
+private:
+    bool skipTailCalls_;
+    const FunctionCall* tailCall_ = nullptr;
+};
+
+/// Компоненты сильной связности графа вызовов `edges` (номера вызываемых
+/// функций для каждой функции): номера функций так, что вызываемые идут
+/// раньше вызывающих. `recursive[i]` - функция i вызывает себя, прямо
+/// или через другие функции.
+std::vector<uint32_t> BottomUpOrder(const std::vector<std::vector<uint32_t>>& edges, std::vector<char>& recursive);
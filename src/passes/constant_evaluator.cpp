@@ -0,0 +1,227 @@
+#include "constant_evaluator.hpp"
+
+#include "constant_folding.hpp"
+#include "../parsing/ast.hpp"
+
+namespace {
+
+/// Вызов ли выражение; вглубь не заходит.
+class CallProbe : public AstWalker {
+public:
+    FunctionCall* call = nullptr;
+
+    void Visit(Number* expression) override { call = nullptr; }
+    void Visit(Variable* expression) override { call = nullptr; }
+    void Visit(BinaryExpression* expression) override { call = nullptr; }
+    void Visit(Comparison* expression) override { call = nullptr; }
+    void Visit(FunctionCall* functionCall) override { call = functionCall; }
+};
+
+} // namespace
+
+std::optional<Evaluation> ConstantEvaluator::Call(FunctionDeclaration* func, const std::vector<int>& args,
+                                                 size_t maxOutput) {
+    max_output_ = maxOutput;
+    variables_.clear();
+    frame_ = 0;
+    depth_ = 0;
+    output_.clear();
+    returning_ = false;
+    calced_known_ = !args.empty();
+    calced_ = calced_known_ ? args.back() : 0;
+    try {
+        RunFrame(func, args);
+    } catch (const Failure&) {
+        return std::nullopt;
+    }
+    if (!calced_known_) {
+        return std::nullopt;
+    }
+    return Evaluation{calced_, last_returned_, std::move(output_)};
+}
+
+void ConstantEvaluator::Step() {
+    if (fuel_ == 0) {
+        throw Failure{};
+    }
+    --fuel_;
+}
+
+void ConstantEvaluator::Emit(EvaluationEvent::Kind kind, int value) {
+    if (output_.size() >= max_output_) {
+        throw Failure{};
+    }
+    output_.push_back({kind, value});
+}
+
+int ConstantEvaluator::Value(Expression* expression) {
+    expression->Accept(this);
+    if (!calced_known_) {
+        throw Failure{};
+    }
+    return calced_;
+}
+
+int* ConstantEvaluator::Find(SymbolId name) {
+    for (size_t i = frame_; i < variables_.size(); ++i) {
+        if (variables_[i].first == name) {
+            return &variables_[i].second;
+        }
+    }
+    return nullptr;
+}
+
+void ConstantEvaluator::Set(SymbolId name, int value) {
+    if (int* variable = Find(name)) {
+        *variable = value;
+    } else {
+        variables_.push_back({name, value});
+    }
+}
+
+void ConstantEvaluator::RunFrame(FunctionDeclaration* func, const std::vector<int>& args) {
+    if (depth_ >= kMaxDepth) {
+        throw Failure{};
+    }
+    ++depth_;
+    size_t savedFrame = frame_;
+    frame_ = variables_.size();
+    BindParams(func, args);
+    func->body->Accept(this);
+    size_t tailCalls = 0;
+    while (tail_call_ != nullptr) {
+        func = tail_call_;
+        tail_call_ = nullptr;
+        returning_ = false;
+        ++tailCalls;
+        func->body->Accept(this);
+    }
+    last_returned_ = returning_ || tailCalls > 0;
+    returning_ = false;
+    if (tailCalls > 0 && !calced_known_) {
+        throw Failure{};
+    }
+    for (; tailCalls > 0; --tailCalls) {
+        Emit(EvaluationEvent::Return, calced_);
+    }
+    variables_.resize(frame_);
+    frame_ = savedFrame;
+    --depth_;
+}
+
+FunctionDeclaration* ConstantEvaluator::Callee(FunctionCall* functionCall, std::vector<int>& args) {
+    auto it = functions_.find(functionCall->name);
+    if (it == functions_.end() || it->second->params.size() != functionCall->args.size()) {
+        throw Failure{};
+    }
+    args.reserve(functionCall->args.size());
+    for (Expression* arg : functionCall->args) {
+        args.push_back(Value(arg));
+    }
+    return it->second;
+}
+
+void ConstantEvaluator::BindParams(FunctionDeclaration* func, const std::vector<int>& args) {
+    // повторяющийся параметр получает последний аргумент, как и в Interpreter
+    for (size_t i = 0; i < args.size(); ++i) {
+        Set(func->params[i]->name, args[i]);
+    }
+}
+
+void ConstantEvaluator::Visit(StatementList* statementList) {
+    for (Statement* statement : statementList->statements) {
+        Step();
+        statement->Accept(this);
+        if (returning_) {
+            break;
+        }
+    }
+}
+
+void ConstantEvaluator::Visit(Assignment* assignment) {
+    int value = Value(assignment->expression);
+    if (assignment->inlinedReturn) {
+        Emit(EvaluationEvent::Return, value);
+    }
+    Set(assignment->variable, value);
+}
+
+void ConstantEvaluator::Visit(Declaration* declaration) {
+    // уже определённая переменная - ошибка Interpreter
+    if (Find(declaration->varName) != nullptr) {
+        throw Failure{};
+    }
+    variables_.push_back({declaration->varName, 0});
+}
+
+void ConstantEvaluator::Visit(PrintStatement* printStatement) {
+    Emit(EvaluationEvent::Print, Value(printStatement->expression));
+}
+
+void ConstantEvaluator::Visit(ReturnStatement* returnStatement) {
+    CallProbe probe;
+    returnStatement->expression->Accept(&probe);
+    if (probe.call == nullptr) {
+        Emit(EvaluationEvent::Return, Value(returnStatement->expression));
+        returning_ = true;
+        return;
+    }
+    // хвостовой вызов: строку "expression = v" добавит RunFrame
+    Step();
+    std::vector<int> args;
+    tail_call_ = Callee(probe.call, args);
+    variables_.resize(frame_);
+    BindParams(tail_call_, args);
+    returning_ = true;
+}
+
+void ConstantEvaluator::Visit(IfStatement* statement) {
+    if (Value(statement->condition)) {
+        statement->thenBranch->Accept(this);
+    } else if (statement->elseBranch != nullptr) {
+        statement->elseBranch->Accept(this);
+    }
+}
+
+void ConstantEvaluator::Visit(Number* expression) {
+    Step();
+    SetCalced(expression->value);
+}
+
+void ConstantEvaluator::Visit(Variable* expression) {
+    Step();
+    int* variable = Find(expression->name);
+    if (variable == nullptr) {
+        throw Failure{};
+    }
+    SetCalced(*variable);
+}
+
+void ConstantEvaluator::Visit(BinaryExpression* expression) {
+    Step();
+    int left = Value(expression->left);
+    int right = Value(expression->right);
+    std::optional<int> value = ConstantFolding::EvaluateBinary(expression->op, left, right);
+    if (!value) {
+        throw Failure{};
+    }
+    SetCalced(*value);
+}
+
+void ConstantEvaluator::Visit(Comparison* expression) {
+    Step();
+    int left = Value(expression->left);
+    int right = Value(expression->right);
+    std::optional<int> value = ConstantFolding::EvaluateComparison(expression->op, left, right);
+    if (!value) {
+        throw Failure{};
+    }
+    SetCalced(*value);
+}
+
+void ConstantEvaluator::Visit(FunctionCall* functionCall) {
+    Step();
+    std::vector<int> args;
+    FunctionDeclaration* func = Callee(functionCall, args);
+    RunFrame(func, args);
+}
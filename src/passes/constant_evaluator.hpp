@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "ast_walker.hpp"
+#include "../tokenization/interner.hpp"
+
+/// Строка вывода, которую напечатал бы Interpreter: print(v) - "v",
+/// return или Assignment::inlinedReturn - "expression = v".
+struct EvaluationEvent {
+    enum Kind { Print, Return } kind;
+    int value;
+};
+
+/// Итог вызова функции во время компиляции.
+struct Evaluation {
+    int value;                              // результат вызова
+    bool returned;                          // тело закончилось return
+    std::vector<EvaluationEvent> output;    // в порядке печати
+};
+
+/// Встроенный вычислитель для проходов: исполняет функции программы
+/// по правилам Interpreter (кадр на вызов, "последнее значение",
+/// арифметика по модулю 2^32), но ничего не печатает, а записывает вывод.
+/// Вычисление бросается, если Interpreter напечатал бы ошибку (чтение
+/// неопределённой переменной, повторный declare, неизвестная функция,
+/// неверное число аргументов), если понадобилось неизвестное
+/// "последнее значение" вызывающей функции, при делении на 0
+/// и INT_MIN / -1, а также когда кончилось топливо (число посещённых
+/// узлов), глубина вызовов или место для вывода. Хвостовые вызовы
+/// (`return f(...)`) исполняются в том же кадре, как и в Interpreter.
+class ConstantEvaluator : private AstWalker {
+public:
+    /// `functions` - функции, которые найдёт Interpreter, по имени.
+    ConstantEvaluator(const std::unordered_map<SymbolId, FunctionDeclaration*>& functions, uint64_t fuel) :
+        functions_(functions), fuel_(fuel) {}
+
+    /// Вызов `func` с аргументами-числами; без аргументов "последнее
+    /// значение" при входе неизвестно. nullopt - вычислить не удалось
+    /// или вывод длиннее `maxOutput` строк.
+    std::optional<Evaluation> Call(FunctionDeclaration* func, const std::vector<int>& args, size_t maxOutput);
+
+    uint64_t FuelLeft() const { return fuel_; }
+
+private:
+    static constexpr size_t kMaxDepth = 2000;
+
+    /// Бросается, когда вычисление надо прекратить.
+    struct Failure {};
+
+    void Visit(StatementList* statementList) override;
+    void Visit(Assignment* assignment) override;
+    void Visit(Declaration* declaration) override;
+    void Visit(PrintStatement* printStatement) override;
+    void Visit(ReturnStatement* returnStatement) override;
+    void Visit(IfStatement* statement) override;
+
+    void Visit(Number* expression) override;
+    void Visit(Variable* expression) override;
+    void Visit(BinaryExpression* expression) override;
+    void Visit(Comparison* expression) override;
+    void Visit(FunctionCall* functionCall) override;
+
+    /// Тратит единицу топлива.
+    void Step();
+    void Emit(EvaluationEvent::Kind kind, int value);
+    /// Вычисляет выражение; его значение должно быть известно.
+    int Value(Expression* expression);
+    /// Исполняет тело (и тела хвостовых вызовов) в новом кадре с уже
+    /// вычисленными параметрами.
+    void RunFrame(FunctionDeclaration* func, const std::vector<int>& args);
+    /// Вызываемая функция и значения аргументов в текущем кадре.
+    FunctionDeclaration* Callee(FunctionCall* functionCall, std::vector<int>& args);
+    /// Кладёт параметры в текущий кадр.
+    void BindParams(FunctionDeclaration* func, const std::vector<int>& args);
+    /// Переменная текущего кадра или nullptr.
+    int* Find(SymbolId name);
+    void Set(SymbolId name, int value);
+    void SetCalced(int value) {
+        calced_ = value;
+        calced_known_ = true;
+    }
+
+    const std::unordered_map<SymbolId, FunctionDeclaration*>& functions_;
+    uint64_t fuel_;
+    size_t max_output_ = 0;
+    // переменные всех кадров подряд: в функции их немного, и поиск
+    // перебором дешевле, чем своя хэш-таблица на каждый вызов
+    std::vector<std::pair<SymbolId, int>> variables_;
+    size_t frame_ = 0;              // начало текущего кадра в variables_
+    size_t depth_ = 0;
+    std::vector<EvaluationEvent> output_;
+    int calced_ = 0;
+    bool calced_known_ = false;
+    bool returning_ = false;
+    FunctionDeclaration* tail_call_ = nullptr;     // чьё тело RunFrame исполняет следующим
+    bool last_returned_ = false;    // последний завершившийся кадр закончился return
+};
@@ -0,0 +1,94 @@
+#include "constant_folding.hpp"
+
+#include <climits>
+#include <cstdint>
+
+#include "../parsing/ast.hpp"
+
+size_t ConstantFolding::Run(ProgramBlocks* program) {
+    program_ = program;
+    folded_ = 0;
+    program->Accept(this);
+    return folded_;
+}
+
+size_t ConstantFolding::RunOnFunction(ProgramBlocks* program, FunctionDeclaration* func) {
+    program_ = program;
+    folded_ = 0;
+    func->Accept(this);
+    return folded_;
+}
+
+std::optional<int> ConstantFolding::EvaluateComparison(std::string_view op, int left, int right) {
+    switch (op[0]) {
+        case '<': return op.size() == 2 ? left <= right : left < right;
+        case '>': return op.size() == 2 ? left >= right : left > right;
+        case '=': return left == right;
+        case '!': return left != right;
+        default: return std::nullopt;
+    }
+}
+
+std::optional<int> ConstantFolding::EvaluateBinary(std::string_view op, int left, int right) {
+    uint32_t l = static_cast<uint32_t>(left);
+    uint32_t r = static_cast<uint32_t>(right);
+    switch (op[0]) {
+        case '+': return static_cast<int>(l + r);
+        case '-': return static_cast<int>(l - r);
+        case '*': return static_cast<int>(l * r);
+        case '/':
+            if (right == 0 || (left == INT_MIN && right == -1)) {
+                return std::nullopt;
+            }
+            return left / right;
+        default: return std::nullopt;
+    }
+}
+
+void ConstantFolding::Visit(Number* expression) {
+    is_const_ = true;
+    value_ = expression->value;
+}
+
+void ConstantFolding::Visit(Variable* expression) {
+    is_const_ = false;
+}
+
+void ConstantFolding::Visit(BinaryExpression* expression) {
+    expression->left = Rewrite(expression->left);
+    bool leftConst = is_const_;
+    int left = value_;
+    expression->right = Rewrite(expression->right);
+    std::optional<int> result;
+    if (leftConst && is_const_) {
+        result = EvaluateBinary(expression->op, left, value_);
+    }
+    is_const_ = result.has_value();
+    if (is_const_) {
+        value_ = *result;
+        Replace(program_->arena.Make<Number>(value_));
+        ++folded_;
+    }
+}
+
+void ConstantFolding::Visit(Comparison* expression) {
+    expression->left = Rewrite(expression->left);
+    bool leftConst = is_const_;
+    int left = value_;
+    expression->right = Rewrite(expression->right);
+    std::optional<int> result;
+    if (leftConst && is_const_) {
+        result = EvaluateComparison(expression->op, left, value_);
+    }
+    is_const_ = result.has_value();
+    if (is_const_) {
+        value_ = *result;
+        Replace(program_->arena.Make<Number>(value_));
+        ++folded_;
+    }
+}
+
+void ConstantFolding::Visit(FunctionCall* functionCall) {
+    AstWalker::Visit(functionCall);
+    is_const_ = false;
+}
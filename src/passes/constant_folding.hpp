@@ -0,0 +1,36 @@
+#pragma once
+
+#include <optional>
+#include <string_view>
+
+#include "ast_pass.hpp"
+#include "ast_walker.hpp"
+
+/// Сворачивает BinaryExpression и Comparison с двумя числовыми операндами
+/// в Number. Арифметика 32-битная с переполнением по модулю 2^32, как в
+/// сгенерированном LLVM-коде. Деление на 0 и INT_MIN / -1 не сворачиваются:
+/// их поведение во время исполнения остаётся прежним.
+class ConstantFolding : public AstPass, private AstWalker {
+public:
+    const char* Name() const override { return "constant-folding"; }
+    size_t Run(ProgramBlocks* program) override;
+    /// То же для одной функции программы.
+    size_t RunOnFunction(ProgramBlocks* program, FunctionDeclaration* func);
+
+    /// Значение операции над двумя константами или nullopt, если её
+    /// нельзя свернуть.
+    static std::optional<int> EvaluateBinary(std::string_view op, int left, int right);
+    static std::optional<int> EvaluateComparison(std::string_view op, int left, int right);
+
+private:
+    void Visit(Number* expression) override;
+    void Visit(Variable* expression) override;
+    void Visit(BinaryExpression* expression) override;
+    void Visit(Comparison* expression) override;
+    void Visit(FunctionCall* functionCall) override;
+
+    ProgramBlocks* program_ = nullptr;
+    size_t folded_ = 0;
+    bool is_const_ = false;     // значение только что обойдённого выражения известно
+    int value_ = 0;
+};
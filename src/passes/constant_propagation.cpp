@@ -0,0 +1,140 @@
+#include "constant_propagation.hpp"
+
+#include "../parsing/ast.hpp"
+
+size_t ConstantPropagation::Run(ProgramBlocks* program) {
+    program_ = program;
+    replaced_ = 0;
+    program->Accept(this);
+    return replaced_;
+}
+
+size_t ConstantPropagation::RunOnFunction(ProgramBlocks* program, FunctionDeclaration* func,
+                                          const std::unordered_map<SymbolId, int>& entry) {
+    program_ = program;
+    replaced_ = 0;
+    entry_ = &entry;
+    func->Accept(this);
+    entry_ = nullptr;
+    return replaced_;
+}
+
+void ConstantPropagation::Visit(FunctionDeclaration* func) {
+    state_ = State{};
+    for (Parameter* param : func->params) {
+        state_.facts[param->name] = {Fact::Defined};
+    }
+    if (entry_ != nullptr) {
+        for (const auto& [name, value] : *entry_) {
+            state_.facts[name] = {Fact::Constant, value};
+        }
+    }
+    func->body->Accept(this);
+}
+
+void ConstantPropagation::Visit(Assignment* assignment) {
+    assignment->expression = Rewrite(assignment->expression);
+    SymbolId name = assignment->variable;
+    Fact fact{Fact::Defined};
+    if (shape_ == Shape::Number) {
+        fact = {Fact::Constant, value_};
+    } else if (shape_ == Shape::Variable && name_ != name && state_.facts.count(name_) != 0) {
+        fact = {Fact::Copy, 0, name_};
+    }
+    Kill(name);
+    state_.facts[name] = fact;
+}
+
+void ConstantPropagation::Visit(Declaration* declaration) {
+    // уже определённая переменная не меняется (во время исполнения - ошибка),
+    // иначе она становится нулём; в обоих случаях после declare она определена
+    state_.facts.try_emplace(declaration->varName, Fact{Fact::Defined});
+}
+
+void ConstantPropagation::Visit(ReturnStatement* returnStatement) {
+    AstWalker::Visit(returnStatement);
+    state_.reachable = false;
+}
+
+void ConstantPropagation::Visit(IfStatement* statement) {
+    statement->condition = Rewrite(statement->condition);
+    State before = state_;
+    statement->thenBranch->Accept(this);
+    if (statement->elseBranch != nullptr) {
+        State afterThen = std::move(state_);
+        state_ = std::move(before);
+        statement->elseBranch->Accept(this);
+        state_ = Merge(std::move(afterThen), state_);
+    } else {
+        state_ = Merge(std::move(state_), before);
+    }
+}
+
+void ConstantPropagation::Visit(Number* expression) {
+    shape_ = Shape::Number;
+    value_ = expression->value;
+}
+
+void ConstantPropagation::Visit(Variable* expression) {
+    shape_ = Shape::Variable;
+    name_ = expression->name;
+    auto it = state_.facts.find(expression->name);
+    if (it == state_.facts.end()) {
+        return;
+    }
+    const Fact& fact = it->second;
+    if (fact.kind == Fact::Constant) {
+        shape_ = Shape::Number;
+        value_ = fact.value;
+        Replace(program_->arena.Make<Number>(fact.value));
+        ++replaced_;
+    } else if (fact.kind == Fact::Copy) {
+        name_ = fact.source;
+        Replace(program_->arena.Make<Variable>(fact.source));
+        ++replaced_;
+    }
+}
+
+void ConstantPropagation::Visit(BinaryExpression* expression) {
+    AstWalker::Visit(expression);
+    shape_ = Shape::Other;
+}
+
+void ConstantPropagation::Visit(Comparison* expression) {
+    AstWalker::Visit(expression);
+    shape_ = Shape::Other;
+}
+
+void ConstantPropagation::Visit(FunctionCall* functionCall) {
+    AstWalker::Visit(functionCall);
+    shape_ = Shape::Other;
+}
+
+ConstantPropagation::State ConstantPropagation::Merge(State a, const State& b) {
+    if (!a.reachable) {
+        return b;
+    }
+    if (!b.reachable) {
+        return a;
+    }
+    for (auto it = a.facts.begin(); it != a.facts.end();) {
+        auto other = b.facts.find(it->first);
+        if (other == b.facts.end()) {
+            it = a.facts.erase(it);
+            continue;
+        }
+        if (!(it->second == other->second)) {
+            it->second = {Fact::Defined};
+        }
+        ++it;
+    }
+    return a;
+}
+
+void ConstantPropagation::Kill(SymbolId name) {
+    for (auto& [variable, fact] : state_.facts) {
+        if (fact.kind == Fact::Copy && fact.source == name) {
+            fact = {Fact::Defined};
+        }
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <unordered_map>
+
+#include "ast_pass.hpp"
+#include "ast_walker.hpp"
+#include "../tokenization/interner.hpp"
+
+/// Распространение констант и копий через присваивания внутри функции.
+/// После `x = 5;` чтения x заменяются на 5, после `y = x;` - чтения y на x,
+/// пока x и y не присвоены заново. Ветки if обрабатываются отдельно,
+/// после if остаются только факты, верные в обеих; ветка, закончившаяся
+/// return, в слиянии не участвует. Вызовы локальных переменных
+/// вызывающей функции не меняют (у каждого вызова свой кадр).
+///
+/// Копия заводится, только если источник точно определён: иначе чтение
+/// источника могло бы напечатать ошибку, которой раньше не было.
+class ConstantPropagation : public AstPass, private AstWalker {
+public:
+    const char* Name() const override { return "constant-propagation"; }
+    size_t Run(ProgramBlocks* program) override;
+    /// То же для одной функции; параметры из `entry` на входе в неё
+    /// считаются равными указанным числам (см. FunctionSpecialization).
+    size_t RunOnFunction(ProgramBlocks* program, FunctionDeclaration* func,
+                         const std::unordered_map<SymbolId, int>& entry = {});
+
+private:
+    /// Что известно о переменной в текущей точке. Отсутствие записи -
+    /// ничего не известно (переменная, возможно, не определена).
+    struct Fact {
+        enum Kind { Defined, Constant, Copy } kind;
+        int value = 0;          // для Constant
+        SymbolId source = 0;    // для Copy
+
+        bool operator==(const Fact& other) const {
+            return kind == other.kind && value == other.value && source == other.source;
+        }
+    };
+
+    struct State {
+        bool reachable = true;
+        std::unordered_map<SymbolId, Fact> facts;
+    };
+
+    void Visit(FunctionDeclaration* func) override;
+    void Visit(Assignment* assignment) override;
+    void Visit(Declaration* declaration) override;
+    void Visit(ReturnStatement* returnStatement) override;
+    void Visit(IfStatement* statement) override;
+    void Visit(Number* expression) override;
+    void Visit(Variable* expression) override;
+    void Visit(BinaryExpression* expression) override;
+    void Visit(Comparison* expression) override;
+    void Visit(FunctionCall* functionCall) override;
+
+    /// Факты, верные после обеих веток.
+    static State Merge(State a, const State& b);
+    /// Переменная `name` получила новое значение: копии из неё устарели.
+    void Kill(SymbolId name);
+
+    /// Во что превратилось только что обойдённое выражение.
+    enum class Shape { Other, Number, Variable };
+
+    ProgramBlocks* program_ = nullptr;
+    const std::unordered_map<SymbolId, int>* entry_ = nullptr;
+    State state_;
+    size_t replaced_ = 0;
+    Shape shape_ = Shape::Other;
+    int value_ = 0;             // для Shape::Number
+    SymbolId name_ = 0;         // для Shape::Variable
+};
@@ -0,0 +1,149 @@
+#include "dead_store_elimination.hpp"
+
+#include "definite_reads.hpp"
+#include "../parsing/ast.hpp"
+
+size_t DeadStoreElimination::Run(ProgramBlocks* program) {
+    removed_ = 0;
+    program->Accept(this);
+    return removed_;
+}
+
+void DeadStoreElimination::Visit(FunctionDeclaration* func) {
+    defined_reads_.clear();
+    DefiniteReads reads(defined_reads_);
+    func->Accept(&reads);
+
+    // после конца тела последнее значение становится результатом вызова
+    live_.clear();
+    overwrites_last_ = false;
+    func->body->Accept(this);
+}
+
+void DeadStoreElimination::Visit(StatementList* statementList) {
+    NodeList<Statement*>& statements = statementList->statements;
+    std::vector<bool> keep(statements.size(), true);
+    size_t kept = statements.size();
+    for (size_t i = statements.size(); i-- > 0;) {
+        removable_ = false;
+        statements[i]->Accept(this);
+        if (removable_) {
+            keep[i] = false;
+            --kept;
+        }
+    }
+    if (kept == statements.size()) {
+        return;
+    }
+    size_t out = 0;
+    for (size_t i = 0; i < statements.size(); ++i) {
+        if (keep[i]) {
+            statements[out++] = statements[i];
+        }
+    }
+    statements = NodeList<Statement*>(statements.begin(), static_cast<uint32_t>(kept));
+}
+
+void DeadStoreElimination::Visit(Assignment* assignment) {
+    bool dead = live_.count(assignment->variable) == 0 && overwrites_last_;
+    Inspect(assignment->expression);
+    // встроенный return печатает значение, такое присваивание не мёртвое
+    if (dead && pure_ && !assignment->inlinedReturn) {
+        removable_ = true;
+        ++removed_;
+        return;
+    }
+    live_.erase(assignment->variable);
+    MarkReadsLive();
+    overwrites_last_ = first_sets_last_;
+}
+
+void DeadStoreElimination::Visit(Declaration* declaration) {
+    live_.insert(declaration->varName);
+}
+
+void DeadStoreElimination::Visit(PrintStatement* printStatement) {
+    Inspect(printStatement->expression);
+    MarkReadsLive();
+    overwrites_last_ = first_sets_last_;
+}
+
+void DeadStoreElimination::Visit(ReturnStatement* returnStatement) {
+    Inspect(returnStatement->expression);
+    live_.clear();
+    MarkReadsLive();
+    overwrites_last_ = first_sets_last_;
+}
+
+void DeadStoreElimination::Visit(IfStatement* statement) {
+    auto liveAfter = live_;
+    bool overwritesAfter = overwrites_last_;
+    statement->thenBranch->Accept(this);
+    auto liveThen = std::move(live_);
+    live_ = std::move(liveAfter);
+    overwrites_last_ = overwritesAfter;
+    if (statement->elseBranch != nullptr) {
+        statement->elseBranch->Accept(this);
+    }
+    live_.insert(liveThen.begin(), liveThen.end());
+    Inspect(statement->condition);
+    MarkReadsLive();
+    overwrites_last_ = first_sets_last_;
+    removable_ = false;     // флаг остался от операторов внутри веток
+}
+
+void DeadStoreElimination::Inspect(Expression* expression) {
+    reads_.clear();
+    expression->Accept(this);
+}
+
+void DeadStoreElimination::MarkReadsLive() {
+    live_.insert(reads_.begin(), reads_.end());
+}
+
+void DeadStoreElimination::Visit(Number* expression) {
+    pure_ = true;
+    first_sets_last_ = true;
+    is_const_ = true;
+    value_ = expression->value;
+}
+
+void DeadStoreElimination::Visit(Variable* expression) {
+    reads_.push_back(expression->name);
+    // чтение неопределённой переменной печатает ошибку и не меняет последнее значение
+    bool defined = defined_reads_.count(expression) != 0;
+    pure_ = defined;
+    first_sets_last_ = defined;
+    is_const_ = false;
+}
+
+void DeadStoreElimination::Visit(BinaryExpression* expression) {
+    expression->left->Accept(this);
+    bool leftPure = pure_;
+    bool first = first_sets_last_;
+    expression->right->Accept(this);
+    bool safeDivisor = is_const_ && value_ != 0 && value_ != -1;
+    pure_ = leftPure && pure_ && (expression->op[0] != '/' || safeDivisor);
+    first_sets_last_ = first;
+    is_const_ = false;
+}
+
+void DeadStoreElimination::Visit(Comparison* expression) {
+    expression->left->Accept(this);
+    bool leftPure = pure_;
+    bool first = first_sets_last_;
+    expression->right->Accept(this);
+    pure_ = leftPure && pure_;
+    first_sets_last_ = first;
+    is_const_ = false;
+}
+
+void DeadStoreElimination::Visit(FunctionCall* functionCall) {
+    // вызов может не найти функцию и тогда вернёт последнее значение
+    for (Expression* arg : functionCall->args) {
+        arg->Accept(this);
+    }
+    pure_ = false;
+    first_sets_last_ = false;
+    is_const_ = false;
+}
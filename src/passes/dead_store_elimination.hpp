@@ -0,0 +1,60 @@
+#pragma once
+
+#include <unordered_set>
+#include <vector>
+
+#include "ast_pass.hpp"
+#include "ast_walker.hpp"
+#include "../tokenization/interner.hpp"
+
+/// Удаляет присваивания, значение которых никто не прочитает.
+/// `x = e;` убирается, только если одновременно:
+///  - x дальше в функции не читается и не объявляется (declare проверяет,
+///    определена ли переменная);
+///  - e чистое: числа, точно определённые переменные, арифметика и
+///    сравнения без вызовов и без деления на что-то, кроме ненулевой
+///    константы;
+///  - следующее исполняемое выражение сразу перезаписывает "последнее
+///    вычисленное значение": Interpreter возвращает его из функции без
+///    return и подставляет при ошибках, поэтому удалять присваивание,
+///    после которого это значение может понадобиться, нельзя.
+/// Сначала прямой обход отмечает точно определённые чтения, затем
+/// обратный обход каждой функции считает живые переменные.
+class DeadStoreElimination : public AstPass, private AstWalker {
+public:
+    const char* Name() const override { return "dead-store-elimination"; }
+    size_t Run(ProgramBlocks* program) override;
+
+private:
+    void Visit(FunctionDeclaration* func) override;
+    void Visit(StatementList* statementList) override;
+    void Visit(Assignment* assignment) override;
+    void Visit(Declaration* declaration) override;
+    void Visit(PrintStatement* printStatement) override;
+    void Visit(ReturnStatement* returnStatement) override;
+    void Visit(IfStatement* statement) override;
+
+    void Visit(Number* expression) override;
+    void Visit(Variable* expression) override;
+    void Visit(BinaryExpression* expression) override;
+    void Visit(Comparison* expression) override;
+    void Visit(FunctionCall* functionCall) override;
+
+    /// Обходит выражение: складывает прочитанные переменные в reads_
+    /// и заполняет pure_, first_sets_last_, is_const_.
+    void Inspect(Expression* expression);
+    void MarkReadsLive();
+
+    std::unordered_set<const Variable*> defined_reads_;     // чтения точно определённых переменных
+    std::unordered_set<SymbolId> live_;     // переменные, которые могут быть прочитаны дальше
+    bool overwrites_last_ = false;          // продолжение сразу перезаписывает последнее значение
+    bool removable_ = false;                // только что обойдённый оператор можно удалить
+    size_t removed_ = 0;
+    std::vector<SymbolId> reads_;
+
+    // свойства только что обойдённого выражения
+    bool pure_ = false;
+    bool first_sets_last_ = false;
+    bool is_const_ = false;
+    int value_ = 0;
+};
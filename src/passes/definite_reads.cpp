@@ -0,0 +1,57 @@
+#include "definite_reads.hpp"
+
+#include "../parsing/ast.hpp"
+
+void DefiniteReads::Visit(FunctionDeclaration* func) {
+    assigned_.clear();
+    reachable_ = true;
+    for (Parameter* param : func->params) {
+        assigned_.insert(param->name);
+    }
+    func->body->Accept(this);
+}
+
+void DefiniteReads::Visit(Assignment* assignment) {
+    AstWalker::Visit(assignment);
+    assigned_.insert(assignment->variable);
+}
+
+void DefiniteReads::Visit(Declaration* declaration) {
+    assigned_.insert(declaration->varName);
+}
+
+void DefiniteReads::Visit(ReturnStatement* returnStatement) {
+    AstWalker::Visit(returnStatement);
+    reachable_ = false;
+}
+
+void DefiniteReads::Visit(IfStatement* statement) {
+    statement->condition->Accept(this);
+    auto before = assigned_;
+    statement->thenBranch->Accept(this);
+    auto afterThen = std::move(assigned_);
+    bool thenReachable = reachable_;
+    assigned_ = std::move(before);
+    reachable_ = true;
+    if (statement->elseBranch != nullptr) {
+        statement->elseBranch->Accept(this);
+    }
+    // ветка, которая закончилась return, в слиянии не участвует
+    if (!thenReachable) {
+        return;
+    }
+    if (!reachable_) {
+        assigned_ = std::move(afterThen);
+        reachable_ = true;
+        return;
+    }
+    for (auto it = assigned_.begin(); it != assigned_.end();) {
+        it = afterThen.count(*it) != 0 ? std::next(it) : assigned_.erase(it);
+    }
+}
+
+void DefiniteReads::Visit(Variable* expression) {
+    if (assigned_.count(expression->name) != 0) {
+        out_.insert(expression);
+    }
+}
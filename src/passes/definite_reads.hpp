@@ -0,0 +1,29 @@
+#pragma once
+
+#include <unordered_set>
+
+#include "ast_walker.hpp"
+#include "../tokenization/interner.hpp"
+
+class Variable;
+
+/// Прямой обход функции: какие чтения переменных происходят там, где
+/// переменная точно определена (параметр, присвоена или объявлена на
+/// любом пути до этого места). Такое чтение никогда не печатает ошибку.
+/// Запускается на FunctionDeclaration: func->Accept(&reads).
+class DefiniteReads : public AstWalker {
+public:
+    explicit DefiniteReads(std::unordered_set<const Variable*>& out) : out_(out) {}
+
+    void Visit(FunctionDeclaration* func) override;
+    void Visit(Assignment* assignment) override;
+    void Visit(Declaration* declaration) override;
+    void Visit(ReturnStatement* returnStatement) override;
+    void Visit(IfStatement* statement) override;
+    void Visit(Variable* expression) override;
+
+private:
+    std::unordered_set<const Variable*>& out_;
+    std::unordered_set<SymbolId> assigned_;
+    bool reachable_ = true;
+};
@@ -0,0 +1,284 @@
+#include "inliner.hpp"
+
+#include <algorithm>
+#include <string>
+#include <unordered_set>
+
+#include "ast_cloner.hpp"
+#include "call_graph.hpp"
+#include "definite_reads.hpp"
+#include "node_counter.hpp"
+#include "../parsing/ast.hpp"
+
+namespace {
+
+/// Всё про тело функции, что нужно для проверки Inliner::CanInline
+/// и переименования её переменных.
+class BodyFacts : public AstWalker {
+public:
+    size_t returns = 0;
+    const ReturnStatement* lastReturn = nullptr;
+    size_t reads = 0;
+    std::unordered_map<SymbolId, int> declared;     // сколько раз объявлено имя
+    std::unordered_set<SymbolId> assigned;
+    std::vector<SymbolId> names;                    // все переменные, без повторов
+
+    void Visit(FunctionDeclaration* func) override {
+        for (Parameter* param : func->params) {
+            Name(param->name);
+        }
+        AstWalker::Visit(func);
+    }
+    void Visit(Assignment* assignment) override {
+        AstWalker::Visit(assignment);
+        assigned.insert(assignment->variable);
+        Name(assignment->variable);
+    }
+    void Visit(Declaration* declaration) override {
+        ++declared[declaration->varName];
+        Name(declaration->varName);
+    }
+    void Visit(ReturnStatement* returnStatement) override {
+        AstWalker::Visit(returnStatement);
+        ++returns;
+        lastReturn = returnStatement;
+    }
+    void Visit(Variable* expression) override {
+        ++reads;
+        Name(expression->name);
+    }
+
+private:
+    void Name(SymbolId name) {
+        if (seen_.insert(name).second) {
+            names.push_back(name);
+        }
+    }
+
+    std::unordered_set<SymbolId> seen_;
+};
+
+} // namespace
+
+size_t Inliner::Run(ProgramBlocks* program) {
+    remarks_.clear();
+    sites_ = 0;
+    arena_ = &program->arena;
+    functions_.clear();
+    callees_.clear();
+    by_name_.clear();
+    index_of_.clear();
+
+    // Interpreter находит функции, объявленные до запуска main
+    SymbolId mainName = Interner::Global().Intern("main");
+    bool seenMain = false;
+    for (ProgramBlock* block : program->blocks) {
+        if (block->function == nullptr) {
+            continue;
+        }
+        uint32_t index = static_cast<uint32_t>(functions_.size());
+        functions_.push_back(block->function);
+        Callee callee;
+        callee.visible = !seenMain;
+        callees_.push_back(callee);
+        by_name_[block->function->name].push_back(index);
+        index_of_[block->function] = index;
+        seenMain = seenMain || block->function->name == mainName;
+    }
+    for (size_t i = 0; i < functions_.size(); ++i) {
+        callees_[i].unique = by_name_[functions_[i]->name].size() == 1;
+    }
+
+    for (uint32_t index : BottomUpOrder()) {
+        caller_ = functions_[index];
+        caller_->Accept(this);
+        callees_[index].inlinable = CanInline(caller_);
+    }
+    return sites_;
+}
+
+std::vector<uint32_t> Inliner::BottomUpOrder() {
+    const size_t count = functions_.size();
+    std::vector<std::vector<uint32_t>> edges(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        CallNames names;
+        functions_[i]->Accept(&names);
+        for (SymbolId name : names.calls) {
+            auto it = by_name_.find(name);
+            if (it == by_name_.end()) {
+                continue;
+            }
+            edges[i].insert(edges[i].end(), it->second.begin(), it->second.end());
+        }
+    }
+
+    std::vector<char> recursive;
+    std::vector<uint32_t> order = ::BottomUpOrder(edges, recursive);
+    for (uint32_t i = 0; i < count; ++i) {
+        callees_[i].recursive = recursive[i];
+    }
+    return order;
+}
+
+bool Inliner::CanInline(FunctionDeclaration* func) const {
+    const Callee& info = callees_[index_of_.at(func)];
+    if (!info.unique || !info.visible || info.recursive) {
+        return false;
+    }
+    NodeList<Statement*> body = func->body->statements;
+    if (body.size() == 0 || NodeCounter().Count(func) > threshold_) {
+        return false;
+    }
+    BodyFacts facts;
+    func->Accept(&facts);
+    if (facts.returns != 1 || facts.lastReturn != body[body.size() - 1]) {
+        return false;
+    }
+    std::unordered_set<const Variable*> definite;
+    DefiniteReads reads(definite);
+    func->Accept(&reads);
+    if (definite.size() != facts.reads) {
+        return false;
+    }
+    for (const auto& [name, times] : facts.declared) {
+        if (times != 1 || facts.assigned.count(name) != 0) {
+            return false;
+        }
+        for (Parameter* param : func->params) {
+            if (param->name == name) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+FunctionDeclaration* Inliner::InlineTarget(Expression* expression) {
+    call_ = nullptr;
+    expression->Accept(this);
+    if (call_ == nullptr) {
+        return nullptr;
+    }
+    auto it = by_name_.find(call_->name);
+    if (it == by_name_.end() || it->second.size() != 1 || !callees_[it->second[0]].inlinable) {
+        return nullptr;
+    }
+    FunctionDeclaration* callee = functions_[it->second[0]];
+    // при несовпадении Interpreter печатает ошибку, такой вызов остаётся как есть
+    return callee->params.size() == call_->args.size() ? callee : nullptr;
+}
+
+SymbolId Inliner::Expand(FunctionCall* call, FunctionDeclaration* callee, std::optional<SymbolId> result) {
+    Interner& interner = Interner::Global();
+    size_t site = ++sites_;
+    std::string prefix = std::string(interner.Name(callee->name)) + ".";
+    std::string suffix = "." + std::to_string(site);
+
+    BodyFacts facts;
+    callee->Accept(&facts);
+    std::unordered_map<SymbolId, SymbolId> renames;
+    for (SymbolId name : facts.names) {
+        renames.emplace(name, interner.Intern(prefix + std::string(interner.Name(name)) + suffix));
+    }
+
+    // declare нужен LLVMCodeGenVisitor для alloca; у неопределённой переменной он молчит
+    std::unordered_set<SymbolId> declared;
+    for (Parameter* param : callee->params) {
+        SymbolId name = renames.at(param->name);
+        if (declared.insert(name).second) {
+            expansion_.push_back(arena_->Make<Declaration>(name));
+        }
+    }
+    for (size_t i = 0; i < call->args.size(); ++i) {
+        expansion_.push_back(arena_->Make<Assignment>(renames.at(callee->params[i]->name), call->args[i]));
+    }
+
+    AstCloner cloner(*arena_, renames);
+    NodeList<Statement*> body = callee->body->statements;
+    for (size_t i = 0; i + 1 < body.size(); ++i) {
+        expansion_.push_back(cloner.Clone(body[i]));
+    }
+    if (!result) {
+        result = interner.Intern(std::string(interner.Name(callee->name)) + suffix);
+        expansion_.push_back(arena_->Make<Declaration>(*result));
+    }
+    auto* ret = static_cast<ReturnStatement*>(body[body.size() - 1]);
+    auto* assignment = arena_->Make<Assignment>(*result, cloner.Clone(ret->expression));
+    assignment->inlinedReturn = true;
+    expansion_.push_back(assignment);
+
+    remarks_.push_back("inlined " + std::string(interner.Name(callee->name)) + " into " +
+                       std::string(interner.Name(caller_->name)) + " (site " + std::to_string(site) + ")");
+    return *result;
+}
+
+void Inliner::Visit(StatementList* statementList) {
+    std::vector<Statement*> statements;
+    statements.reserve(statementList->statements.size());
+    bool changed = false;
+    for (Statement* statement : statementList->statements) {
+        expansion_.clear();
+        statement->Accept(this);
+        if (expansion_.empty()) {
+            statements.push_back(statement);
+            continue;
+        }
+        statements.insert(statements.end(), expansion_.begin(), expansion_.end());
+        changed = true;
+    }
+    expansion_.clear();
+    if (changed) {
+        statementList->statements = arena_->MakeList(statements.data(), statements.size());
+    }
+}
+
+void Inliner::Visit(Assignment* assignment) {
+    if (FunctionDeclaration* callee = InlineTarget(assignment->expression)) {
+        Expand(call_, callee, assignment->variable);
+    }
+}
+
+void Inliner::Visit(PrintStatement* printStatement) {
+    if (FunctionDeclaration* callee = InlineTarget(printStatement->expression)) {
+        printStatement->expression = arena_->Make<Variable>(Expand(call_, callee, std::nullopt));
+        expansion_.push_back(printStatement);
+    }
+}
+
+void Inliner::Visit(ReturnStatement* returnStatement) {
+    if (FunctionDeclaration* callee = InlineTarget(returnStatement->expression)) {
+        returnStatement->expression = arena_->Make<Variable>(Expand(call_, callee, std::nullopt));
+        expansion_.push_back(returnStatement);
+    }
+}
+
+void Inliner::Visit(IfStatement* statement) {
+    // ветки - свои списки операторов, их вызовы встраиваются на месте
+    statement->thenBranch->Accept(this);
+    if (statement->elseBranch != nullptr) {
+        statement->elseBranch->Accept(this);
+    }
+    expansion_.clear();
+    if (FunctionDeclaration* callee = InlineTarget(statement->condition)) {
+        statement->condition = arena_->Make<Variable>(Expand(call_, callee, std::nullopt));
+        expansion_.push_back(statement);
+    }
+}
+
+// выражения только распознаются: встраивается лишь вызов на верхнем уровне
+
+void Inliner::Visit(Number* expression) {
+}
+
+void Inliner::Visit(Variable* expression) {
+}
+
+void Inliner::Visit(BinaryExpression* expression) {
+}
+
+void Inliner::Visit(Comparison* expression) {
+}
+
+void Inliner::Visit(FunctionCall* functionCall) {
+    call_ = functionCall;
+}
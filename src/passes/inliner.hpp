@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "ast_pass.hpp"
+#include "ast_walker.hpp"
+#include "../tokenization/interner.hpp"
+
+class Arena;
+
+/// Встраивает тела маленьких нерекурсивных функций в места вызова.
+/// Встраиваются только вызовы, которые стоят целым выражением оператора:
+///   x = f(a, b);  print(f(a));  return f(a);  if (f(a)) {...}
+/// Вызов заменяется на
+///   declare f.p.N; f.p.N = a; ...   параметры, аргументы по порядку
+///   <копия тела f без последнего return>
+///   x = e;                          e из `return e`, Assignment::inlinedReturn
+/// где локальные имена f получают суффикс ".N" номера места вызова
+/// (точка не встречается в именах из исходника). Для print, return и if
+/// значение сначала кладётся во временную переменную f.N.
+///
+/// Функция встраивается, если:
+///  - её имя объявлено один раз и до первого main (так её найдут
+///    и Interpreter, и LLVMCodeGenVisitor), и она не рекурсивна,
+///    в том числе через другие функции;
+///  - в ней не больше threshold узлов (см. NodeCounter);
+///  - единственный return - последний оператор тела: встроенный код
+///    продолжается дальше, раннего выхода у него нет;
+///  - все чтения переменных точно определены, а каждое declare объявляет
+///    имя, которое больше нигде не присваивается: сообщения об ошибках
+///    печатают имя переменной, а встроенная копия переименована.
+/// Функции обрабатываются снизу вверх по графу вызовов, так что в тело
+/// встраиваемой функции уже встроены её собственные маленькие вызовы.
+class Inliner : public AstPass, private AstWalker {
+public:
+    static constexpr size_t kDefaultThreshold = 40;
+
+    explicit Inliner(size_t threshold = kDefaultThreshold) : threshold_(threshold) {}
+
+    const char* Name() const override { return "inliner"; }
+    size_t Run(ProgramBlocks* program) override;
+
+private:
+    /// Что известно о функции как о кандидате на встраивание.
+    struct Callee {
+        bool unique = false;        // имя объявлено один раз
+        bool visible = false;       // объявлена не позже первого main
+        bool recursive = false;
+        bool inlinable = false;     // итог проверки, после обработки её собственных вызовов
+    };
+
+    /// Номера функций в порядке обработки: компоненты сильной связности
+    /// графа вызовов, вызываемые раньше вызывающих. Заполняет recursive.
+    std::vector<uint32_t> BottomUpOrder();
+    bool CanInline(FunctionDeclaration* func) const;
+    /// Функция, в которую встроится вызов, или nullptr.
+    FunctionDeclaration* InlineTarget(Expression* expression);
+    /// Складывает в expansion_ операторы, которые вычисляют вызов и кладут
+    /// его значение в `result`, а без него - в новую временную переменную.
+    /// Возвращает переменную с результатом.
+    SymbolId Expand(FunctionCall* call, FunctionDeclaration* callee, std::optional<SymbolId> result);
+
+    void Visit(StatementList* statementList) override;
+    void Visit(Assignment* assignment) override;
+    void Visit(PrintStatement* printStatement) override;
+    void Visit(ReturnStatement* returnStatement) override;
+    void Visit(IfStatement* statement) override;
+
+    void Visit(Number* expression) override;
+    void Visit(Variable* expression) override;
+    void Visit(BinaryExpression* expression) override;
+    void Visit(Comparison* expression) override;
+    void Visit(FunctionCall* functionCall) override;
+
+    size_t threshold_;
+    Arena* arena_ = nullptr;
+    std::vector<FunctionDeclaration*> functions_;
+    std::vector<Callee> callees_;                           // параллельно functions_
+    std::unordered_map<SymbolId, std::vector<uint32_t>> by_name_;
+    std::unordered_map<const FunctionDeclaration*, uint32_t> index_of_;
+    FunctionDeclaration* caller_ = nullptr;
+    FunctionCall* call_ = nullptr;                          // результат Visit выражения
+    std::vector<Statement*> expansion_;                     // замена только что обойдённого оператора
+    size_t sites_ = 0;
+};
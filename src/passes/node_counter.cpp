@@ -0,0 +1,72 @@
+#include "node_counter.hpp"
+
+#include "../parsing/ast.hpp"
+
+size_t NodeCounter::Count(ProgramBlocks* program) {
+    count_ = 0;
+    program->Accept(this);
+    return count_;
+}
+
+size_t NodeCounter::Count(FunctionDeclaration* func) {
+    count_ = 0;
+    func->Accept(this);
+    return count_;
+}
+
+void NodeCounter::Visit(FunctionDeclaration* func) {
+    count_ += 1 + func->params.size();
+    AstWalker::Visit(func);
+}
+
+void NodeCounter::Visit(StatementList* statementList) {
+    ++count_;
+    AstWalker::Visit(statementList);
+}
+
+void NodeCounter::Visit(Assignment* assignment) {
+    ++count_;
+    AstWalker::Visit(assignment);
+}
+
+void NodeCounter::Visit(Declaration* declaration) {
+    ++count_;
+}
+
+void NodeCounter::Visit(PrintStatement* printStatement) {
+    ++count_;
+    AstWalker::Visit(printStatement);
+}
+
+void NodeCounter::Visit(ReturnStatement* returnStatement) {
+    ++count_;
+    AstWalker::Visit(returnStatement);
+}
+
+void NodeCounter::Visit(IfStatement* statement) {
+    ++count_;
+    AstWalker::Visit(statement);
+}
+
+void NodeCounter::Visit(Number* expression) {
+    ++count_;
+}
+
+void NodeCounter::Visit(Variable* expression) {
+    ++count_;
+}
+
+void NodeCounter::Visit(BinaryExpression* expression) {
+    ++count_;
+    AstWalker::Visit(expression);
+}
+
+void NodeCounter::Visit(Comparison* expression) {
+    ++count_;
+    AstWalker::Visit(expression);
+}
+
+void NodeCounter::Visit(FunctionCall* functionCall) {
+    ++count_;
+    AstWalker::Visit(functionCall);
+}
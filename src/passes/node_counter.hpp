@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+
+#include "ast_walker.hpp"
+
+/// Число узлов в функциях программы (операторы, выражения, параметры);
+/// мера размера для --pass-stats и порога встраивания.
+class NodeCounter : public AstWalker {
+public:
+    size_t Count(ProgramBlocks* program);
+    size_t Count(FunctionDeclaration* func);
+
+    void Visit(FunctionDeclaration* func) override;
+    void Visit(StatementList* statementList) override;
+    void Visit(Assignment* assignment) override;
+    void Visit(Declaration* declaration) override;
+    void Visit(PrintStatement* printStatement) override;
+    void Visit(ReturnStatement* returnStatement) override;
+    void Visit(IfStatement* statement) override;
+    void Visit(Number* expression) override;
+    void Visit(Variable* expression) override;
+    void Visit(BinaryExpression* expression) override;
+    void Visit(Comparison* expression) override;
+    void Visit(FunctionCall* functionCall) override;
+
+private:
+    size_t count_ = 0;
+};
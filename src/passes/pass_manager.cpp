@@ -0,0 +1,68 @@
+#include "pass_manager.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <ostream>
+
+#include "constant_folding.hpp"
+#include "constant_propagation.hpp"
+#include "dead_store_elimination.hpp"
+#include "inliner.hpp"
+#include "node_counter.hpp"
+#include "pure_call_evaluation.hpp"
+#include "specialization.hpp"
+#include "../parsing/ast.hpp"
+
+PassManager PassManager::ForLevel(int level, size_t inlineThreshold, uint64_t evalFuel) {
+    PassManager manager;
+    if (level >= 2 && inlineThreshold > 0) {
+        // встроенные тела получают аргументы-константы и свёртываются дальше
+        manager.Add(std::make_unique<Inliner>(inlineThreshold));
+    }
+    if (level >= 1) {
+        manager.Add(std::make_unique<ConstantFolding>());
+        manager.Add(std::make_unique<ConstantPropagation>());
+        // подставленные константы дают новые выражения для свёртки
+        manager.Add(std::make_unique<ConstantFolding>());
+    }
+    if (level >= 2) {
+        // аргументы вызовов к этому моменту уже свёрнуты в числа;
+        // результаты вычисленных вызовов снова распространяются и сворачиваются
+        if (evalFuel > 0) {
+            manager.Add(std::make_unique<PureCallEvaluation>(evalFuel));
+            manager.Add(std::make_unique<ConstantPropagation>());
+            manager.Add(std::make_unique<ConstantFolding>());
+        }
+        manager.Add(std::make_unique<FunctionSpecialization>());
+        manager.Add(std::make_unique<DeadStoreElimination>());
+    }
+    return manager;
+}
+
+void PassManager::Run(ProgramBlocks* program, bool collectStatistics) {
+    NodeCounter counter;
+    size_t nodes = collectStatistics ? counter.Count(program) : 0;
+    for (const auto& pass : passes_) {
+        auto start = std::chrono::steady_clock::now();
+        size_t changes = pass->Run(program);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        if (collectStatistics) {
+            size_t after = counter.Count(program);
+            statistics_.push_back({pass->Name(), changes, nodes, after, elapsed.count(), pass->Remarks()});
+            nodes = after;
+        }
+    }
+}
+
+void PassManager::PrintStatistics(std::ostream& out) const {
+    char line[160];
+    for (const PassStatistics& stats : statistics_) {
+        long long removed = static_cast<long long>(stats.nodesBefore) - static_cast<long long>(stats.nodesAfter);
+        std::snprintf(line, sizeof(line), "%-24s %8zu changes %8lld nodes removed (%zu -> %zu) %10.3f ms\n",
+                      stats.name, stats.changes, removed, stats.nodesBefore, stats.nodesAfter, stats.seconds * 1e3);
+        out << line;
+        for (const std::string& remark : stats.remarks) {
+            out << "    " << remark << "\n";
+        }
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ast_pass.hpp"
+#include "inliner.hpp"
+#include "pure_call_evaluation.hpp"
+
+/// Итог одного запуска прохода для --pass-stats.
+struct PassStatistics {
+    const char* name;
+    size_t changes;         // что насчитал сам проход
+    size_t nodesBefore;     // узлов в функциях до прохода
+    size_t nodesAfter;
+    double seconds;
+    std::vector<std::string> remarks;   // AstPass::Remarks
+};
+
+/// Упорядоченный набор проходов по AST.
+class PassManager {
+public:
+    /// Уровни: 0 - без проходов; 1 - свёртка констант и распространение
+    /// констант и копий; 2 - сначала встраивание функций не больше
+    /// `inlineThreshold` узлов (0 - не встраивать), затем вычисление
+    /// чистых вызовов и main не больше чем за `evalFuel` шагов (0 - не
+    /// вычислять), в конце специализация функций по константным
+    /// аргументам и удаление мёртвых присваиваний.
+    static PassManager ForLevel(int level, size_t inlineThreshold = Inliner::kDefaultThreshold,
+                                uint64_t evalFuel = PureCallEvaluation::kDefaultFuel);
+
+    void Add(std::unique_ptr<AstPass> pass) { passes_.push_back(std::move(pass)); }
+    bool Empty() const { return passes_.empty(); }
+
+    /// Запускает проходы по порядку. Если `collectStatistics`, до и после
+    /// каждого прохода считаются узлы дерева.
+    void Run(ProgramBlocks* program, bool collectStatistics = false);
+
+    const std::vector<PassStatistics>& Statistics() const { return statistics_; }
+    void PrintStatistics(std::ostream& out) const;
+
+private:
+    std::vector<std::unique_ptr<AstPass>> passes_;
+    std::vector<PassStatistics> statistics_;
+};
@@ -0,0 +1,277 @@
+#include "pure_call_evaluation.hpp"
+
+#include <string>
+
+#include "constant_folding.hpp"
+#include "purity.hpp"
+#include "../parsing/ast.hpp"
+
+namespace {
+
+/// Значение выражения из чисел и вызовов с известным результатом.
+class StaticValue : public AstWalker {
+public:
+    explicit StaticValue(const std::vector<std::pair<FunctionCall*, const Evaluation*>>& calls) : calls_(calls) {}
+
+    std::optional<int> Of(Expression* expression) {
+        value_.reset();
+        expression->Accept(this);
+        return value_;
+    }
+
+    void Visit(Number* expression) override { value_ = expression->value; }
+    void Visit(Variable* expression) override { value_.reset(); }
+    void Visit(BinaryExpression* expression) override {
+        std::optional<int> left = Of(expression->left);
+        std::optional<int> right = left ? Of(expression->right) : std::nullopt;
+        value_ = right ? ConstantFolding::EvaluateBinary(expression->op, *left, *right) : std::nullopt;
+    }
+    void Visit(Comparison* expression) override {
+        std::optional<int> left = Of(expression->left);
+        std::optional<int> right = left ? Of(expression->right) : std::nullopt;
+        value_ = right ? ConstantFolding::EvaluateComparison(expression->op, *left, *right) : std::nullopt;
+    }
+    void Visit(FunctionCall* functionCall) override {
+        value_.reset();
+        for (const auto& [call, result] : calls_) {
+            if (call == functionCall) {
+                value_ = result->value;
+            }
+        }
+    }
+
+private:
+    const std::vector<std::pair<FunctionCall*, const Evaluation*>>& calls_;
+    std::optional<int> value_;
+};
+
+std::string Describe(SymbolId name, const std::vector<int>& args) {
+    std::string text(Interner::Global().Name(name));
+    text += "(";
+    for (size_t i = 0; i < args.size(); ++i) {
+        text += i != 0 ? ", " : "";
+        text += std::to_string(args[i]);
+    }
+    return text + ")";
+}
+
+} // namespace
+
+size_t PureCallEvaluation::Run(ProgramBlocks* program) {
+    program_ = program;
+    remarks_.clear();
+    visible_.clear();
+    pure_.clear();
+    cache_.clear();
+    replaced_ = 0;
+    if (fuel_ == 0) {
+        return 0;
+    }
+
+    // как и в Inliner: только функции, которые Interpreter найдёт по имени
+    SymbolId mainName = Interner::Global().Intern("main");
+    bool seenMain = false;
+    std::unordered_map<SymbolId, size_t> declarations;
+    FunctionDeclaration* main = nullptr;
+    for (ProgramBlock* block : program->blocks) {
+        if (block->function == nullptr) {
+            continue;
+        }
+        if (!seenMain) {
+            visible_.emplace(block->function->name, block->function);
+        }
+        if (block->function->name == mainName) {
+            main = block->function;
+        }
+        ++declarations[block->function->name];
+        seenMain = seenMain || block->function->name == mainName;
+    }
+    for (auto it = visible_.begin(); it != visible_.end();) {
+        it = declarations[it->first] == 1 ? std::next(it) : visible_.erase(it);
+    }
+
+    // сначала дешёвые вызовы: они же упрощают main для второго шага
+    pure_ = PurityAnalysis().Find(visible_);
+    evaluator_.emplace(visible_, fuel_);
+    for (ProgramBlock* block : program->blocks) {
+        if (block->function != nullptr) {
+            caller_ = block->function;
+            caller_->Accept(this);
+        }
+    }
+    // при единственном main больше ничего не исполняется
+    if (main != nullptr && declarations[mainName] == 1) {
+        EvaluateMain(main);
+    }
+    return replaced_;
+}
+
+bool PureCallEvaluation::EvaluateMain(FunctionDeclaration* main) {
+    std::optional<Evaluation> result = evaluator_->Call(main, {}, kMaxMainOutput);
+    if (!result) {
+        return false;
+    }
+    std::vector<EvaluationEvent>& output = result->output;
+    ReturnStatement* ret = nullptr;
+    if (result->returned) {
+        ret = program_->arena.Make<ReturnStatement>(program_->arena.Make<Number>(output.back().value));
+        output.pop_back();
+    }
+    std::vector<Statement*> statements;
+    Replay(output, Scratch(main->name), statements);
+    if (ret != nullptr) {
+        statements.push_back(ret);
+    }
+    main->body->statements = program_->arena.MakeList(statements.data(), statements.size());
+    ++replaced_;
+    remarks_.push_back("evaluated main: " + std::to_string(output.size() + (ret != nullptr)) + " lines of output");
+    return true;
+}
+
+const std::optional<Evaluation>& PureCallEvaluation::Evaluate(FunctionDeclaration* func, const std::vector<int>& args) {
+    Key key{func, args};
+    auto it = cache_.find(key);
+    if (it == cache_.end()) {
+        it = cache_.emplace(std::move(key), evaluator_->Call(func, args, kMaxOutput)).first;
+    }
+    return it->second;
+}
+
+void PureCallEvaluation::Replay(const std::vector<EvaluationEvent>& output, SymbolId scratch,
+                                std::vector<Statement*>& out) {
+    Arena& arena = program_->arena;
+    bool declared = false;
+    for (const EvaluationEvent& event : output) {
+        Number* value = arena.Make<Number>(event.value);
+        if (event.kind == EvaluationEvent::Print) {
+            out.push_back(arena.Make<PrintStatement>(value));
+            continue;
+        }
+        // declare нужен LLVMCodeGenVisitor для alloca
+        if (!declared) {
+            out.push_back(arena.Make<Declaration>(scratch));
+            declared = true;
+        }
+        auto* echo = arena.Make<Assignment>(scratch, value);
+        echo->inlinedReturn = true;
+        out.push_back(echo);
+    }
+}
+
+SymbolId PureCallEvaluation::Scratch(SymbolId callee) {
+    Interner& interner = Interner::Global();
+    return interner.Intern(std::string(interner.Name(callee)) + ".eval." + std::to_string(++scratch_));
+}
+
+Expression* PureCallEvaluation::RewriteStatement(Expression* expression) {
+    printing_.clear();
+    expression = Rewrite(expression);
+    if (printing_.empty()) {
+        return expression;
+    }
+    // строки печатаются раньше оператора, поэтому больше ничего
+    // в выражении не должно ни печатать, ни падать
+    std::optional<int> value = StaticValue(printing_).Of(expression);
+    if (!value) {
+        return expression;
+    }
+    for (const auto& [call, result] : printing_) {
+        Replay(result->output, Scratch(call->name), expansion_);
+        std::vector<int> args;
+        for (Expression* arg : call->args) {
+            args.push_back(*StaticValue(printing_).Of(arg));
+        }
+        Remark(call, args, *result);
+    }
+    printing_.clear();
+    return program_->arena.Make<Number>(*value);
+}
+
+void PureCallEvaluation::Remark(FunctionCall* call, const std::vector<int>& args, const Evaluation& result) {
+    ++replaced_;
+    remarks_.push_back("evaluated " + Describe(call->name, args) + " = " + std::to_string(result.value) + " in " +
+                       std::string(Interner::Global().Name(caller_->name)));
+}
+
+void PureCallEvaluation::Visit(StatementList* statementList) {
+    std::vector<Statement*> statements;
+    statements.reserve(statementList->statements.size());
+    bool changed = false;
+    for (Statement* statement : statementList->statements) {
+        expansion_.clear();
+        statement->Accept(this);
+        if (expansion_.empty()) {
+            statements.push_back(statement);
+            continue;
+        }
+        statements.insert(statements.end(), expansion_.begin(), expansion_.end());
+        changed = true;
+    }
+    expansion_.clear();
+    if (changed) {
+        statementList->statements = program_->arena.MakeList(statements.data(), statements.size());
+    }
+}
+
+void PureCallEvaluation::Visit(Assignment* assignment) {
+    assignment->expression = RewriteStatement(assignment->expression);
+    if (!expansion_.empty()) {
+        expansion_.push_back(assignment);
+    }
+}
+
+void PureCallEvaluation::Visit(PrintStatement* printStatement) {
+    printStatement->expression = RewriteStatement(printStatement->expression);
+    if (!expansion_.empty()) {
+        expansion_.push_back(printStatement);
+    }
+}
+
+void PureCallEvaluation::Visit(ReturnStatement* returnStatement) {
+    returnStatement->expression = RewriteStatement(returnStatement->expression);
+    if (!expansion_.empty()) {
+        expansion_.push_back(returnStatement);
+    }
+}
+
+void PureCallEvaluation::Visit(IfStatement* statement) {
+    // ветки - свои списки операторов, их вызовы заменяются на месте
+    statement->thenBranch->Accept(this);
+    if (statement->elseBranch != nullptr) {
+        statement->elseBranch->Accept(this);
+    }
+    expansion_.clear();
+    statement->condition = RewriteStatement(statement->condition);
+    if (!expansion_.empty()) {
+        expansion_.push_back(statement);
+    }
+}
+
+void PureCallEvaluation::Visit(FunctionCall* functionCall) {
+    AstWalker::Visit(functionCall);
+    auto it = visible_.find(functionCall->name);
+    if (it == visible_.end() || pure_.count(it->second) == 0 ||
+        it->second->params.size() != functionCall->args.size()) {
+        return;
+    }
+    // аргумент-вызов, который печатает, остаётся на месте вместе с этим вызовом
+    const std::vector<std::pair<FunctionCall*, const Evaluation*>> none;
+    std::vector<int> args;
+    for (Expression* arg : functionCall->args) {
+        std::optional<int> value = StaticValue(none).Of(arg);
+        if (!value) {
+            return;
+        }
+        args.push_back(*value);
+    }
+    const std::optional<Evaluation>& result = Evaluate(it->second, args);
+    if (!result) {
+        return;
+    }
+    if (!result->output.empty()) {
+        printing_.push_back({functionCall, &*result});
+        return;
+    }
+    Remark(functionCall, args, *result);
+    Replace(program_->arena.Make<Number>(result->value));
+}
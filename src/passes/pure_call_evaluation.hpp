@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "ast_pass.hpp"
+#include "ast_walker.hpp"
+#include "constant_evaluator.hpp"
+#include "../tokenization/interner.hpp"
+
+/// Вычисление во время компиляции встроенным ConstantEvaluator:
+///  - вызовы чистых функций (см. PurityAnalysis) с аргументами-числами
+///    заменяются результатом. Return чистой функции печатает
+///    "expression = v", поэтому вызов, который печатает, заменяется,
+///    только если всё выражение оператора становится числом: напечатанные
+///    строки тогда воспроизводятся перед оператором присваиваниями
+///    с inlinedReturn;
+///  - ввода в языке нет, поэтому единственная main затем исполняется
+///    целиком, и, если это удалось, её тело заменяется готовым выводом:
+///    print(число) на каждую напечатанную строку, "expression = v"
+///    вложенных return - присваиванием с inlinedReturn, в конце return.
+/// Кандидаты - функции, объявленные один раз и до первого main. Вычисление,
+/// которое наткнулось бы на ошибку Interpreter, не заменяется. На весь
+/// проход тратится не больше `fuel` шагов вычислителя.
+class PureCallEvaluation : public AstPass, private AstWalker {
+public:
+    static constexpr uint64_t kDefaultFuel = 1000000;
+    /// Больше строк вывода заменой не воспроизводится.
+    static constexpr size_t kMaxOutput = 64;
+    static constexpr size_t kMaxMainOutput = 1024;
+
+    explicit PureCallEvaluation(uint64_t fuel = kDefaultFuel) : fuel_(fuel) {}
+
+    const char* Name() const override { return "pure-call-evaluation"; }
+    size_t Run(ProgramBlocks* program) override;
+
+private:
+    using Key = std::pair<FunctionDeclaration*, std::vector<int>>;
+
+    /// Заменяет тело main её выводом; false, если main не вычислилась.
+    bool EvaluateMain(FunctionDeclaration* main);
+    /// Результат вызова, вычисленный или взятый из кэша.
+    const std::optional<Evaluation>& Evaluate(FunctionDeclaration* func, const std::vector<int>& args);
+    /// Операторы, печатающие строки `output`; return становятся
+    /// присваиваниями с inlinedReturn переменной `scratch`.
+    void Replay(const std::vector<EvaluationEvent>& output, SymbolId scratch, std::vector<Statement*>& out);
+    /// Новая переменная для присваиваний с inlinedReturn.
+    SymbolId Scratch(SymbolId callee);
+    /// Заменяет вычисленные вызовы в выражении оператора; строки, которые
+    /// они печатают, добавляет в expansion_.
+    Expression* RewriteStatement(Expression* expression);
+    void Remark(FunctionCall* call, const std::vector<int>& args, const Evaluation& result);
+
+    void Visit(StatementList* statementList) override;
+    void Visit(Assignment* assignment) override;
+    void Visit(PrintStatement* printStatement) override;
+    void Visit(ReturnStatement* returnStatement) override;
+    void Visit(IfStatement* statement) override;
+    void Visit(FunctionCall* functionCall) override;
+
+    uint64_t fuel_;
+    ProgramBlocks* program_ = nullptr;
+    std::optional<ConstantEvaluator> evaluator_;
+    std::unordered_map<SymbolId, FunctionDeclaration*> visible_;
+    std::unordered_set<const FunctionDeclaration*> pure_;
+    std::map<Key, std::optional<Evaluation>> cache_;
+    FunctionDeclaration* caller_ = nullptr;
+    std::vector<std::pair<FunctionCall*, const Evaluation*>> printing_;    // вычисленные вызовы, которые печатают
+    std::vector<Statement*> expansion_;             // оператор с тем, что надо выполнить перед ним
+    size_t replaced_ = 0;
+    size_t scratch_ = 0;
+};
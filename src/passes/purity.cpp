@@ -0,0 +1,48 @@
+#include "purity.hpp"
+
+#include "../parsing/ast.hpp"
+
+std::unordered_set<const FunctionDeclaration*> PurityAnalysis::Find(
+    const std::unordered_map<SymbolId, FunctionDeclaration*>& functions) {
+    std::unordered_set<const FunctionDeclaration*> pure;
+    std::unordered_map<const FunctionDeclaration*, std::vector<FunctionCall*>> calls;
+    for (const auto& [name, func] : functions) {
+        prints_ = false;
+        calls_.clear();
+        func->Accept(this);
+        if (!prints_) {
+            pure.insert(func);
+            calls[func] = std::move(calls_);
+        }
+    }
+    // вычёркиваем, пока есть что вычёркивать
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto it = pure.begin(); it != pure.end();) {
+            bool callsPure = true;
+            for (FunctionCall* call : calls[*it]) {
+                auto callee = functions.find(call->name);
+                callsPure = callsPure && callee != functions.end() && pure.count(callee->second) != 0 &&
+                            callee->second->params.size() == call->args.size();
+            }
+            if (callsPure) {
+                ++it;
+                continue;
+            }
+            it = pure.erase(it);
+            changed = true;
+        }
+    }
+    return pure;
+}
+
+void PurityAnalysis::Visit(PrintStatement* printStatement) {
+    AstWalker::Visit(printStatement);
+    prints_ = true;
+}
+
+void PurityAnalysis::Visit(FunctionCall* functionCall) {
+    AstWalker::Visit(functionCall);
+    calls_.push_back(functionCall);
+}
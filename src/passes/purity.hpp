@@ -0,0 +1,26 @@
+#pragma once
+
+#include <unordered_map>
+#include <unordered_set>
+
+#include "ast_walker.hpp"
+#include "../tokenization/interner.hpp"
+
+/// Анализ чистоты: функция чистая, если в ней нет print и она вызывает
+/// только чистые функции. Считается наибольшая неподвижная точка,
+/// поэтому рекурсивная функция без print чистая. `functions` - функции,
+/// которые найдёт вызов по имени; вызов другого имени или с другим числом
+/// аргументов делает функцию нечистой. Чистая функция всё равно печатает
+/// "expression = v" своими return - это учитывают те, кто её вычисляет.
+class PurityAnalysis : public AstWalker {
+public:
+    std::unordered_set<const FunctionDeclaration*> Find(
+        const std::unordered_map<SymbolId, FunctionDeclaration*>& functions);
+
+    void Visit(PrintStatement* printStatement) override;
+    void Visit(FunctionCall* functionCall) override;
+
+private:
+    bool prints_ = false;
+    std::vector<FunctionCall*> calls_;
+};
@@ -0,0 +1,242 @@
+#include "specialization.hpp"
+
+#include <string>
+#include <unordered_set>
+
+#include "ast_cloner.hpp"
+#include "constant_folding.hpp"
+#include "constant_propagation.hpp"
+#include "../parsing/ast.hpp"
+
+namespace {
+
+/// Значение выражения, если это число; вглубь не заходит.
+class NumberProbe : public AstWalker {
+public:
+    std::optional<int> value;
+
+    void Visit(Number* expression) override { value = expression->value; }
+    void Visit(Variable* expression) override {}
+    void Visit(BinaryExpression* expression) override {}
+    void Visit(Comparison* expression) override {}
+    void Visit(FunctionCall* functionCall) override {}
+};
+
+/// Параметры, которые каждый рекурсивный вызов функции самой себя
+/// передаёт без изменений: f(n - 1, k) внутри f(n, k) сохраняет k.
+/// Только по ним и имеет смысл специализировать рекурсивную функцию:
+/// тогда её рекурсивные вызовы попадают в ту же копию.
+class InvariantParams : public AstWalker {
+public:
+    std::vector<char> Find(FunctionDeclaration* func) {
+        func_ = func;
+        invariant_.assign(func->params.size(), 1);
+        func->Accept(this);
+        for (size_t i = 0; i < func->params.size(); ++i) {
+            for (size_t j = 0; j < func->params.size(); ++j) {
+                if (i != j && func->params[i]->name == func->params[j]->name) {
+                    invariant_[i] = 0;
+                }
+            }
+            invariant_[i] = invariant_[i] && assigned_.count(func->params[i]->name) == 0;
+        }
+        return invariant_;
+    }
+
+    void Visit(Assignment* assignment) override {
+        AstWalker::Visit(assignment);
+        assigned_.insert(assignment->variable);
+    }
+    void Visit(FunctionCall* functionCall) override {
+        AstWalker::Visit(functionCall);
+        if (functionCall->name != func_->name || functionCall->args.size() != func_->params.size()) {
+            return;
+        }
+        for (size_t i = 0; i < functionCall->args.size(); ++i) {
+            functionCall->args[i]->Accept(&probe_);
+            invariant_[i] = invariant_[i] && probe_.Is(func_->params[i]->name);
+        }
+    }
+
+private:
+    /// Является ли выражение чтением переменной `name`; вглубь не заходит.
+    class VariableProbe : public AstWalker {
+    public:
+        bool Is(SymbolId name) const { return found_ && name_ == name; }
+        void Visit(Number* expression) override { found_ = false; }
+        void Visit(Variable* expression) override {
+            found_ = true;
+            name_ = expression->name;
+        }
+        void Visit(BinaryExpression* expression) override { found_ = false; }
+        void Visit(Comparison* expression) override { found_ = false; }
+        void Visit(FunctionCall* functionCall) override { found_ = false; }
+
+    private:
+        bool found_ = false;
+        SymbolId name_ = 0;
+    };
+
+    FunctionDeclaration* func_ = nullptr;
+    std::vector<char> invariant_;
+    std::unordered_set<SymbolId> assigned_;
+    VariableProbe probe_;
+};
+
+std::string Describe(std::string_view name, const std::vector<std::optional<int>>& args) {
+    std::string text(name);
+    text += "(";
+    for (size_t i = 0; i < args.size(); ++i) {
+        text += i != 0 ? ", " : "";
+        text += args[i] ? std::to_string(*args[i]) : "_";
+    }
+    return text + ")";
+}
+
+} // namespace
+
+size_t FunctionSpecialization::Run(ProgramBlocks* program) {
+    program_ = program;
+    remarks_.clear();
+    entries_.clear();
+    candidate_.clear();
+    clones_.clear();
+    base_of_.clear();
+    invariant_.clear();
+    specializations_.clear();
+    redirected_ = 0;
+
+    // как и в Inliner: только функции, которые Interpreter найдёт по имени
+    SymbolId mainName = Interner::Global().Intern("main");
+    bool seenMain = false;
+    std::unordered_map<SymbolId, size_t> declarations;
+    for (ProgramBlock* block : program->blocks) {
+        if (block->function == nullptr) {
+            continue;
+        }
+        uint32_t index = static_cast<uint32_t>(entries_.size());
+        entries_.push_back({block->function, index, 0});
+        candidate_.push_back(!seenMain);
+        clones_.push_back(0);
+        invariant_.push_back(InvariantParams().Find(block->function));
+        ++declarations[block->function->name];
+        base_of_[block->function->name] = index;
+        seenMain = seenMain || block->function->name == mainName;
+    }
+    for (size_t i = 0; i < candidate_.size(); ++i) {
+        candidate_[i] = candidate_[i] && declarations[entries_[i].func->name] == 1;
+    }
+
+    // копии дописываются в entries_ и обходятся следом: их вызовы
+    // с теми же константами уходят в них самих
+    for (caller_ = 0; caller_ < entries_.size(); ++caller_) {
+        entries_[caller_].func->Accept(this);
+    }
+    if (entries_.size() == candidate_.size()) {
+        return redirected_;
+    }
+
+    std::vector<std::vector<FunctionDeclaration*>> clonesOf(candidate_.size());
+    for (size_t i = candidate_.size(); i < entries_.size(); ++i) {
+        clonesOf[entries_[i].base].push_back(entries_[i].func);
+    }
+    std::vector<ProgramBlock*> blocks;
+    blocks.reserve(program->blocks.size() + entries_.size() - candidate_.size());
+    size_t function = 0;
+    for (ProgramBlock* block : program->blocks) {
+        blocks.push_back(block);
+        if (block->function == nullptr) {
+            continue;
+        }
+        for (FunctionDeclaration* clone : clonesOf[function++]) {
+            blocks.push_back(program->arena.Make<ProgramBlock>(clone));
+        }
+    }
+    program->blocks = program->arena.MakeList(blocks.data(), blocks.size());
+    return redirected_;
+}
+
+void FunctionSpecialization::Visit(FunctionCall* functionCall) {
+    AstWalker::Visit(functionCall);
+    auto it = base_of_.find(functionCall->name);
+    if (it == base_of_.end() || !candidate_[it->second]) {
+        return;
+    }
+    // при другом числе аргументов Interpreter печатает ошибку - не трогаем
+    if (entries_[it->second].func->params.size() != functionCall->args.size()) {
+        return;
+    }
+    Key key{it->second, {}};
+    bool constant = false;
+    for (size_t i = 0; i < functionCall->args.size(); ++i) {
+        NumberProbe probe;
+        if (invariant_[key.first][i]) {
+            functionCall->args[i]->Accept(&probe);
+        }
+        key.second.push_back(probe.value);
+        constant = constant || probe.value.has_value();
+    }
+    if (!constant) {
+        return;
+    }
+
+    uint32_t target;
+    auto found = specializations_.find(key);
+    if (found != specializations_.end()) {
+        target = found->second;
+    } else {
+        // новая копия встала бы за уже существующими, то есть после вызывающей
+        if (key.first >= entries_[caller_].base || clones_[key.first] >= max_clones_) {
+            return;
+        }
+        target = CloneFor(key);
+        specializations_.emplace(key, target);
+    }
+    if (target == kNotProfitable || !DeclaredBefore(entries_[target], entries_[caller_])) {
+        return;
+    }
+    Interner& interner = Interner::Global();
+    functionCall->name = entries_[target].func->name;
+    functionCall->target = nullptr;
+    ++redirected_;
+    remarks_.push_back("call in " + std::string(interner.Name(entries_[caller_].func->name)) + " -> " +
+                       std::string(interner.Name(functionCall->name)));
+}
+
+uint32_t FunctionSpecialization::CloneFor(const Key& key) {
+    Interner& interner = Interner::Global();
+    FunctionDeclaration* original = entries_[key.first].func;
+    uint32_t number = clones_[key.first] + 1;
+    SymbolId name = interner.Intern(std::string(interner.Name(original->name)) + ".spec." + std::to_string(number));
+
+    // у повторяющегося имени параметра остаётся последний аргумент
+    std::unordered_map<SymbolId, int> entry;
+    for (size_t i = 0; i < key.second.size(); ++i) {
+        SymbolId param = original->params[i]->name;
+        if (key.second[i]) {
+            entry[param] = *key.second[i];
+        } else {
+            entry.erase(param);
+        }
+    }
+
+    std::unordered_map<SymbolId, SymbolId> sameNames;
+    FunctionDeclaration* clone = AstCloner(program_->arena, sameNames).Clone(original, name);
+    if (entry.empty() || ConstantPropagation().RunOnFunction(program_, clone, entry) == 0) {
+        return kNotProfitable;
+    }
+    // подставленные числа сворачиваются и дают новые константы
+    ConstantFolding().RunOnFunction(program_, clone);
+    ConstantPropagation().RunOnFunction(program_, clone);
+    ConstantFolding().RunOnFunction(program_, clone);
+
+    clones_[key.first] = number;
+    entries_.push_back({clone, key.first, number});
+    remarks_.push_back("cloned " + std::string(interner.Name(name)) + " for " +
+                       Describe(interner.Name(original->name), key.second));
+    return static_cast<uint32_t>(entries_.size() - 1);
+}
+
+bool FunctionSpecialization::DeclaredBefore(const Entry& target, const Entry& caller) const {
+    return target.base != caller.base ? target.base < caller.base : target.clone <= caller.clone;
+}
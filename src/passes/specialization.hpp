@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "ast_pass.hpp"
+#include "ast_walker.hpp"
+#include "../tokenization/interner.hpp"
+
+/// Специализация функций по константным аргументам. Для вызова f(5, x)
+/// заводится копия f.spec.N, в которой параметр, получающий 5, на входе
+/// известен, после чего копия заново проходит распространение и свёртку
+/// констант, а вызов перенаправляется на неё. Список параметров и
+/// аргументы вызова не меняются, поэтому порядок вычислений, "последнее
+/// значение" и сообщения об ошибках остаются прежними.
+///
+/// У рекурсивной функции учитываются только параметры, которые её
+/// вызовы самой себя передают без изменений: тогда рекурсия остаётся
+/// внутри копии. Одинаковые наборы констант делят одну копию; копия,
+/// в которой ничего не упростилось, не сохраняется. Копий одной функции
+/// не больше maxClones. Кандидаты - функции, объявленные один раз и до первого
+/// main. Копия встаёт в программу сразу за исходной функцией; вызов
+/// перенаправляется, только если копия стоит не позже вызывающей
+/// функции: LLVMCodeGenVisitor находит лишь уже объявленные функции.
+class FunctionSpecialization : public AstPass, private AstWalker {
+public:
+    static constexpr size_t kDefaultMaxClones = 4;
+
+    explicit FunctionSpecialization(size_t maxClones = kDefaultMaxClones) : max_clones_(maxClones) {}
+
+    const char* Name() const override { return "function-specialization"; }
+    size_t Run(ProgramBlocks* program) override;
+
+private:
+    /// Исходная функция или её копия. Порядок в программе - по (base, clone).
+    struct Entry {
+        FunctionDeclaration* func;
+        uint32_t base;      // номер исходной функции
+        uint32_t clone;     // 0 - сама исходная функция, иначе номер копии
+    };
+    /// Исходная функция и известные значения её аргументов.
+    using Key = std::pair<uint32_t, std::vector<std::optional<int>>>;
+    static constexpr uint32_t kNotProfitable = UINT32_MAX;
+
+    void Visit(FunctionCall* functionCall) override;
+
+    /// Номер Entry с копией под этот вызов (создаёт её при необходимости)
+    /// или kNotProfitable.
+    uint32_t CloneFor(const Key& key);
+    /// Стоит ли Entry `target` в программе не позже вызывающей функции.
+    bool DeclaredBefore(const Entry& target, const Entry& caller) const;
+
+    size_t max_clones_;
+    ProgramBlocks* program_ = nullptr;
+    std::vector<Entry> entries_;            // сначала исходные функции, затем копии
+    std::vector<char> candidate_;           // для исходных функций
+    std::vector<uint32_t> clones_;          // число копий исходной функции
+    std::vector<std::vector<char>> invariant_;  // параметры, по которым можно специализировать
+    std::unordered_map<SymbolId, uint32_t> base_of_;
+    std::map<Key, uint32_t> specializations_;
+    uint32_t caller_ = 0;                   // обходимая Entry
+    size_t redirected_ = 0;
+};
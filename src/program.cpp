@@ -1,34 +1,438 @@
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Program.h>
+
+#include <charconv>
+#include <cstring>
 #include <string>
+#include <string_view>
 
 #include "program.hpp"
 
 #include "visitors/print_visitor.hpp"
 #include "visitors/interpreter.hpp"
 #include "visitors/llvm_codegen_visitor.hpp"
+#include "visitors/parallel_codegen.hpp"
+#include "visitors/flat_interpreter.hpp"
+#include "visitors/resolver.hpp"
+#include "parsing/ast_cache.hpp"
+#include "parsing/parallel_parser.hpp"
+#include "jit/program_jit.hpp"
+#include "passes/pass_manager.hpp"
+#include "util/thread_pool.hpp"
+#include "vm/bytecode_compiler.hpp"
+#include "vm/vm.hpp"
+
+namespace {
+
+/// Разбирает `arg` вида <prefix><число> в `out`; false - другой префикс
+/// или после префикса не число целиком.
+template <class T>
+bool ParseNumber(std::string_view arg, std::string_view prefix, T& out) {
+    if (arg.substr(0, prefix.size()) != prefix) {
+        return false;
+    }
+    arg.remove_prefix(prefix.size());
+    auto [ptr, ec] = std::from_chars(arg.data(), arg.data() + arg.size(), out);
+    return !arg.empty() && ec == std::errc() && ptr == arg.data() + arg.size();
+}
+
+} // namespace
 
-Program::Program(std::string& program_fn, std::string& ast_fn) :
-    program_fn(program_fn), ast_fn(ast_fn)
+bool ProgramOptions::Parse(const std::string& arg) {
+    if (arg == "--flat") {
+        flatAst = true;
+        return true;
+    }
+    if (arg == "--jit") {
+        engine = Engine::Jit;
+        explicitJit = true;
+        return true;
+    }
+    if (arg == "--engine=jit") {
+        engine = Engine::Jit;
+        explicitJit = false;
+        return true;
+    }
+    if (arg == "--engine=interp") {
+        engine = Engine::Interpreter;
+        explicitJit = false;
+        return true;
+    }
+    if (arg == "--engine=vm") {
+        engine = Engine::Vm;
+        explicitJit = false;
+        return true;
+    }
+    if (arg == "--engine=tiered") {
+        engine = Engine::Tiered;
+        explicitJit = false;
+        return true;
+    }
+    if (arg == "--no-ast-cache") {
+        astCache = false;
+        return true;
+    }
+    if (arg == "--pass-stats") {
+        passStats = true;
+        return true;
+    }
+    if (arg == "--memoize") {
+        memoize = true;
+        return true;
+    }
+    if (arg == "--emit=ll") {
+        emit = EmitKind::Ll;
+        return true;
+    }
+    if (arg == "--emit=bc") {
+        emit = EmitKind::Bc;
+        return true;
+    }
+    if (arg == "--emit=asm") {
+        emit = EmitKind::Asm;
+        return true;
+    }
+    if (arg == "--emit=obj") {
+        emit = EmitKind::Obj;
+        return true;
+    }
+    if (arg == "--link") {
+        link = true;
+        return true;
+    }
+    for (const char* prefix : {"--output=", "-o"}) {
+        if (arg.rfind(prefix, 0) == 0 && arg.size() > std::strlen(prefix)) {
+            output = arg.substr(std::strlen(prefix));
+            return true;
+        }
+    }
+    if (arg.size() == 3 && arg.compare(0, 2, "-O") == 0 && arg[2] >= '0' && arg[2] <= '3') {
+        optLevel = arg[2] - '0';
+        optSize = false;
+        return true;
+    }
+    if (arg == "-Os") {
+        optLevel = 2;
+        optSize = true;
+        return true;
+    }
+    return ParseNumber(arg, "--inline-threshold=", inlineThreshold) ||
+           ParseNumber(arg, "--tier-threshold=", tierThreshold) || ParseNumber(arg, "--eval-fuel=", evalFuel) ||
+           ParseNumber(arg, "-j", threads) || ParseNumber(arg, "--threads=", threads);
+}
+
+const char* ProgramOptions::Usage() {
+    return "Usage: MyCompiler <program file> <ast output file> [options]\n"
+           "  --flat           parse into the flat AST and run/compile from it (no ast output)\n"
+           "  --no-ast-cache   always re-parse; do not read or write <program file>.astc\n"
+           "  -jN, --threads=N parse top-level functions on N threads and, with --link or --emit=obj,\n"
+           "                   generate and optimize them on N threads (default: all cores)\n"
+           "  --engine=E       execute with E: jit (default: the whole program as native code through\n"
+           "                   LLVM ORC when its output is guaranteed to match the interpreter, the AST\n"
+           "                   interpreter otherwise), interp (AST interpreter), vm (bytecode VM)\n"
+           "                   or tiered (AST interpreter that JIT-compiles hot functions;\n"
+           "                   a report of compiled functions goes to stderr at exit)\n"
+           "  --jit            same as --engine=jit, but print compile and run times to stderr,\n"
+           "                   exit with the result of main and do not write output.ll\n"
+           "  --tier-threshold=N\n"
+           "                   with --engine=tiered, compile a function after N calls (default 1000)\n"
+           "  -O0, -O1, -O2    AST optimization level (default -O1): folding and propagation,\n"
+           "                   plus inlining, compile-time evaluation, constant-argument specialization\n"
+           "                   and dead stores at -O2; output.ll goes through the LLVM pipeline\n"
+           "                   of the same level\n"
+           "  -O3              -O2 AST passes and the LLVM -O3 pipeline\n"
+           "  -Os              -O1 AST passes and the LLVM -Os pipeline\n"
+           "  --inline-threshold=N\n"
+           "                   inline functions of at most N AST nodes at -O2 (default 40, 0 disables)\n"
+           "  --eval-fuel=N    evaluate pure calls and main at -O2 within N interpreter steps\n"
+           "                   (default 1000000, 0 disables)\n"
+           "  --pass-stats     print per-pass statistics and inlined call sites to stderr\n"
+           "  --memoize        cache results of pure recursive function calls in the AST interpreter.\n"
+           "                   Pays off when calls repeat arguments (fib, the same call in a loop);\n"
+           "                   recursion with new arguments on every call gets slower. Non-recursive,\n"
+           "                   tail-recursive and tiny (under 8 AST nodes) functions are never cached;\n"
+           "                   hit/miss counters go to stderr at exit\n"
+           "  --emit=K         write the compiled module as K: ll (LLVM IR, default), bc (bitcode),\n"
+           "                   asm or obj (native code for this machine)\n"
+           "  -o<file>, --output=<file>\n"
+           "                   output file (default output.ll, output.bc, output.s or output.o;\n"
+           "                   program with --link)\n"
+           "  --link           emit an object file and link it with the system C compiler driver\n"
+           "                   into an executable (--emit is ignored)\n";
+}
+
+Program::Program(std::string& program_fn, std::string& ast_fn, ProgramOptions options) :
+    program_fn(program_fn), ast_fn(ast_fn), options(options)
 {
-    std::ifstream program_str(program_fn);
     // ast = std::ofstream(ast_fn); 
-    std::string code;
-    std::string temp;
-    while (program_str) {
-        std::getline(program_str, temp);
-        code += temp + "\n";
-    }
-    program = std::istringstream(code);
-    lexer = new Lexer(program);
+    source = SourceBuffer::FromFile(program_fn);
+    lexer = new Lexer(source.View());
     parser = new Parser(*lexer);
 }
 
-void Program::Run() {
-    programBlocks = parser->parse();
+int Program::Run() {
+    if (options.flatAst) {
+        RunFlat();
+        return exitCode;
+    }
+    programBlocks = LoadOrParse();
     SymbolTreeVisitor print_visitor(ast_fn);
-    Interpreter interpreter{};
     programBlocks->Accept(&print_visitor);
-    programBlocks->Accept(&interpreter);
-    LLVMCodeGenVisitor llvmVisitor;
-    programBlocks->Accept(&llvmVisitor);
-    llvmVisitor.generateIR("output.ll");
-}
\ No newline at end of file
+    Optimize(programBlocks.get());
+    Execute(programBlocks.get());
+    // --jit - быстрый запуск: модуль уже исполнен, файл не нужен
+    if (!options.explicitJit && !EmitParallel(programBlocks.get())) {
+        LLVMCodeGenVisitor llvmVisitor;
+        programBlocks->Accept(&llvmVisitor);
+        EmitIR(llvmVisitor);
+    }
+    return exitCode;
+}
+
+void Program::RunFlat() {
+    FlatAst flat;
+    LoadOrParseFlat(flat);
+    if (options.optLevel > 0) {
+        // проходы работают с деревом: разворачиваем, оптимизируем и сворачиваем обратно
+        auto blocks = ExpandFlatAst(flat);
+        Optimize(blocks.get());
+        flat = FlatAst{};
+        FlatAstBuilder builder(flat);
+        for (ProgramBlock* block : blocks->blocks) {
+            builder.AddProgramBlock(block);
+        }
+    }
+    if (options.engine == Engine::Vm) {
+        Execute(ExpandFlatAst(flat).get());
+    } else {
+        FlatInterpreter interpreter(flat);
+        interpreter.Run();
+    }
+    if (!options.explicitJit) {
+        LLVMCodeGenVisitor llvmVisitor;
+        llvmVisitor.generate(flat);
+        EmitIR(llvmVisitor);
+    }
+}
+
+std::string Program::OutputPath() const {
+    static const char* const extensions[] = {"ll", "bc", "s", "o"};
+    if (!options.output.empty()) {
+        return options.output;
+    }
+    return options.link ? "program" : std::string("output.") + extensions[static_cast<int>(options.emit)];
+}
+
+void Program::EmitIR(LLVMCodeGenVisitor& llvmVisitor) {
+    EmitKind emit = options.link ? EmitKind::Obj : options.emit;
+    std::string path = OutputPath();
+    bool native = emit == EmitKind::Asm || emit == EmitKind::Obj;
+
+    std::string errors;
+    // IR и биткод пишутся и без цели, только без её триплета
+    if (!llvmVisitor.setHostTarget(options.optLevel, errors) && native) {
+        std::cerr << "Ошибка: нет целевой машины: " << errors << "\n";
+        return;
+    }
+    errors.clear();
+    if (!llvmVisitor.optimize(options.optLevel, options.optSize, errors)) {
+        std::cerr << "Ошибка: LLVM IR не прошёл проверку, " << path << " не записан\n" << errors;
+        return;
+    }
+    if (emit == EmitKind::Ll) {
+        llvmVisitor.generateIR(path);
+        return;
+    }
+    if (emit == EmitKind::Bc) {
+        if (!llvmVisitor.emitBitcode(path, errors)) {
+            std::cerr << "Ошибка: " << errors << "\n";
+        }
+        return;
+    }
+    if (!options.link) {
+        if (!llvmVisitor.emitNative(path, emit == EmitKind::Asm, errors)) {
+            std::cerr << "Ошибка: " << errors << "\n";
+        }
+        return;
+    }
+    llvm::SmallString<128> object;
+    if (std::error_code ec = llvm::sys::fs::createTemporaryFile("output", "o", object)) {
+        std::cerr << "Ошибка: временный файл: " << ec.message() << "\n";
+        return;
+    }
+    if (!llvmVisitor.emitNative(std::string(object), false, errors)) {
+        std::cerr << "Ошибка: " << errors << "\n";
+    } else {
+        Link({std::string(object)}, path, false);
+    }
+    llvm::sys::fs::remove(object);
+}
+
+bool Program::EmitParallel(ProgramBlocks* blocks) {
+    // части пишутся только в объектные файлы: их склеивает компоновщик
+    if (!options.link && options.emit != EmitKind::Obj) {
+        return false;
+    }
+    size_t threads = options.threads != 0 ? options.threads : ThreadPool::DefaultThreads();
+    if (threads <= 1) {
+        return false;
+    }
+    ThreadPool pool(threads);
+    ParallelCodeGen codegen(blocks, pool);
+    if (codegen.parts() <= 1) {
+        return false;
+    }
+
+    std::vector<std::string> objects;
+    std::string errors;
+    for (size_t i = 0; i < codegen.parts() && errors.empty(); ++i) {
+        llvm::SmallString<128> object;
+        if (std::error_code ec = llvm::sys::fs::createTemporaryFile("output", "o", object)) {
+            errors = "временный файл: " + ec.message();
+        } else {
+            objects.emplace_back(object);
+        }
+    }
+    if (errors.empty()) {
+        errors = codegen.run([&](size_t part, LLVMCodeGenVisitor& llvmVisitor, std::string& partErrors) {
+            return llvmVisitor.setHostTarget(options.optLevel, partErrors) &&
+                   llvmVisitor.optimize(options.optLevel, options.optSize, partErrors) &&
+                   llvmVisitor.emitNative(objects[part], false, partErrors);
+        });
+    }
+    if (!errors.empty()) {
+        std::cerr << "Ошибка: " << errors << "\n";
+    } else {
+        // --emit=obj: части сливаются в один перемещаемый объектный файл
+        Link(objects, OutputPath(), !options.link);
+    }
+    for (const std::string& object : objects) {
+        llvm::sys::fs::remove(object);
+    }
+    return true;
+}
+
+bool Program::Link(const std::vector<std::string>& objects, const std::string& output, bool relocatable) {
+    // драйвер сам добавит crt-файлы и libc, из которой нужен printf
+    for (const char* driver : {"cc", "clang", "gcc"}) {
+        llvm::ErrorOr<std::string> program = llvm::sys::findProgramByName(driver);
+        if (!program) {
+            continue;
+        }
+        std::string error;
+        std::vector<llvm::StringRef> args = {*program};
+        args.insert(args.end(), objects.begin(), objects.end());
+        if (relocatable) {
+            args.push_back("-r");
+        }
+        args.push_back("-o");
+        args.push_back(output);
+        int status = llvm::sys::ExecuteAndWait(*program, args, llvm::None, {}, 0, 0, &error);
+        if (status != 0) {
+            std::cerr << "Ошибка: компоновка через " << driver << " не удалась (код " << status << ")"
+                      << (error.empty() ? "" : ": " + error) << "\n";
+            return false;
+        }
+        return true;
+    }
+    std::cerr << "Ошибка: не найден компоновщик (cc, clang или gcc)\n";
+    return false;
+}
+
+void Program::Execute(ProgramBlocks* blocks) {
+    Resolver().Resolve(blocks);
+    if (options.engine == Engine::Vm) {
+        BytecodeProgram bytecode = BytecodeCompiler().Compile(blocks);
+        Vm(bytecode).Run();
+        return;
+    }
+    // --memoize относится к Interpreter
+    if (options.engine == Engine::Jit && !options.memoize && ExecuteNative(blocks)) {
+        return;
+    }
+    std::unique_ptr<TieredJit> jit;
+    if (options.engine == Engine::Tiered) {
+        jit = std::make_unique<TieredJit>(options.tierThreshold);
+    }
+    Interpreter interpreter(options.memoize, jit.get());
+    blocks->Accept(&interpreter);
+    if (options.memoize) {
+        interpreter.PrintMemoStatistics(std::cerr);
+    }
+    if (jit != nullptr) {
+        jit->PrintReport(std::cerr);
+    }
+}
+
+bool Program::ExecuteNative(ProgramBlocks* blocks) {
+    std::string reason = ProgramJit::Check(blocks);
+    ProgramJit jit;
+    if (reason.empty() && !jit.Run(blocks, options.optLevel, options.optSize)) {
+        reason = jit.Error();
+    }
+    if (!reason.empty()) {
+        if (options.explicitJit) {
+            std::cerr << "jit: runs in the interpreter: " << reason << "\n";
+        }
+        return false;
+    }
+    if (options.explicitJit) {
+        jit.PrintReport(std::cerr);
+        exitCode = jit.ExitCode();
+    }
+    return true;
+}
+
+void Program::Optimize(ProgramBlocks* blocks) {
+    // -Os не размножает код встраиванием и специализацией
+    int level = options.optSize ? 1 : options.optLevel;
+    PassManager passes = PassManager::ForLevel(level, options.inlineThreshold, options.evalFuel);
+    passes.Run(blocks, options.passStats);
+    if (options.passStats) {
+        passes.PrintStatistics(std::cerr);
+    }
+}
+
+std::unique_ptr<ProgramBlocks> Program::Parse() {
+    size_t threads = options.threads != 0 ? options.threads : ThreadPool::DefaultThreads();
+    if (threads <= 1) {
+        return parser->parse();
+    }
+    ThreadPool pool(threads);
+    return ParallelParser(source.View(), pool).parse();
+}
+
+std::unique_ptr<ProgramBlocks> Program::LoadOrParse() {
+    if (!options.astCache) {
+        return Parse();
+    }
+    std::string cachePath = AstCache::PathFor(program_fn);
+    uint64_t hash = AstCache::HashSource(source.View());
+    FlatAst flat;
+    if (AstCache::Load(cachePath, hash, source.Size(), flat)) {
+        return ExpandFlatAst(flat);
+    }
+
+    auto blocks = Parse();
+    FlatAstBuilder builder(flat);
+    for (ProgramBlock* block : blocks->blocks) {
+        builder.AddProgramBlock(block);
+    }
+    AstCache::Store(cachePath, hash, source.Size(), flat);
+    return blocks;
+}
+
+void Program::LoadOrParseFlat(FlatAst& flat) {
+    if (!options.astCache) {
+        parser->parseFlat(flat);
+        return;
+    }
+    std::string cachePath = AstCache::PathFor(program_fn);
+    uint64_t hash = AstCache::HashSource(source.View());
+    if (AstCache::Load(cachePath, hash, source.Size(), flat)) {
+        return;
+    }
+    parser->parseFlat(flat);
+    AstCache::Store(cachePath, hash, source.Size(), flat);
+}
@@ -2,21 +2,92 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <vector>
 #include "parsing/ast.hpp"
 #include "parsing/parser.hpp"
+#include "jit/tiered_jit.hpp"
+#include "passes/inliner.hpp"
+#include "passes/pure_call_evaluation.hpp"
 #include "tokenization/tokenize.hpp"
-#include <sstream>
+#include "tokenization/source_buffer.hpp"
+
+/// Чем исполнять программу.
+enum class Engine {
+    Interpreter,    // обход AST (Interpreter / FlatInterpreter)
+    Vm,             // регистровый байткод (src/vm)
+    Tiered,         // Interpreter, горячие функции - машинным кодом (src/jit)
+    Jit,            // вся программа машинным кодом, если вывод не изменится (src/jit), иначе Interpreter
+};
+
+/// Что пишет кодогенерация.
+enum class EmitKind {
+    Ll,     // текстовый LLVM IR (по умолчанию)
+    Bc,     // биткод LLVM
+    Asm,    // ассемблер целевой машины
+    Obj,    // объектный файл
+};
+
+/// Флаги командной строки (всё, что начинается с "-").
+struct ProgramOptions {
+    bool flatAst = false;   // --flat: разбор в FlatAst, исполнение и кодогенерация по нему
+    bool astCache = true;   // --no-ast-cache: всегда разбирать исходник заново, не читая и не записывая <файл>.astc
+    size_t threads = 0;     // -jN / --threads=N: потоки разбора и кодогенерации, 0 - по числу ядер
+    Engine engine = Engine::Jit;    // --engine=jit|interp|vm|tiered
+    bool explicitJit = false;       // --jit: отчёт о времени в stderr, код выхода - результат main, без output.ll
+    int optLevel = 1;       // -O0 .. -O3: проходы по AST (см. PassManager::ForLevel) и конвейер LLVM
+    bool optSize = false;   // -Os: проходы -O1 по AST, конвейер LLVM на размер кода
+    bool passStats = false; // --pass-stats: печатать в stderr статистику проходов
+    size_t inlineThreshold = Inliner::kDefaultThreshold;   // --inline-threshold=N: предел размера встраиваемой функции в узлах
+    uint64_t evalFuel = PureCallEvaluation::kDefaultFuel;  // --eval-fuel=N: шагов на вычисление во время компиляции
+    bool memoize = false;   // --memoize: Interpreter запоминает результаты чистых функций
+    uint64_t tierThreshold = TieredJit::kDefaultThreshold; // --tier-threshold=N: вызовов до компиляции функции
+    EmitKind emit = EmitKind::Ll;   // --emit=ll|bc|asm|obj
+    std::string output;     // -o<файл> / --output=<файл>: куда писать, по умолчанию output.<ll|bc|s|o> или program
+    bool link = false;      // --link: объектный файл компонуется системным компоновщиком в исполняемый
+
+    bool Parse(const std::string& arg);
+    static const char* Usage();
+};
+
+class LLVMCodeGenVisitor;
 
 class Program {
 public:
-    Program(std::string& program_fn, std::string& ast_fn);
-    void Run();
+    Program(std::string& program_fn, std::string& ast_fn, ProgramOptions options = {});
+    /// Код выхода процесса: результат main с --jit, иначе 0.
+    int Run();
 private:
+    void RunFlat();
+    void Execute(ProgramBlocks* blocks);
+    /// Исполняет программу через ProgramJit; false - её исполнит Interpreter.
+    bool ExecuteNative(ProgramBlocks* blocks);
+    /// Проходы по AST уровня options.optLevel.
+    void Optimize(ProgramBlocks* blocks);
+    /// Проверяет и оптимизирует модуль и пишет его в файл вида
+    /// options.emit; с --link ещё и собирает исполняемый файл.
+    void EmitIR(LLVMCodeGenVisitor& llvmVisitor);
+    /// Строит, оптимизирует и пишет функции частями на options.threads
+    /// потоках (см. ParallelCodeGen), если вывод - объектный код и
+    /// программа достаточно велика; false - нужен обычный EmitIR.
+    bool EmitParallel(ProgramBlocks* blocks);
+    /// options.output или имя по умолчанию для options.emit и --link.
+    std::string OutputPath() const;
+    /// Компонует объектные файлы с libc драйвером системного C-компилятора;
+    /// `relocatable` - в один перемещаемый объектный файл (-r).
+    bool Link(const std::vector<std::string>& objects, const std::string& output, bool relocatable);
+    /// Разбор исходника: параллельный, если разрешено больше одного потока.
+    std::unique_ptr<ProgramBlocks> Parse();
+    /// Дерево из кэша, если он подходит к исходнику, иначе результат парсера.
+    std::unique_ptr<ProgramBlocks> LoadOrParse();
+    void LoadOrParseFlat(FlatAst& flat);
+
     Lexer *lexer = nullptr; 
     Parser *parser = nullptr;
-    std::istringstream program;
+    SourceBuffer source;
     std::string& program_fn;
     std::string& ast_fn;
+    ProgramOptions options;
+    int exitCode = 0;
     std::unique_ptr<ProgramBlocks> programBlocks;
     std::map<std::string, int> variables;
 };
\ No newline at end of file
@@ -0,0 +1,191 @@
+#include "char_scan.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CHARSCAN_X86 1
+#include <immintrin.h>
+#endif
+
+namespace charscan {
+
+namespace {
+
+constexpr uint8_t classify(unsigned c) {
+    uint8_t cls = 0;
+    if (c == ' ' || (c >= '\t' && c <= '\r')) cls |= kSpace;
+    if (c >= '0' && c <= '9') cls |= kDigit | kIdent;
+    if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')) cls |= kAlpha | kIdent;
+    if (c == '_') cls |= kIdent;
+    return cls;
+}
+
+template <uint8_t Class>
+const char* skipScalar(const char* pos, const char* end) {
+    while (pos < end && (kCharClass[static_cast<unsigned char>(*pos)] & Class)) {
+        ++pos;
+    }
+    return pos;
+}
+
+#ifdef CHARSCAN_X86
+
+// Байты из [lo, hi] (беззнаково): (c - lo) насыщенно минус (hi - lo) == 0
+inline __m128i inRange128(__m128i c, char lo, char hi) {
+    __m128i shifted = _mm_sub_epi8(c, _mm_set1_epi8(lo));
+    return _mm_cmpeq_epi8(_mm_subs_epu8(shifted, _mm_set1_epi8(static_cast<char>(hi - lo))),
+                          _mm_setzero_si128());
+}
+
+inline __m128i spaceMask128(__m128i c) {
+    return _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8(' ')), inRange128(c, '\t', '\r'));
+}
+
+inline __m128i digitMask128(__m128i c) {
+    return inRange128(c, '0', '9');
+}
+
+inline __m128i identMask128(__m128i c) {
+    __m128i lower = _mm_or_si128(c, _mm_set1_epi8(0x20));
+    return _mm_or_si128(_mm_or_si128(inRange128(c, '0', '9'), inRange128(lower, 'a', 'z')),
+                        _mm_cmpeq_epi8(c, _mm_set1_epi8('_')));
+}
+
+template <__m128i (*Mask)(__m128i), uint8_t Class>
+const char* skipSSE2(const char* pos, const char* end) {
+    while (end - pos >= 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+        unsigned stop = ~static_cast<unsigned>(_mm_movemask_epi8(Mask(chunk))) & 0xFFFFu;
+        if (stop != 0) {
+            return pos + __builtin_ctz(stop);
+        }
+        pos += 16;
+    }
+    return skipScalar<Class>(pos, end);
+}
+
+__attribute__((target("avx2")))
+inline __m256i inRange256(__m256i c, char lo, char hi) {
+    __m256i shifted = _mm256_sub_epi8(c, _mm256_set1_epi8(lo));
+    return _mm256_cmpeq_epi8(_mm256_subs_epu8(shifted, _mm256_set1_epi8(static_cast<char>(hi - lo))),
+                             _mm256_setzero_si256());
+}
+
+__attribute__((target("avx2")))
+inline __m256i spaceMask256(__m256i c) {
+    return _mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8(' ')), inRange256(c, '\t', '\r'));
+}
+
+__attribute__((target("avx2")))
+inline __m256i digitMask256(__m256i c) {
+    return inRange256(c, '0', '9');
+}
+
+__attribute__((target("avx2")))
+inline __m256i identMask256(__m256i c) {
+    __m256i lower = _mm256_or_si256(c, _mm256_set1_epi8(0x20));
+    return _mm256_or_si256(_mm256_or_si256(inRange256(c, '0', '9'), inRange256(lower, 'a', 'z')),
+                           _mm256_cmpeq_epi8(c, _mm256_set1_epi8('_')));
+}
+
+template <__m256i (*Mask)(__m256i), uint8_t Class>
+__attribute__((target("avx2")))
+const char* skipAVX2(const char* pos, const char* end) {
+    while (end - pos >= 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos));
+        unsigned stop = ~static_cast<unsigned>(_mm256_movemask_epi8(Mask(chunk)));
+        if (stop != 0) {
+            return pos + __builtin_ctz(stop);
+        }
+        pos += 32;
+    }
+    return skipScalar<Class>(pos, end);
+}
+
+#endif // CHARSCAN_X86
+
+using SkipFn = const char* (*)(const char*, const char*);
+
+struct Dispatch {
+    ScanMode mode;
+    SkipFn space;
+    SkipFn ident;
+    SkipFn digits;
+};
+
+constexpr Dispatch kScalar = {ScanMode::Scalar, skipScalar<kSpace>, skipScalar<kIdent>, skipScalar<kDigit>};
+#ifdef CHARSCAN_X86
+constexpr Dispatch kSSE2 = {ScanMode::SSE2,
+                            skipSSE2<spaceMask128, kSpace>,
+                            skipSSE2<identMask128, kIdent>,
+                            skipSSE2<digitMask128, kDigit>};
+constexpr Dispatch kAVX2 = {ScanMode::AVX2,
+                            skipAVX2<spaceMask256, kSpace>,
+                            skipAVX2<identMask256, kIdent>,
+                            skipAVX2<digitMask256, kDigit>};
+#endif
+
+const Dispatch& dispatchFor(ScanMode mode) {
+#ifdef CHARSCAN_X86
+    switch (mode) {
+        case ScanMode::AVX2: return kAVX2;
+        case ScanMode::SSE2: return kSSE2;
+        default: break;
+    }
+#endif
+    return kScalar;
+}
+
+Dispatch active = dispatchFor(BestSupportedMode());
+
+} // namespace
+
+#define CLASS_ROW(base) \
+    classify(base + 0), classify(base + 1), classify(base + 2), classify(base + 3), \
+    classify(base + 4), classify(base + 5), classify(base + 6), classify(base + 7), \
+    classify(base + 8), classify(base + 9), classify(base + 10), classify(base + 11), \
+    classify(base + 12), classify(base + 13), classify(base + 14), classify(base + 15)
+
+const uint8_t kCharClass[256] = {
+    CLASS_ROW(0x00), CLASS_ROW(0x10), CLASS_ROW(0x20), CLASS_ROW(0x30),
+    CLASS_ROW(0x40), CLASS_ROW(0x50), CLASS_ROW(0x60), CLASS_ROW(0x70),
+    CLASS_ROW(0x80), CLASS_ROW(0x90), CLASS_ROW(0xA0), CLASS_ROW(0xB0),
+    CLASS_ROW(0xC0), CLASS_ROW(0xD0), CLASS_ROW(0xE0), CLASS_ROW(0xF0),
+};
+
+#undef CLASS_ROW
+
+const char* SkipSpaceLong(const char* pos, const char* end) { return active.space(pos, end); }
+const char* SkipIdentLong(const char* pos, const char* end) { return active.ident(pos, end); }
+const char* SkipDigitsLong(const char* pos, const char* end) { return active.digits(pos, end); }
+
+ScanMode ActiveMode() {
+    return active.mode;
+}
+
+ScanMode BestSupportedMode() {
+#ifdef CHARSCAN_X86
+    __builtin_cpu_init();   // может вызываться из статической инициализации
+    if (__builtin_cpu_supports("avx2")) {
+        return ScanMode::AVX2;
+    }
+    return ScanMode::SSE2;
+#else
+    return ScanMode::Scalar;
+#endif
+}
+
+void SetMode(ScanMode mode) {
+    if (mode == ScanMode::AVX2 && BestSupportedMode() != ScanMode::AVX2) {
+        return;
+    }
+    active = dispatchFor(mode);
+}
+
+const char* ModeName(ScanMode mode) {
+    switch (mode) {
+        case ScanMode::SSE2: return "sse2";
+        case ScanMode::AVX2: return "avx2";
+        default: return "scalar";
+    }
+}
+
+} // namespace charscan
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+
+/// Классификация символов для лексера без <cctype>: не зависит от локали,
+/// а длинные серии пробелов, идентификаторов и цифр пропускаются блоками
+/// по 16 (SSE2) или 32 (AVX2) байта. Реализация выбирается при старте по CPUID.
+namespace charscan {
+
+enum CharClass : uint8_t {
+    kSpace = 1,
+    kDigit = 2,
+    kAlpha = 4,
+    kIdent = 8,     // буква, цифра или '_'
+};
+
+extern const uint8_t kCharClass[256];
+
+inline bool IsSpace(char c) { return kCharClass[static_cast<unsigned char>(c)] & kSpace; }
+inline bool IsDigit(char c) { return kCharClass[static_cast<unsigned char>(c)] & kDigit; }
+inline bool IsAlpha(char c) { return kCharClass[static_cast<unsigned char>(c)] & kAlpha; }
+inline bool IsIdent(char c) { return kCharClass[static_cast<unsigned char>(c)] & kIdent; }
+
+enum class ScanMode {
+    Scalar,
+    SSE2,
+    AVX2,
+};
+
+/// Длинные серии: блочный поиск выбранной реализацией.
+const char* SkipSpaceLong(const char* pos, const char* end);
+const char* SkipIdentLong(const char* pos, const char* end);
+const char* SkipDigitsLong(const char* pos, const char* end);
+
+/// Короткие серии (типичный случай в рукописном коде) дешевле разобрать
+/// на месте, блочный поиск включается только после kShortRun байт.
+constexpr int kShortRun = 8;
+
+template <uint8_t Class, const char* (*Long)(const char*, const char*)>
+inline const char* SkipClass(const char* pos, const char* end) {
+    for (int i = 0; i < kShortRun; ++i, ++pos) {
+        if (pos >= end || !(kCharClass[static_cast<unsigned char>(*pos)] & Class)) {
+            return pos;
+        }
+    }
+    return Long(pos, end);
+}
+
+/// Каждая функция возвращает первый байт в [pos, end), не принадлежащий классу.
+inline const char* SkipSpace(const char* pos, const char* end) { return SkipClass<kSpace, SkipSpaceLong>(pos, end); }
+inline const char* SkipIdent(const char* pos, const char* end) { return SkipClass<kIdent, SkipIdentLong>(pos, end); }
+inline const char* SkipDigits(const char* pos, const char* end) { return SkipClass<kDigit, SkipDigitsLong>(pos, end); }
+
+ScanMode ActiveMode();
+ScanMode BestSupportedMode();
+/// Переключение реализации (для бенчмарков); неподдерживаемый режим игнорируется.
+void SetMode(ScanMode mode);
+const char* ModeName(ScanMode mode);
+
+} // namespace charscan
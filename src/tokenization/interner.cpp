@@ -0,0 +1,18 @@
+#include "interner.hpp"
+
+Interner& Interner::Global() {
+    static Interner interner;
+    return interner;
+}
+
+SymbolId Interner::Intern(std::string_view name) {
+    auto it = ids_.find(name);
+    if (it != ids_.end()) {
+        return it->second;
+    }
+    const std::string& stored = storage_.emplace_back(name);
+    SymbolId id = static_cast<SymbolId>(names_.size());
+    names_.push_back(stored);
+    ids_.emplace(names_.back(), id);
+    return id;
+}
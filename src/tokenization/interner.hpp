@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/// Плотный 32-битный номер идентификатора: одинаковые имена получают один номер,
+/// номера идут подряд с нуля, поэтому их удобно использовать как индекс в векторах.
+using SymbolId = uint32_t;
+
+/// Глобальная таблица идентификаторов. Лексер регистрирует каждое имя один раз,
+/// дальше AST и визиторы работают только с номерами.
+/// Не потокобезопасна: регистрировать имена можно только из одного потока.
+/// Параллельный разбор заводит по таблице на поток и потом переводит
+/// номера в глобальные (см. ParallelParser).
+class Interner {
+public:
+    static Interner& Global();
+
+    SymbolId Intern(std::string_view name);
+    std::string_view Name(SymbolId id) const { return names_[id]; }
+    size_t Size() const { return names_.size(); }
+
+private:
+    std::deque<std::string> storage_;   // deque не переносит строки при росте
+    std::vector<std::string_view> names_;
+    std::unordered_map<std::string_view, SymbolId> ids_;
+};
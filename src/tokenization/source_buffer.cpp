@@ -0,0 +1,95 @@
+#include "source_buffer.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+SourceBuffer::SourceBuffer(std::string text) : owned_(std::move(text)) {
+    data_ = owned_.data();
+    size_ = owned_.size();
+}
+
+SourceBuffer::~SourceBuffer() {
+    Release();
+}
+
+SourceBuffer::SourceBuffer(SourceBuffer&& other) noexcept {
+    *this = std::move(other);
+}
+
+SourceBuffer& SourceBuffer::operator=(SourceBuffer&& other) noexcept {
+    if (this == &other) {
+        return *this;
+    }
+    Release();
+    mapped_ = other.mapped_;
+    size_ = other.size_;
+    if (mapped_) {
+        data_ = other.data_;
+    } else {
+        owned_ = std::move(other.owned_);
+        data_ = owned_.data();
+    }
+    other.data_ = nullptr;
+    other.size_ = 0;
+    other.mapped_ = false;
+    return *this;
+}
+
+void SourceBuffer::Release() {
+    if (mapped_) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+    owned_.clear();
+    data_ = nullptr;
+    size_ = 0;
+    mapped_ = false;
+}
+
+SourceBuffer SourceBuffer::FromFile(const std::string& filename) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Не удалось открыть файл " + filename);
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        throw std::runtime_error("Не удалось получить размер файла " + filename);
+    }
+
+    SourceBuffer buffer;
+    size_t size = static_cast<size_t>(st.st_size);
+    if (size == 0) {
+        close(fd);
+        return buffer;
+    }
+
+    void* addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr != MAP_FAILED) {
+        madvise(addr, size, MADV_SEQUENTIAL);
+        buffer.data_ = static_cast<const char*>(addr);
+        buffer.size_ = size;
+        buffer.mapped_ = true;
+        close(fd);
+        return buffer;
+    }
+
+    // mmap недоступен (например, pipe или procfs) - читаем файл целиком одним буфером
+    std::string text(size, '\0');
+    size_t done = 0;
+    while (done < size) {
+        ssize_t got = read(fd, text.data() + done, size - done);
+        if (got <= 0) {
+            break;
+        }
+        done += static_cast<size_t>(got);
+    }
+    close(fd);
+    text.resize(done);
+    return SourceBuffer(std::move(text));
+}
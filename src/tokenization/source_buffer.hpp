@@ -0,0 +1,34 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+/// Весь исходный текст программы, загруженный в память ровно один раз.
+/// Файл отображается через mmap (если не получилось - читается одним read),
+/// токены лексера ссылаются прямо в этот буфер через std::string_view,
+/// поэтому буфер должен жить дольше лексера и парсера.
+class SourceBuffer {
+public:
+    SourceBuffer() = default;
+    explicit SourceBuffer(std::string text);
+    ~SourceBuffer();
+
+    SourceBuffer(const SourceBuffer&) = delete;
+    SourceBuffer& operator=(const SourceBuffer&) = delete;
+    SourceBuffer(SourceBuffer&& other) noexcept;
+    SourceBuffer& operator=(SourceBuffer&& other) noexcept;
+
+    static SourceBuffer FromFile(const std::string& filename);
+
+    std::string_view View() const { return {data_, size_}; }
+    const char* Data() const { return data_; }
+    size_t Size() const { return size_; }
+
+private:
+    void Release();
+
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    bool mapped_ = false;
+    std::string owned_;
+};
@@ -1,86 +1,154 @@
 #include "tokenize.hpp"
 
-Token Lexer::readNumber() {
-    std::string value;
-    while (std::isdigit(currentChar)) {
-        value += currentChar;
-        advance();
+#include <iterator>
+
+std::string_view TokenSpelling(TokenKind kind) {
+    switch (kind) {
+        case TokenKind::KwIf: return "if";
+        case TokenKind::KwElse: return "else";
+        case TokenKind::KwDeclare: return "declare";
+        case TokenKind::KwPrint: return "print";
+        case TokenKind::KwReturn: return "return";
+        case TokenKind::KwInt: return "int";
+        case TokenKind::KwFunc: return "func";
+        case TokenKind::Plus: return "+";
+        case TokenKind::Minus: return "-";
+        case TokenKind::Star: return "*";
+        case TokenKind::Slash: return "/";
+        case TokenKind::Assign: return "=";
+        case TokenKind::Bang: return "!";
+        case TokenKind::Less: return "<";
+        case TokenKind::Greater: return ">";
+        case TokenKind::EqualEqual: return "==";
+        case TokenKind::NotEqual: return "!=";
+        case TokenKind::LessEqual: return "<=";
+        case TokenKind::GreaterEqual: return ">=";
+        case TokenKind::Semicolon: return ";";
+        case TokenKind::Colon: return ":";
+        case TokenKind::Comma: return ",";
+        case TokenKind::LParen: return "(";
+        case TokenKind::RParen: return ")";
+        case TokenKind::LBrace: return "{";
+        case TokenKind::RBrace: return "}";
+        default: return "";
     }
-    return {TokenType::Number, value};
+}
+
+Lexer::Lexer(std::istream& in) :
+    owned(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()),
+    pos(owned.data()), end(owned.data() + owned.size()),
+    currentChar(owned.empty() ? '\0' : owned.front()) {}
+
+Token Lexer::readNumber() {
+    const char* start = pos;
+    seek(charscan::SkipDigits(pos, end));
+    return makeToken(TokenKind::Number, TokenType::Number, start);
 }
 
 Token Lexer::readOperator() {
+    const char* start = pos;
     char first = currentChar;
     advance();
 
-    if (first == '+' ||
-        first == '-' ||
-        first == '/' ||
-        first == '*') {
-        return {TokenType::Operator, std::string(1, first)};
-    } else {
-        // advance();
-        if ((first == '=' || first == '!' || first == '<' || first == '>') && currentChar == '=') {
-            std::string op = std::string(1, first) + "=";
-            advance();
-            return {TokenType::Operator, op};
-        }
+    switch (first) {
+        case '+': return makeToken(TokenKind::Plus, TokenType::Operator, start);
+        case '-': return makeToken(TokenKind::Minus, TokenType::Operator, start);
+        case '*': return makeToken(TokenKind::Star, TokenType::Operator, start);
+        case '/': return makeToken(TokenKind::Slash, TokenType::Operator, start);
+        default: break;
     }
 
-    return {TokenType::Operator, std::string(1, first)};
+    bool withEqual = (currentChar == '=');
+    if (withEqual) {
+        advance();
+    }
+    switch (first) {
+        case '=': return makeToken(withEqual ? TokenKind::EqualEqual : TokenKind::Assign, TokenType::Operator, start);
+        case '!': return makeToken(withEqual ? TokenKind::NotEqual : TokenKind::Bang, TokenType::Operator, start);
+        case '<': return makeToken(withEqual ? TokenKind::LessEqual : TokenKind::Less, TokenType::Operator, start);
+        default:  return makeToken(withEqual ? TokenKind::GreaterEqual : TokenKind::Greater, TokenType::Operator, start);
+    }
+}
+
+namespace {
+
+struct KeywordEntry {
+    std::string_view spelling;
+    TokenKind kind;
+};
+
+/// Совершенный хеш для ключевых слов: (4 * первая буква + последняя) & 7
+/// не даёт коллизий на семи словах языка, поэтому проверка - одно сравнение.
+constexpr KeywordEntry kKeywords[8] = {
+    {"int", TokenKind::KwInt},          // 0
+    {"else", TokenKind::KwElse},        // 1
+    {"if", TokenKind::KwIf},            // 2
+    {"func", TokenKind::KwFunc},        // 3
+    {"print", TokenKind::KwPrint},      // 4
+    {"declare", TokenKind::KwDeclare},  // 5
+    {"return", TokenKind::KwReturn},    // 6
+    {"", TokenKind::Identifier},        // 7
+};
+
+TokenKind lookupKeyword(std::string_view word) {
+    unsigned hash = (4u * static_cast<unsigned char>(word.front()) +
+                     static_cast<unsigned char>(word.back())) & 7u;
+    const KeywordEntry& entry = kKeywords[hash];
+    return entry.spelling == word ? entry.kind : TokenKind::Identifier;
 }
 
+} // namespace
+
 Token Lexer::readIdentifier() {
-    std::string value;
-    while (std::isalnum(currentChar) || currentChar == '_') {
-        value += currentChar;
-        advance();
-    }
+    const char* start = pos;
+    seek(charscan::SkipIdent(pos, end));
+    std::string_view value(start, pos - start);
 
-    if (value == "if" ||
-        value == "else" ||
-        value == "declare" ||
-        value == "print" ||
-        value == "return" ||
-        value == "int" ||
-        value == "func") {
-        return {TokenType::Keyword, value};
+    TokenKind kind = lookupKeyword(value);
+    if (kind != TokenKind::Identifier) {
+        return {kind, TokenType::Keyword, value};
     }
-
-    return {TokenType::Identifier, value};
+    return {TokenKind::Identifier, TokenType::Identifier, value, interner->Intern(value)};
 }
 
-Token Lexer::nextToken(){
+Token Lexer::scanToken(){
     skipWhitespace();
 
-    if (std::isdigit(currentChar)) {
+    if (pos >= end) {
+        return {TokenKind::EndOfFile, TokenType::EndOfFile, ""};
+    }
+
+    if (charscan::IsDigit(currentChar)) {
         return readNumber();
     }
-    if (std::isalpha(currentChar)) {
+    if (charscan::IsAlpha(currentChar)) {
         return readIdentifier();
     }
-    if (currentChar == '=' ||
-        currentChar == '!' ||
-        currentChar == '<' ||
-        currentChar == '+' ||
-        currentChar == '-' ||
-        currentChar == '*' ||
-        currentChar == '/' ||
-        currentChar == '>') {
-        return readOperator();
-    } 
-    
-    if (std::string(";:{}(),").find(currentChar) != std::string::npos) {
-        char symbol = currentChar;
-        advance();
-        return {TokenType::Symbol, std::string(1, symbol)};
-    }
 
-    if (input.eof()) {
-        return {TokenType::EndOfFile, ""};
+    const char* start = pos;
+    switch (currentChar) {
+        case '=':
+        case '!':
+        case '<':
+        case '>':
+        case '+':
+        case '-':
+        case '*':
+        case '/':
+            return readOperator();
+
+        case ';': advance(); return makeToken(TokenKind::Semicolon, TokenType::Symbol, start);
+        case ':': advance(); return makeToken(TokenKind::Colon, TokenType::Symbol, start);
+        case ',': advance(); return makeToken(TokenKind::Comma, TokenType::Symbol, start);
+        case '(': advance(); return makeToken(TokenKind::LParen, TokenType::Symbol, start);
+        case ')': advance(); return makeToken(TokenKind::RParen, TokenType::Symbol, start);
+        case '{': advance(); return makeToken(TokenKind::LBrace, TokenType::Symbol, start);
+        case '}': advance(); return makeToken(TokenKind::RBrace, TokenType::Symbol, start);
+
+        default: break;
     }
 
     std::cerr << "Ошибка: неизвестный символ '" << currentChar << "'\n";
     advance();
-    return nextToken();
-}
\ No newline at end of file
+    return scanToken();
+}
@@ -1,11 +1,14 @@
-#pragma once 
+#pragma once
 #include <iostream>
-#include <cctype>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "char_scan.hpp"
+#include "interner.hpp"
+
 enum class TokenType {
-    Identifier, 
+    Identifier,
     Number,
     Keyword,
     Operator,
@@ -13,30 +16,122 @@ enum class TokenType {
     EndOfFile
 };
 
+/// Точный вид токена: по одному значению на каждое ключевое слово,
+/// оператор и разделитель, чтобы парсер выбирал ветку через switch,
+/// а не сравнением строк.
+enum class TokenKind {
+    Identifier,
+    Number,
+
+    // ключевые слова
+    KwIf,
+    KwElse,
+    KwDeclare,
+    KwPrint,
+    KwReturn,
+    KwInt,
+    KwFunc,
+
+    // операторы
+    Plus,          // +
+    Minus,         // -
+    Star,          // *
+    Slash,         // /
+    Assign,        // =
+    Bang,          // !
+    Less,          // <
+    Greater,       // >
+    EqualEqual,    // ==
+    NotEqual,      // !=
+    LessEqual,     // <=
+    GreaterEqual,  // >=
+
+    // разделители
+    Semicolon,     // ;
+    Colon,         // :
+    Comma,         // ,
+    LParen,        // (
+    RParen,        // )
+    LBrace,        // {
+    RBrace,        // }
+
+    EndOfFile
+};
+
+/// Каноническое написание ключевых слов, операторов и разделителей;
+/// строки статические и переживают любой исходный буфер.
+std::string_view TokenSpelling(TokenKind kind);
+
+/// `value` указывает внутрь исходного буфера лексера (без копирования),
+/// поэтому токен валиден, пока жив буфер (см. SourceBuffer).
 struct Token {
+    TokenKind kind;
     TokenType type;
-    std::string value;
-    // Token(TokenType t, std::string v) : type(t), value(std::move(v)) {}
+    std::string_view value;
+    SymbolId symbol = 0;    // номер имени в таблице лексера (обычно Interner::Global()), только для Identifier
 };
 
 class Lexer {
-    std::istream& input;
+    std::string owned;      // используется только конструктором из std::istream
+    const char* pos;
+    const char* end;
     char currentChar;
+    Token peeked;           // буфер просмотра вперёд на один токен
+    bool hasPeeked = false;
+    Interner* interner = &Interner::Global();   // куда регистрируются имена
 
-    void advance() { 
-        currentChar = input.get();
+    void advance() {
+        ++pos;
+        currentChar = pos < end ? *pos : '\0';
+    }
+
+    void seek(const char* to) {
+        pos = to;
+        currentChar = pos < end ? *pos : '\0';
     }
 
     void skipWhitespace() {
-        while (std::isspace(currentChar)) advance();
+        if (charscan::IsSpace(currentChar)) seek(charscan::SkipSpace(pos, end));
     }
 
     Token readNumber();
     Token readIdentifier();
     Token readOperator();
+    Token scanToken();
+    Token makeToken(TokenKind kind, TokenType type, const char* start) const {
+        return {kind, type, std::string_view(start, pos - start)};
+    }
 
 public:
-    explicit Lexer(std::istream& in) : input(in), currentChar(' ') { advance(); }
+    /// Основной режим: лексер читает прямо из буфера, который должен пережить все токены.
+    explicit Lexer(std::string_view source) :
+        pos(source.data()), end(source.data() + source.size()),
+        currentChar(source.empty() ? '\0' : source.front()) {}
+
+    /// Имена регистрируются в отдельной таблице, а не в Interner::Global():
+    /// так несколько лексеров могут работать в разных потоках.
+    Lexer(std::string_view source, Interner& names) : Lexer(source) { interner = &names; }
+
+    /// Поток вычитывается целиком в собственный буфер лексера.
+    explicit Lexer(std::istream& in);
 
-    Token nextToken();
+    /// Таблица, в которой лежат номера Token::symbol этого лексера.
+    const Interner& symbols() const { return *interner; }
+
+    Token nextToken() {
+        if (hasPeeked) {
+            hasPeeked = false;
+            return peeked;
+        }
+        return scanToken();
+    }
+
+    /// Следующий токен без его извлечения из потока.
+    const Token& peekToken() {
+        if (!hasPeeked) {
+            peeked = scanToken();
+            hasPeeked = true;
+        }
+        return peeked;
+    }
 };
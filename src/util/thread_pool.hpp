@@ -0,0 +1,47 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/// Пул рабочих потоков фиксированного размера с общей очередью задач.
+/// Submit возвращает std::future: исключение из задачи пробрасывается
+/// в get(). Деструктор дожидается выполнения всех поставленных задач.
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t threads = DefaultThreads());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    template <class Fn>
+    std::future<std::invoke_result_t<Fn>> Submit(Fn&& fn) {
+        using Result = std::invoke_result_t<Fn>;
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Fn>(fn));
+        std::future<Result> result = task->get_future();
+        Enqueue([task] { (*task)(); });
+        return result;
+    }
+
+    size_t Size() const { return workers_.size(); }
+
+    /// Число аппаратных потоков, но не меньше одного.
+    static size_t DefaultThreads();
+
+private:
+    void Enqueue(std::function<void()> job);
+    void WorkerLoop();
+
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> queue_;
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    bool stopping_ = false;
+};
@@ -0,0 +1,284 @@
+#include "flat_interpreter.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+#include "../parsing/ast.hpp"
+
+namespace {
+
+/// Раздача ячеек, как у Resolver: параметры по порядку, затем имена
+/// из присваиваний и объявлений; чтения разрешаются в конце функции.
+class FlatResolver {
+public:
+    FlatResolver(const FlatAst& ast, std::vector<uint32_t>& exprSlot, std::vector<uint32_t>& stmtSlot,
+                 std::vector<uint32_t>& paramSlot) :
+        ast(ast), exprSlot(exprSlot), stmtSlot(stmtSlot), paramSlot(paramSlot),
+        slotOf(Interner::Global().Size(), kNoSlot) {}
+
+    uint32_t Function(const FlatFunction& func) {
+        frameSize = 0;
+        for (uint32_t i = 0; i < func.paramCount; ++i) {
+            paramSlot[func.params + i] = SlotFor(ast.FunctionParam(func, i));
+        }
+        Block(func.body);
+        for (FlatRef read : reads) {
+            SymbolId name = ast.exprA[read];
+            exprSlot[read] = name < slotOf.size() ? slotOf[name] : kNoSlot;
+        }
+        reads.clear();
+        for (SymbolId name : touched) {
+            slotOf[name] = kNoSlot;
+        }
+        touched.clear();
+        return frameSize;
+    }
+
+private:
+    const FlatAst& ast;
+    std::vector<uint32_t>& exprSlot;
+    std::vector<uint32_t>& stmtSlot;
+    std::vector<uint32_t>& paramSlot;
+    std::vector<uint32_t> slotOf;
+    std::vector<SymbolId> touched;
+    std::vector<FlatRef> reads;
+    uint32_t frameSize = 0;
+
+    uint32_t SlotFor(SymbolId name) {
+        if (slotOf.size() <= name) {
+            slotOf.resize(name + 1, kNoSlot);
+        }
+        if (slotOf[name] == kNoSlot) {
+            slotOf[name] = frameSize++;
+            touched.push_back(name);
+        }
+        return slotOf[name];
+    }
+
+    void Block(FlatRef block) {
+        for (uint32_t i = 0; i < ast.blockSize[block]; ++i) {
+            Stmt(ast.BlockStmt(block, i));
+        }
+    }
+
+    void Stmt(FlatRef stmt) {
+        uint32_t a = ast.stmtA[stmt];
+        switch (ast.stmtKind[stmt]) {
+            case FlatStmtKind::Declare:
+                stmtSlot[stmt] = SlotFor(a);
+                break;
+            case FlatStmtKind::Assign:
+                Expr(ast.stmtB[stmt]);
+                stmtSlot[stmt] = SlotFor(a);
+                break;
+            case FlatStmtKind::Print:
+            case FlatStmtKind::Return:
+                Expr(a);
+                break;
+            case FlatStmtKind::If:
+                Expr(a);
+                Block(ast.stmtB[stmt]);
+                if (ast.stmtC[stmt] != kNoFlatRef) {
+                    Block(ast.stmtC[stmt]);
+                }
+                break;
+        }
+    }
+
+    void Expr(FlatRef expr) {
+        switch (ast.exprKind[expr]) {
+            case FlatExprKind::Number:
+                break;
+            case FlatExprKind::Variable:
+                reads.push_back(expr);
+                break;
+            case FlatExprKind::Binary:
+            case FlatExprKind::Compare:
+                Expr(ast.exprA[expr]);
+                Expr(ast.exprB[expr]);
+                break;
+            case FlatExprKind::Call:
+                for (uint32_t i = 0; i < ast.CallArgCount(expr); ++i) {
+                    Expr(ast.CallArg(expr, i));
+                }
+                break;
+        }
+    }
+};
+
+} // namespace
+
+FlatInterpreter::FlatInterpreter(const FlatAst& ast) :
+    ast_(ast), expr_slot_(ast.exprKind.size(), kNoSlot), stmt_slot_(ast.stmtKind.size(), kNoSlot),
+    param_slot_(ast.refs.size(), kNoSlot), call_target_(ast.exprKind.size(), nullptr), stack_(kInitialStack), defined_(kInitialStack)
+{
+    FlatResolver resolver(ast_, expr_slot_, stmt_slot_, param_slot_);
+    frame_size_.reserve(ast_.functions.size());
+    for (const FlatFunction& func : ast_.functions) {
+        frame_size_.push_back(resolver.Function(func));
+    }
+}
+
+void FlatInterpreter::Run() {
+    for (const FlatItem& item : ast_.items) {
+        if (!item.isFunction) {
+            continue;   // операторы верхнего уровня Interpreter тоже не исполняет
+        }
+        const FlatFunction& func = ast_.functions[item.ref];
+        if (functions_.size() <= func.name) {
+            functions_.resize(func.name + 1, nullptr);
+        }
+        if (functions_[func.name] == nullptr) {
+            functions_[func.name] = &func;
+        }
+        if (func.name == main_id_) {
+            RunFrame(func, PushFrame(func));
+        }
+    }
+}
+
+void FlatInterpreter::ExecBlock(FlatRef block) {
+    uint32_t size = ast_.blockSize[block];
+    for (uint32_t i = 0; i < size && !returning_; ++i) {
+        ExecStmt(ast_.BlockStmt(block, i));
+    }
+}
+
+void FlatInterpreter::ExecStmt(FlatRef stmt) {
+    uint32_t a = ast_.stmtA[stmt];
+    switch (ast_.stmtKind[stmt]) {
+        case FlatStmtKind::Declare:
+            if (!IsDefined(stmt_slot_[stmt])) {
+                SetVariable(stmt_slot_[stmt], 0);
+            } else {
+                std::cerr << "Ошибка: переменная" << Interner::Global().Name(a) << "уже существует\n";
+            }
+            break;
+        case FlatStmtKind::Assign: {
+            int value = Eval(ast_.stmtB[stmt]);
+            if (ast_.stmtC[stmt] != kNoFlatRef) {
+                std::cout << "expression = " << value << std::endl;
+            }
+            SetVariable(stmt_slot_[stmt], value);
+            break;
+        }
+        case FlatStmtKind::Print: {
+            int value = Eval(a);    // вызовы внутри могут печатать сами
+            std::cout << value << std::endl;
+            break;
+        }
+        case FlatStmtKind::Return: {
+            int value = Eval(a);
+            std::cout << "expression = " << value << std::endl;
+            calced_value_ = value;
+            returning_ = true;
+            break;
+        }
+        case FlatStmtKind::If:
+            if (Eval(a)) {
+                ExecBlock(ast_.stmtB[stmt]);
+            } else if (ast_.stmtC[stmt] != kNoFlatRef) {
+                ExecBlock(ast_.stmtC[stmt]);
+            }
+            break;
+    }
+}
+
+int FlatInterpreter::Eval(FlatRef expr) {
+    uint32_t a = ast_.exprA[expr];
+    switch (ast_.exprKind[expr]) {
+        case FlatExprKind::Number:
+            calced_value_ = ast_.NumberValue(expr);
+            break;
+        case FlatExprKind::Variable:
+            if (IsDefined(expr_slot_[expr])) {
+                calced_value_ = stack_[fp_ + expr_slot_[expr]];
+            } else {
+                std::cerr << "Ошибка: переменной " << Interner::Global().Name(a) << " не существует\n";
+            }
+            break;
+        case FlatExprKind::Binary: {
+            int left = Eval(a);
+            int right = Eval(ast_.exprB[expr]);
+            switch (static_cast<BinaryOp>(ast_.exprOp[expr])) {
+                case BinaryOp::Add: calced_value_ = left + right; break;
+                case BinaryOp::Sub: calced_value_ = left - right; break;
+                case BinaryOp::Mul: calced_value_ = left * right; break;
+                case BinaryOp::Div: calced_value_ = left / right; break;
+            }
+            break;
+        }
+        case FlatExprKind::Compare: {
+            int left = Eval(a);
+            int right = Eval(ast_.exprB[expr]);
+            switch (static_cast<CompareOp>(ast_.exprOp[expr])) {
+                case CompareOp::Eq: calced_value_ = left == right; break;
+                case CompareOp::Ne: calced_value_ = left != right; break;
+                case CompareOp::Lt: calced_value_ = left < right; break;
+                case CompareOp::Gt: calced_value_ = left > right; break;
+                case CompareOp::Le: calced_value_ = left <= right; break;
+                case CompareOp::Ge: calced_value_ = left >= right; break;
+            }
+            break;
+        }
+        case FlatExprKind::Call:
+            return Call(expr);
+    }
+    return calced_value_;
+}
+
+int FlatInterpreter::Call(FlatRef expr) {
+    const FlatFunction* func = call_target_[expr];
+    uint32_t argc = ast_.CallArgCount(expr);
+    if (func == nullptr) {
+        SymbolId name = ast_.exprA[expr];
+        func = name < functions_.size() ? functions_[name] : nullptr;
+        if (func == nullptr) {
+            std::cerr << "no such function: " << Interner::Global().Name(name) << std::endl;
+            return calced_value_;
+        }
+        if (argc != func->paramCount) {
+            std::cerr << "wrong argument number" << std::endl;
+            return calced_value_;
+        }
+        call_target_[expr] = func;
+    }
+    size_t base = PushFrame(*func);
+    for (uint32_t i = 0; i < argc; ++i) {
+        size_t slot = base + param_slot_[func->params + i];
+        stack_[slot] = Eval(ast_.CallArg(expr, i));
+        defined_[slot] = 1;
+    }
+    RunFrame(*func, base);
+    return calced_value_;
+}
+
+size_t FlatInterpreter::PushFrame(const FlatFunction& func) {
+    size_t base = sp_;
+    sp_ += frame_size_[&func - ast_.functions.data()];
+    if (stack_.size() < sp_) {
+        size_t size = std::max(stack_.size() * 2, sp_);
+        stack_.resize(size);
+        defined_.resize(size);
+    }
+    std::fill(defined_.begin() + base, defined_.begin() + sp_, 0);
+    return base;
+}
+
+void FlatInterpreter::RunFrame(const FlatFunction& func, size_t base) {
+    size_t savedFp = fp_;
+    fp_ = base;
+    ExecBlock(func.body);
+    returning_ = false;
+    fp_ = savedFp;
+    sp_ = base;
+}
+
+bool FlatInterpreter::IsDefined(uint32_t slot) const {
+    return slot != kNoSlot && defined_[fp_ + slot];
+}
+
+void FlatInterpreter::SetVariable(uint32_t slot, int value) {
+    stack_[fp_ + slot] = value;
+    defined_[fp_ + slot] = 1;
+}
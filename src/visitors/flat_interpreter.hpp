@@ -0,0 +1,46 @@
+#pragma once
+
+#include <vector>
+
+#include "../parsing/flat_ast.hpp"
+
+/// Интерпретатор плоского AST. Повторяет поведение Interpreter
+/// (те же print/return и кадры вызовов), но обходит массивы FlatAst
+/// через switch вместо двойной диспетчеризации Accept/Visit.
+/// Ячейки переменных раздаются в конструкторе по тем же правилам, что
+/// и у Resolver, и хранятся в массивах параллельно узлам FlatAst.
+class FlatInterpreter {
+public:
+    explicit FlatInterpreter(const FlatAst& ast);
+    void Run();
+
+private:
+    static constexpr size_t kInitialStack = 1 << 16;
+
+    const FlatAst& ast_;
+    std::vector<uint32_t> expr_slot_;           // ячейка для Variable
+    std::vector<uint32_t> stmt_slot_;           // ячейка для Declare и Assign
+    std::vector<uint32_t> param_slot_;          // параллельно ast_.refs, заполнен на местах параметров
+    std::vector<uint32_t> frame_size_;          // индекс - номер функции в ast_.functions
+    /// Для Call: функция, найденная при первом успешном вызове, как FunctionCall::target.
+    std::vector<const FlatFunction*> call_target_;
+    std::vector<const FlatFunction*> functions_;    // индекс - SymbolId
+    SymbolId main_id_ = Interner::Global().Intern("main");
+    int calced_value_ = 0;
+
+    std::vector<int> stack_;
+    std::vector<char> defined_;
+    size_t fp_ = 0;
+    size_t sp_ = 0;
+    bool returning_ = false;
+
+    void ExecBlock(FlatRef block);
+    void ExecStmt(FlatRef stmt);
+    int Eval(FlatRef expr);
+    int Call(FlatRef expr);
+
+    size_t PushFrame(const FlatFunction& func);
+    void RunFrame(const FlatFunction& func, size_t base);
+    bool IsDefined(uint32_t slot) const;
+    void SetVariable(uint32_t slot, int value);
+};
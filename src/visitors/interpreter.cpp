@@ -1,5 +1,12 @@
 #include "interpreter.hpp"
 #include "../parsing/ast.hpp"
+#include "../passes/call_graph.hpp"
+#include "../passes/node_counter.hpp"
+#include "../passes/purity.hpp"
+#include "../jit/tiered_jit.hpp"
+
+#include <algorithm>
+#include <unordered_map>
 
 
 void Interpreter::Visit(ASTNode* node) {
@@ -11,6 +18,9 @@ void Interpreter::Visit(std::string& program) {
 }
 
 void Interpreter::Visit(ProgramBlocks* programBlocks) {
+    if (memoize_) {
+        FindMemoizable(programBlocks);
+    }
     for (auto&& block: programBlocks->blocks) {
         block->Accept(this);
     }
@@ -23,12 +33,14 @@ void Interpreter::Visit(ProgramBlock* programBlock) {
 
 
 void Interpreter::Visit(FunctionDeclaration* func) {
-    if (variables_.count(func->name) == 0) {
-        variables_.emplace(func->name, 0);
-        functions_.emplace(func->name, func);
+    if (FindFunction(func->name) == nullptr) {
+        if (functions_.size() <= func->name) {
+            functions_.resize(func->name + 1, nullptr);
+        }
+        functions_[func->name] = func;
     }
-    if (func->name == "main") {
-        func->body->Accept(this);
+    if (func->name == main_id_) {
+        RunFrame(func, PushFrame(func));
     }
 }
 void Interpreter::Visit(Parameter* parameter) {
@@ -41,6 +53,9 @@ void Interpreter::Visit(Type* type) {
 void Interpreter::Visit(StatementList* statement_list) {
     for (auto&& stmnt: statement_list->statements) {
         stmnt->Accept(this);
+        if (returning_) {
+            break;
+        }
     }
     // UnsetTosValue();
 }
@@ -50,15 +65,18 @@ void Interpreter::Visit(Statement* statement) {
 }
 void Interpreter::Visit(Assignment* assignment) {
     assignment->expression->Accept(this);
-    variables_[assignment->variable] = calced_value_;
+    if (assignment->inlinedReturn) {
+        Echo(calced_value_);
+    }
+    SetVariable(assignment->slot, calced_value_);
 
     // UnsetCalcedValue();
 }
 void Interpreter::Visit(Declaration* declaration) {
-    if (variables_.count(declaration->varName) == 0) {
-        variables_.emplace(declaration->varName, 0);
+    if (!IsDefined(declaration->slot)) {
+        SetVariable(declaration->slot, 0);
     } else {
-        std::cerr << "Ошибка: переменная" << declaration->varName << "уже существует\n";
+        Error() << "Ошибка: переменная" << Interner::Global().Name(declaration->varName) << "уже существует\n";
     }
 }
 void Interpreter::Visit(PrintStatement* print_statement) {
@@ -66,10 +84,18 @@ void Interpreter::Visit(PrintStatement* print_statement) {
     SetTosValue(calced_value_);
     std::cout << tos_value_ << std::endl;
 }
+void Interpreter::PrintFromNative(int value) {
+    SetTosValue(value);
+    std::cout << tos_value_ << std::endl;
+}
 void Interpreter::Visit(ReturnStatement* returnStatement) {
+    tail_position_ = returnStatement->tailCall != nullptr;
     returnStatement->expression->Accept(this);
-    std::cout << "expression = " << calced_value_ << std::endl;
-    // SetCalcedValue(calced_value_);
+    returning_ = true;
+    // после хвостового вызова строку напечатает RunFrame
+    if (tail_call_ == nullptr) {
+        Echo(calced_value_);
+    }
 }
 void Interpreter::Visit(IfStatement* statement) {
     statement->condition->Accept(this);
@@ -80,7 +106,7 @@ void Interpreter::Visit(IfStatement* statement) {
             statement->elseBranch->Accept(this);
         }
     } else {
-        std::cerr << "Ошибка: Некорректное условие в if-выражении\n";
+        Error() << "Ошибка: Некорректное условие в if-выражении\n";
     }
 }
 
@@ -91,10 +117,10 @@ void Interpreter::Visit(Number* expression) {
     SetCalcedValue(expression->value);
 }
 void Interpreter::Visit(Variable* expression) {
-    if (variables_.count(expression->name) != 0) {
-        SetCalcedValue(variables_[expression->name]);
+    if (IsDefined(expression->slot)) {
+        SetCalcedValue(stack_[fp_ + expression->slot]);
     } else {
-        std::cerr << "Ошибка: переменной " << expression->name << " не существует\n";
+        Error() << "Ошибка: переменной " << Interner::Global().Name(expression->name) << " не существует\n";
     }
 }
 void Interpreter::Visit(BinaryExpression* expression) {
@@ -129,10 +155,10 @@ void Interpreter::Visit(Comparison* expression) {
 
     switch (expression->op[0]) {
             case '<':
-                value = (value <= calced_value_);
+                value = expression->op.size() == 2 ? (value <= calced_value_) : (value < calced_value_);
                 break;
             case '>':
-                value = (value >= calced_value_);
+                value = expression->op.size() == 2 ? (value >= calced_value_) : (value > calced_value_);
                 break;
             case '=':
                 value = (value == calced_value_);
@@ -148,36 +174,254 @@ void Interpreter::Visit(Comparison* expression) {
     SetCalcedValue(value);
 }
 void Interpreter::Visit(FunctionCall* functionCall) {
-    if (variables_.count(functionCall->name) == 0) {
-        std::cerr << "no such function: " << functionCall->name << std::endl;
+    bool tail = tail_position_;
+    tail_position_ = false;
+    FunctionDeclaration* func = functionCall->target;
+    if (func == nullptr) {
+        func = ResolveCall(functionCall);
+        if (func == nullptr) {
+            return;
+        }
+    }
+    // аргументы вычисляются в кадре вызывающей функции, а пишутся
+    // в уже зарезервированный кадр вызываемой
+    size_t base = PushFrame(func);
+    for (size_t i = 0; i < func->params.size(); ++i) {
+        functionCall->args[i]->Accept(this);
+        stack_[base + func->params[i]->slot] = calced_value_;
+        defined_[base + func->params[i]->slot] = 1;
+    }
+    if (func->name < memoizable_.size() && memoizable_[func->name]) {
+        RunMemoized(func, base);
         return;
     }
-    FunctionDeclaration* func = functions_[functionCall->name];
-    std::string err_str = CheckArgs (functionCall, func);
-    if (err_str != "") {
-        std::cerr << err_str << std::endl;
+    if (jit_ != nullptr && RunNative(func, base)) {
         return;
     }
-    func->body->Accept(this);
+    if (tail) {
+        // аргументы посчитаны, кадр вызывающей функции больше не нужен
+        std::copy(stack_.begin() + base, stack_.begin() + sp_, stack_.begin() + fp_);
+        std::copy(defined_.begin() + base, defined_.begin() + sp_, defined_.begin() + fp_);
+        sp_ = fp_ + func->frameSize;
+        tail_call_ = func;
+        return;
+    }
+    RunFrame(func, base);
 }
 
 
+FunctionDeclaration* Interpreter::ResolveCall(FunctionCall* functionCall) {
+    FunctionDeclaration* func = FindFunction(functionCall->name);
+    if (func == nullptr) {
+        Error() << "no such function: " << Interner::Global().Name(functionCall->name) << std::endl;
+        return nullptr;
+    }
+    std::string err_str = CheckArgs (functionCall, func);
+    if (err_str != "") {
+        Error() << err_str << std::endl;
+        return nullptr;
+    }
+    // функции регистрируются только до запуска main, и первая с этим
+    // именем не меняется - найденную можно запомнить в самом узле
+    functionCall->target = func;
+    return func;
+}
+
 std::string Interpreter::CheckArgs(FunctionCall* functionCall, FunctionDeclaration* functionDeclaration) {
-    // пока локальные переменные перекрывают глобальные так, что более к глобальным достпуа нет
-    size_t arg_len = functionCall->args.size();
-    size_t param_len = functionDeclaration->params.size();
-    if (arg_len != param_len) {
+    if (functionCall->args.size() != functionDeclaration->params.size()) {
         return "wrong argument number";
     }
-    for (int i = 0; i < param_len; i++) {
-        functionDeclaration->params[i]->Accept(this);
-        functionCall->args[i]->Accept(this);
-        variables_[functionDeclaration->params[i]->name] = calced_value_; 
-        // UnsetCalcedValue();
-    }
     return "";
 }
 
+size_t Interpreter::PushFrame(FunctionDeclaration* func) {
+    size_t base = sp_;
+    sp_ += func->frameSize;
+    if (stack_.size() < sp_) {
+        size_t size = std::max(stack_.size() * 2, sp_);
+        stack_.resize(size);
+        defined_.resize(size);
+    }
+    std::fill(defined_.begin() + base, defined_.begin() + sp_, 0);
+    return base;
+}
+
+void Interpreter::RunFrame(FunctionDeclaration* func, size_t base) {
+    size_t saved_fp = fp_;
+    fp_ = base;
+    func->body->Accept(this);
+    size_t tailCalls = 0;
+    while (tail_call_ != nullptr) {
+        func = tail_call_;
+        tail_call_ = nullptr;
+        returning_ = false;
+        ++tailCalls;
+        func->body->Accept(this);
+    }
+    returning_ = false;
+    for (; tailCalls > 0; --tailCalls) {
+        Echo(calced_value_);
+    }
+    fp_ = saved_fp;
+    sp_ = base;
+}
+
+
+bool Interpreter::RunNative(FunctionDeclaration* func, size_t base) {
+    TieredJit::NativeFunction native = jit_->Enter(func, functions_);
+    // машинному коду нужно "последнее значение" при входе
+    if (native == nullptr || !is_calced_expression_) {
+        return false;
+    }
+    int result = native(this, stack_.data() + base, calced_value_);
+    sp_ = base;
+    SetCalcedValue(result);
+    return true;
+}
+
+int Interpreter::CallFromNative(FunctionDeclaration* func, const int* args, int entry) {
+    size_t base = PushFrame(func);
+    for (size_t i = 0; i < func->params.size(); ++i) {
+        stack_[base + func->params[i]->slot] = args[i];
+        defined_[base + func->params[i]->slot] = 1;
+    }
+    SetCalcedValue(entry);
+    if (func->name < memoizable_.size() && memoizable_[func->name]) {
+        RunMemoized(func, base);
+    } else if (!RunNative(func, base)) {
+        RunFrame(func, base);
+    }
+    return calced_value_;
+}
+
+void Interpreter::RunMemoized(FunctionDeclaration* func, size_t base) {
+    // результат чистой функции зависит только от параметров и от
+    // "последнего значения" при входе: тело может его и не поменять
+    if (!is_calced_expression_) {
+        RunFrame(func, base);
+        return;
+    }
+    // ключи незавершённых вызовов лежат стопкой, без выделений на вызов
+    size_t keyStart = memo_keys_.size();
+    for (Parameter* param : func->params) {
+        memo_keys_.push_back(stack_[base + param->slot]);
+    }
+    memo_keys_.push_back(calced_value_);
+    size_t hash = std::hash<const void*>()(func);
+    for (size_t i = keyStart; i < memo_keys_.size(); ++i) {
+        hash = (hash ^ static_cast<uint32_t>(memo_keys_[i])) * 0x100000001b3ULL;
+    }
+    MemoEntry& entry = memo_[hash & (kMemoEntries - 1)];
+    if (entry.func == func && std::equal(entry.key.begin(), entry.key.end(), memo_keys_.begin() + keyStart,
+                                         memo_keys_.end())) {
+        memo_keys_.resize(keyStart);
+        ++memo_stats_.hits;
+        sp_ = base;
+        for (int value : entry.echoes) {
+            Echo(value);
+        }
+        SetCalcedValue(entry.result);
+        return;
+    }
+
+    ++memo_stats_.misses;
+    size_t errors = errors_;
+    size_t start = echoes_.size();
+    size_t dropped = echoes_dropped_;
+    ++recording_;
+    RunFrame(func, base);
+    --recording_;
+    // вложенные вызовы могли вытеснить ту же ячейку - это не мешает
+    if (errors_ == errors && echoes_dropped_ == dropped && is_calced_expression_) {
+        memo_stats_.entries += entry.func == nullptr;
+        entry.func = func;
+        entry.key.assign(memo_keys_.begin() + keyStart, memo_keys_.end());
+        entry.result = calced_value_;
+        entry.echoes.assign(echoes_.begin() + start, echoes_.end());
+    }
+    memo_keys_.resize(keyStart);
+    if (recording_ == 0) {
+        echoes_.clear();
+        echoes_dropped_ = 0;
+    }
+}
+
+void Interpreter::FindMemoizable(ProgramBlocks* programBlocks) {
+    // вызов находит первую функцию с этим именем
+    std::unordered_map<SymbolId, FunctionDeclaration*> functions;
+    for (ProgramBlock* block : programBlocks->blocks) {
+        if (block->function != nullptr) {
+            functions.emplace(block->function->name, block->function);
+        }
+    }
+    // чистые функции вызывают только чистые: графа между ними достаточно.
+    // Хвостовые вызовы идут мимо RunMemoized, поэтому в граф не входят
+    std::vector<FunctionDeclaration*> pure;
+    std::unordered_map<SymbolId, uint32_t> index;
+    for (const FunctionDeclaration* func : PurityAnalysis().Find(functions)) {
+        index[func->name] = static_cast<uint32_t>(pure.size());
+        pure.push_back(functions.at(func->name));
+    }
+    std::vector<std::vector<uint32_t>> edges(pure.size());
+    for (size_t i = 0; i < pure.size(); ++i) {
+        CallNames names(true);
+        pure[i]->Accept(&names);
+        for (SymbolId name : names.calls) {
+            edges[i].push_back(index.at(name));
+        }
+    }
+    std::vector<char> recursive;
+    BottomUpOrder(edges, recursive);
+    for (size_t i = 0; i < pure.size(); ++i) {
+        FunctionDeclaration* func = pure[i];
+        if (!recursive[i] || NodeCounter().Count(func) < kMinMemoNodes) {
+            continue;
+        }
+        if (memoizable_.size() <= func->name) {
+            memoizable_.resize(func->name + 1, 0);
+        }
+        memoizable_[func->name] = 1;
+    }
+    // таблица на 65536 ячеек нужна, только если есть что запоминать
+    if (!memoizable_.empty()) {
+        memo_.resize(kMemoEntries);
+    }
+}
+
+void Interpreter::Echo(int value) {
+    std::cout << "expression = " << value << std::endl;
+    if (recording_ == 0) {
+        return;
+    }
+    if (echoes_.size() < kMaxMemoEchoes) {
+        echoes_.push_back(value);
+    } else {
+        ++echoes_dropped_;
+    }
+}
+
+std::ostream& Interpreter::Error() {
+    ++errors_;
+    return std::cerr;
+}
+
+void Interpreter::PrintMemoStatistics(std::ostream& out) const {
+    out << "memoize: " << memo_stats_.hits << " hits, " << memo_stats_.misses << " misses, "
+        << memo_stats_.entries << " of " << kMemoEntries << " entries used\n";
+}
+
+bool Interpreter::IsDefined(uint32_t slot) const {
+    return slot != kNoSlot && defined_[fp_ + slot];
+}
+
+void Interpreter::SetVariable(uint32_t slot, int value) {
+    stack_[fp_ + slot] = value;
+    defined_[fp_ + slot] = 1;
+}
+
+FunctionDeclaration* Interpreter::FindFunction(SymbolId name) const {
+    return name < functions_.size() ? functions_[name] : nullptr;
+}
 
 void Interpreter::SetTosValue(int value) {
     // std::cout << "tos value - " << value << "\n";
@@ -1,13 +1,46 @@
 #pragma once
 
-#include <map>
+#include <cstdint>
 #include <iostream>
+#include <vector>
 
 #include "visitor.hpp"
+#include "../tokenization/interner.hpp"
 
+class TieredJit;
+
+/// Обход AST. Переменные функции лежат в кадре вызова: ячейки, которые
+/// раздал Resolver, идут подряд в общем стеке `stack_` начиная с `fp_`.
+/// Вызов - это сдвиг `sp_` на frameSize функции и обратно, без поиска
+/// по именам. `return` печатает "expression = v" и завершает функцию;
+/// если функция закончилась без return, её результат - последнее
+/// вычисленное значение.
+///
+/// Хвостовой вызов (`return f(...)`, см. ReturnStatement::tailCall)
+/// не растит стек: кадр вызываемой функции встаёт на место кадра
+/// вызывающей, и RunFrame продолжает уже её тело. Строки
+/// "expression = v", которые напечатали бы return вызывающих функций,
+/// печатаются, когда цепочка закончится: значение у них одно и то же.
+///
+/// С `memoize` результаты вызовов чистых рекурсивных функций (см.
+/// PurityAnalysis и FindMemoizable) запоминаются в таблице фиксированного размера по функции и значениям
+/// аргументов; повторный вызов печатает сохранённые строки
+/// "expression = v" и сразу даёт результат. Вызов, во время которого
+/// была ошибка, не запоминается.
+///
+/// С `jit` (см. TieredJit) горячие функции переходят на машинный код:
+/// вызов считается, и, если код уже готов, исполняется он.
 class Interpreter : public Visitor {
 public:
-    Interpreter() {};
+    /// Счётчики --memoize.
+    struct MemoStatistics {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t entries = 0;     // занятые ячейки таблицы
+    };
+
+    explicit Interpreter(bool memoize = false, TieredJit* jit = nullptr) :
+        stack_(kInitialStack), defined_(kInitialStack), memoize_(memoize), jit_(jit) {};
     ~Interpreter() {};
     void Visit(ASTNode* node) override;
     
@@ -37,14 +70,85 @@ public:
     void Visit(Comparison* expression) override;
     void Visit(FunctionCall* statement) override;
 
+    const MemoStatistics& MemoStats() const { return memo_stats_; }
+    void PrintMemoStatistics(std::ostream& out) const;
+
+    // для машинного кода TieredJit
+    void PrintFromNative(int value);
+    void EchoFromNative(int value) { Echo(value); }
+    /// Вызов функции с готовыми аргументами; результат - её значение.
+    int CallFromNative(FunctionDeclaration* func, const int* args, int entry);
+
 private:
-    std::map<std::string, int> variables_;
-    std::map<std::string, FunctionDeclaration*> functions_;
-    bool is_tos_expression_;
-    int tos_value_;
-    int calced_value_;
-    bool is_calced_expression_;
+    static constexpr size_t kInitialStack = 1 << 16;
+    static constexpr size_t kMemoEntries = 1 << 16;    // степень двойки
+    /// Сколько строк "expression = v" копится, пока идут запоминаемые
+    /// вызовы; вызов, чьи строки не поместились, не запоминается.
+    static constexpr size_t kMaxMemoEchoes = 256;
+    /// Тело меньше этого числа узлов (см. NodeCounter) исполняется
+    /// быстрее, чем хэшируются аргументы и проверяется таблица.
+    static constexpr size_t kMinMemoNodes = 8;
+
+    /// Ячейка таблицы: при коллизии старый результат вытесняется.
+    struct MemoEntry {
+        const FunctionDeclaration* func = nullptr;
+        std::vector<int> key;       // аргументы и "последнее значение" при входе
+        int result = 0;
+        std::vector<int> echoes;    // что напечатали return внутри вызова
+    };
+
+    std::vector<int> stack_;            // ячейки всех активных кадров
+    std::vector<char> defined_;         // была ли ячейка объявлена или присвоена
+    size_t fp_ = 0;                     // начало кадра текущей функции
+    size_t sp_ = 0;                     // первая свободная ячейка
+    bool returning_ = false;            // выполнен return: досрочно выйти из тела
+    bool tail_position_ = false;        // вычисляется выражение return, которое - вызов
+    FunctionDeclaration* tail_call_ = nullptr;  // чьё тело RunFrame исполняет следующим
+    std::vector<FunctionDeclaration*> functions_;   // индекс - SymbolId
+    SymbolId main_id_ = Interner::Global().Intern("main");
+    bool is_tos_expression_ = false;
+    int tos_value_ = 0;
+    int calced_value_ = 0;              // "последнее значение"; main начинает с 0
+    bool is_calced_expression_ = false;
+    size_t errors_ = 0;                 // сколько ошибок напечатано
+
+    bool memoize_;
+    std::vector<char> memoizable_;      // индекс - SymbolId
+    std::vector<MemoEntry> memo_;
+    MemoStatistics memo_stats_;
+    std::vector<int> memo_keys_;        // ключи вызовов, которые ещё исполняются
+    size_t recording_ = 0;              // вложенность запоминаемых вызовов
+    std::vector<int> echoes_;           // строки return, пока recording_ > 0
+    size_t echoes_dropped_ = 0;         // не поместившиеся в echoes_
+
+    TieredJit* jit_;
     
+    bool IsDefined(uint32_t slot) const;
+    void SetVariable(uint32_t slot, int value);
+    FunctionDeclaration* FindFunction(SymbolId name) const;
+
+    /// Резервирует кадр функции над текущей вершиной стека; ячейки
+    /// в нём ещё не определены. Возвращает начало кадра.
+    size_t PushFrame(FunctionDeclaration* func);
+    /// Исполняет тело функции в кадре `base` (и тела её хвостовых
+    /// вызовов) и снимает кадр со стека.
+    void RunFrame(FunctionDeclaration* func, size_t base);
+    /// RunFrame через таблицу --memoize.
+    void RunMemoized(FunctionDeclaration* func, size_t base);
+    /// Вызов машинного кода функции вместо RunFrame; false, если кода
+    /// ещё нет.
+    bool RunNative(FunctionDeclaration* func, size_t base);
+    /// Чистые функции не меньше kMinMemoNodes узлов, которые найдёт вызов
+    /// по имени и которые рекурсивны не только хвостовыми вызовами:
+    /// остальные не пересчитываются повторно, и таблица их только замедляет.
+    void FindMemoizable(ProgramBlocks* programBlocks);
+    /// Печатает "expression = v", как return.
+    void Echo(int value);
+    std::ostream& Error();
+
+    /// Поиск функции и проверка числа аргументов при первом вызове
+    /// из этого места; при успехе результат кэшируется в FunctionCall::target.
+    FunctionDeclaration* ResolveCall(FunctionCall* functionCall);
     std::string CheckArgs(FunctionCall* functionCall, FunctionDeclaration* functionDeclaration);
     void SetTosValue(int value);
     void SetCalcedValue(int value);
@@ -0,0 +1,86 @@
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/MC/TargetRegistry.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Host.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Target/TargetOptions.h>
+
+#include "llvm_codegen_visitor.hpp"
+
+#include <mutex>
+
+// Запись модуля в файл без текстового IR: машинный код через
+// TargetMachine и биткод.
+
+bool LLVMCodeGenVisitor::setHostTarget(int level, std::string& errors) {
+    // части ParallelCodeGen задают цель одновременно
+    static std::once_flag targets;
+    std::call_once(targets, [] {
+        llvm::InitializeNativeTarget();
+        llvm::InitializeNativeTargetAsmPrinter();
+    });
+
+    std::string triple = llvm::sys::getDefaultTargetTriple();
+    const llvm::Target* target = llvm::TargetRegistry::lookupTarget(triple, errors);
+    if (target == nullptr) {
+        return false;
+    }
+    // как у clang без -march: код для любого процессора этой архитектуры,
+    // PIC - компоновщик по умолчанию собирает PIE
+    targetMachine.reset(target->createTargetMachine(triple, "generic", "", llvm::TargetOptions(),
+                                                    llvm::Reloc::PIC_, llvm::None, codeGenLevel(level)));
+    if (targetMachine == nullptr) {
+        errors = "cannot create target machine for " + triple;
+        return false;
+    }
+    setTarget(targetMachine->getTargetTriple(), targetMachine->createDataLayout());
+    return true;
+}
+
+void LLVMCodeGenVisitor::setTarget(const llvm::Triple& triple, const llvm::DataLayout& layout) {
+    module->setTargetTriple(triple.str());
+    module->setDataLayout(layout);
+}
+
+llvm::CodeGenOpt::Level LLVMCodeGenVisitor::codeGenLevel(int level) {
+    switch (level) {
+        case 0: return llvm::CodeGenOpt::None;
+        case 1: return llvm::CodeGenOpt::Less;
+        case 2: return llvm::CodeGenOpt::Default;
+        default: return llvm::CodeGenOpt::Aggressive;
+    }
+}
+
+bool LLVMCodeGenVisitor::emitNative(const std::string& outputFilename, bool assembly, std::string& errors) {
+    if (targetMachine == nullptr) {
+        errors = "target machine is not set";
+        return false;
+    }
+    std::error_code ec;
+    llvm::raw_fd_ostream out(outputFilename, ec, llvm::sys::fs::OF_None);
+    if (ec) {
+        errors = outputFilename + ": " + ec.message();
+        return false;
+    }
+    llvm::legacy::PassManager passes;
+    llvm::CodeGenFileType fileType = assembly ? llvm::CGFT_AssemblyFile : llvm::CGFT_ObjectFile;
+    if (targetMachine->addPassesToEmitFile(passes, out, nullptr, fileType)) {
+        errors = "target cannot emit this file type";
+        return false;
+    }
+    passes.run(*module);
+    return true;
+}
+
+bool LLVMCodeGenVisitor::emitBitcode(const std::string& outputFilename, std::string& errors) {
+    std::error_code ec;
+    llvm::raw_fd_ostream out(outputFilename, ec, llvm::sys::fs::OF_None);
+    if (ec) {
+        errors = outputFilename + ": " + ec.message();
+        return false;
+    }
+    llvm::WriteBitcodeToFile(*module, out);
+    return true;
+}
@@ -0,0 +1,136 @@
+#include "llvm_codegen_visitor.hpp"
+
+// Генерация LLVM IR по плоскому AST: те же конструкции, что и в
+// Visit-методах, но обход идёт по индексам FlatAst через switch.
+
+void LLVMCodeGenVisitor::generate(const FlatAst& ast) {
+    for (const FlatItem& item : ast.items) {
+        if (item.isFunction) {
+            const FlatFunction& func = ast.functions[item.ref];
+            declareFunction(func.name, func.paramCount);
+        }
+    }
+    for (const FlatItem& item : ast.items) {
+        if (item.isFunction) {
+            emitFlatFunction(ast, ast.functions[item.ref]);
+        }
+    }
+}
+
+void LLVMCodeGenVisitor::emitFlatFunction(const FlatAst& ast, const FlatFunction& funcDecl) {
+    std::vector<SymbolId> params;
+    for (uint32_t i = 0; i < funcDecl.paramCount; ++i) {
+        params.push_back(ast.FunctionParam(funcDecl, i));
+    }
+    llvm::Function* func = functionFor(funcDecl.name, params.size());
+    beginFunction(func, params);
+    emitFlatBlock(ast, funcDecl.body);
+    finishFunction();
+    emitEntryPoint(funcDecl.name, func);
+}
+
+void LLVMCodeGenVisitor::emitFlatBlock(const FlatAst& ast, FlatRef block) {
+    uint32_t size = ast.blockSize[block];
+    for (uint32_t i = 0; i < size; ++i) {
+        if (builder.GetInsertBlock()->getTerminator()) {
+            break;
+        }
+        emitFlatStmt(ast, ast.BlockStmt(block, i));
+    }
+}
+
+void LLVMCodeGenVisitor::emitFlatStmt(const FlatAst& ast, FlatRef stmt) {
+    uint32_t a = ast.stmtA[stmt];
+    switch (ast.stmtKind[stmt]) {
+        case FlatStmtKind::Declare:
+            declareVariable(a);
+            break;
+        case FlatStmtKind::Assign: {
+            llvm::Value* value = emitFlatExpr(ast, ast.stmtB[stmt]);
+            if (forJit && ast.stmtC[stmt] != kNoFlatRef) {
+                emitEcho(value);
+            }
+            setLastValue(value);
+            assignVariable(a, value);
+            break;
+        }
+        case FlatStmtKind::Print: {
+            llvm::Value* value = emitFlatExpr(ast, a);
+            setLastValue(value);
+            emitPrint(value);
+            break;
+        }
+        case FlatStmtKind::Return:
+            emitReturn(emitFlatExpr(ast, a));
+            break;
+        case FlatStmtKind::If: {
+            llvm::Function* func = builder.GetInsertBlock()->getParent();
+
+            llvm::BasicBlock* thenBB = llvm::BasicBlock::Create(context, "then", func);
+            llvm::BasicBlock* elseBB = llvm::BasicBlock::Create(context, "else");
+            llvm::BasicBlock* mergeBB = llvm::BasicBlock::Create(context, "merge");
+
+            llvm::Value* cond = emitFlatExpr(ast, a);
+            setLastValue(cond);
+            builder.CreateCondBr(toCondition(cond), thenBB, elseBB);
+
+            builder.SetInsertPoint(thenBB);
+            emitFlatBlock(ast, ast.stmtB[stmt]);
+            branchTo(mergeBB);
+
+            elseBB->insertInto(func);
+            builder.SetInsertPoint(elseBB);
+            if (ast.stmtC[stmt] != kNoFlatRef) {
+                emitFlatBlock(ast, ast.stmtC[stmt]);
+            }
+            branchTo(mergeBB);
+
+            mergeBB->insertInto(func);
+            builder.SetInsertPoint(mergeBB);
+            break;
+        }
+    }
+}
+
+llvm::Value* LLVMCodeGenVisitor::emitFlatExpr(const FlatAst& ast, FlatRef expr) {
+    // каждое выражение - новое "последнее значение", как и в pushValue
+    llvm::Value* value = emitFlatValue(ast, expr);
+    setLastValue(value);
+    return value;
+}
+
+llvm::Value* LLVMCodeGenVisitor::emitFlatValue(const FlatAst& ast, FlatRef expr) {
+    uint32_t a = ast.exprA[expr];
+    switch (ast.exprKind[expr]) {
+        case FlatExprKind::Number:
+            return llvm::ConstantInt::get(context, llvm::APInt(32, ast.NumberValue(expr)));
+        case FlatExprKind::Variable:
+            return variable(a);
+        case FlatExprKind::Binary: {
+            llvm::Value* left = emitFlatExpr(ast, a);
+            llvm::Value* right = emitFlatExpr(ast, ast.exprB[expr]);
+            switch (static_cast<BinaryOp>(ast.exprOp[expr])) {
+                case BinaryOp::Add: return builder.CreateAdd(left, right, "addtmp");
+                case BinaryOp::Sub: return builder.CreateSub(left, right, "subtmp");
+                case BinaryOp::Mul: return builder.CreateMul(left, right, "multmp");
+                case BinaryOp::Div: return emitDivide(left, right);
+            }
+            break;
+        }
+        case FlatExprKind::Compare: {
+            llvm::Value* left = emitFlatExpr(ast, a);
+            llvm::Value* right = emitFlatExpr(ast, ast.exprB[expr]);
+            return compareToInt(
+                builder.CreateICmp(comparePredicate(static_cast<CompareOp>(ast.exprOp[expr])), left, right, "cmptmp"));
+        }
+        case FlatExprKind::Call: {
+            std::vector<llvm::Value*> args;
+            uint32_t argc = ast.CallArgCount(expr);
+            for (uint32_t i = 0; i < argc; ++i) {
+                args.push_back(emitFlatExpr(ast, ast.CallArg(expr, i)));
+            }
+            return emitCall(a, args);
+        }
+    }
+    throw std::runtime_error("Unknown flat expression");
+}
@@ -0,0 +1,101 @@
+#include <llvm/IR/CFG.h>
+
+#include "llvm_codegen_visitor.hpp"
+
+// Построение SSA по ходу кодогенерации (Braun et al., 2013): значение
+// переменной в конце блока хранится в currentDef, а чтение в блоке без
+// своего присваивания ищет значение в предшественниках и на слиянии
+// ставит phi. Циклов в языке нет, поэтому к тому моменту, когда в блоке
+// впервые читают переменную, все его предшественники уже построены:
+// блоки сразу "запечатаны" и незавершённых phi не бывает.
+
+llvm::Value* LLVMCodeGenVisitor::variable(SymbolId name) {
+    // чтение незаданной переменной (ошибка в Interpreter) даёт 0, и
+    // declare после него значение уже не меняет
+    functionVariables.insert(name);
+    return readVariable(name, builder.GetInsertBlock());
+}
+
+void LLVMCodeGenVisitor::assignVariable(SymbolId name, llvm::Value* value) {
+    // присваивание без declare тоже заводит переменную
+    functionVariables.insert(name);
+    writeVariable(name, builder.GetInsertBlock(), value);
+}
+
+void LLVMCodeGenVisitor::declareVariable(SymbolId name) {
+    // повторный declare в Interpreter - ошибка, значение не меняется
+    if (!functionVariables.insert(name).second) {
+        return;
+    }
+    writeVariable(name, builder.GetInsertBlock(), builder.getInt32(0));
+}
+
+void LLVMCodeGenVisitor::setLastValue(llvm::Value* value) {
+    writeVariable(kLastValue, builder.GetInsertBlock(), value);
+}
+
+void LLVMCodeGenVisitor::writeVariable(SymbolId name, llvm::BasicBlock* block, llvm::Value* value) {
+    currentDef[{block, name}] = value;
+}
+
+llvm::Value* LLVMCodeGenVisitor::readVariable(SymbolId name, llvm::BasicBlock* block) {
+    auto found = currentDef.find({block, name});
+    if (found != currentDef.end()) {
+        return found->second;
+    }
+    return readVariableRecursive(name, block);
+}
+
+llvm::Value* LLVMCodeGenVisitor::readVariableRecursive(SymbolId name, llvm::BasicBlock* block) {
+    llvm::Value* value = nullptr;
+    llvm::BasicBlock* single = block->getSinglePredecessor();
+    if (single != nullptr) {
+        value = readVariable(name, single);
+    } else if (llvm::pred_empty(block)) {
+        // entry-блок или код после if, обе ветки которого вернули значение
+        value = builder.getInt32(0);
+    } else {
+        // phi заносится в currentDef до чтения операндов
+        llvm::IRBuilder<> phiBuilder(block, block->begin());
+        llvm::PHINode* phi = phiBuilder.CreatePHI(builder.getInt32Ty(), llvm::pred_size(block),
+                                                  name == kLastValue ? "last" : Interner::Global().Name(name));
+        writeVariable(name, block, phi);
+        for (llvm::BasicBlock* pred : llvm::predecessors(block)) {
+            phi->addIncoming(readVariable(name, pred), pred);
+        }
+        value = tryRemoveTrivialPhi(phi);
+    }
+    writeVariable(name, block, value);
+    return value;
+}
+
+llvm::Value* LLVMCodeGenVisitor::tryRemoveTrivialPhi(llvm::PHINode* phi) {
+    llvm::Value* same = nullptr;
+    for (llvm::Value* incoming : phi->incoming_values()) {
+        if (incoming == same || incoming == phi) {
+            continue;
+        }
+        if (same != nullptr) {
+            return phi;
+        }
+        same = incoming;
+    }
+    if (same == nullptr) {
+        same = builder.getInt32(0);
+    }
+    // после замены тривиальными могут стать phi, которые её использовали
+    llvm::SmallVector<llvm::WeakVH, 4> users;
+    for (llvm::User* user : phi->users()) {
+        if (user != phi && llvm::isa<llvm::PHINode>(user)) {
+            users.push_back(user);
+        }
+    }
+    phi->replaceAllUsesWith(same);
+    phi->eraseFromParent();
+    for (llvm::WeakVH& user : users) {
+        if (auto* userPhi = llvm::dyn_cast_or_null<llvm::PHINode>(user)) {
+            tryRemoveTrivialPhi(userPhi);
+        }
+    }
+    return same;
+}
@@ -0,0 +1,104 @@
+#include "llvm_codegen_visitor.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+// Кодогенерация одной горячей функции для TieredJit: те же Visit-методы
+// и SSA, что и для всей программы с forJit, но код повторяет Interpreter
+// изнутри него:
+//  - у всех функций одна сигнатура `i32 (i8* interpreter, i32* args,
+//    i32 entry)`: аргументы лежат подряд, `entry` - "последнее значение"
+//    при входе; результат - значение return или последнее вычисленное;
+//  - print и "expression = v" печатает Interpreter (kTierPrintName,
+//    kTierEchoName), чтобы вывод шёл через тот же поток;
+//  - вызов другой функции сначала смотрит её ячейку в таблице машинного
+//    кода, а если кода ещё нет, вызывает её через Interpreter
+//    (kTierCallName); рекурсия вызывает себя напрямую.
+// Функцию заранее проверяет NativeCheck: все чтения переменных точно
+// определены, declare не встречает существующую переменную, вызываемые
+// функции найдены и получают верное число аргументов.
+
+llvm::Function* LLVMCodeGenVisitor::generateTier(FunctionDeclaration* funcDecl, const std::string& name,
+                                                 const TierCallees& callees, const void* table) {
+    // echo у return и деление через kDivideName - как у ProgramJit
+    forJit = true;
+    llvm::Type* i32 = builder.getInt32Ty();
+    tierType = llvm::FunctionType::get(i32, {builder.getInt8PtrTy(), i32->getPointerTo(), i32}, false);
+    llvm::Function* func = llvm::Function::Create(tierType, llvm::Function::ExternalLinkage, name, module.get());
+    builder.SetInsertPoint(llvm::BasicBlock::Create(context, "entry", func));
+
+    size_t maxArgs = 1;
+    for (const auto& [call, callee] : callees) {
+        maxArgs = std::max(maxArgs, call->args.size());
+    }
+    llvm::AllocaInst* args = builder.CreateAlloca(llvm::ArrayType::get(i32, maxArgs), nullptr, "args");
+    tier = std::make_unique<TierFunction>(TierFunction{callees, table, funcDecl, func, args});
+
+    llvm::Value* argsIn = func->getArg(1);
+    for (size_t i = 0; i < funcDecl->params.size(); ++i) {
+        SymbolId param = funcDecl->params[i]->name;
+        assignVariable(param, builder.CreateLoad(i32, builder.CreateConstGEP1_32(i32, argsIn, i),
+                                                 Interner::Global().Name(param)));
+    }
+    setLastValue(func->getArg(2));
+    funcDecl->body->Accept(this);
+    finishFunction();
+    tier.reset();
+    return func;
+}
+
+llvm::Value* LLVMCodeGenVisitor::emitTierCall(FunctionCall* funcCall, const std::vector<llvm::Value*>& args) {
+    FunctionDeclaration* callee = tier->callees.at(funcCall);
+    // аргументы пишутся, только когда все вычислены: вложенные вызовы
+    // пользуются тем же массивом
+    llvm::Type* arrayType = tier->args->getAllocatedType();
+    for (size_t i = 0; i < args.size(); ++i) {
+        builder.CreateStore(args[i], builder.CreateConstGEP2_32(arrayType, tier->args, 0, i));
+    }
+    llvm::Value* argsPtr = builder.CreateConstGEP2_32(arrayType, tier->args, 0, 0);
+    llvm::Value* entry = readVariable(kLastValue, builder.GetInsertBlock());
+    llvm::Value* interpreter = tier->function->getArg(0);
+
+    if (callee == tier->declaration) {
+        return builder.CreateCall(tierType, tier->function, {interpreter, argsPtr, entry}, "calltmp");
+    }
+
+    llvm::Type* nativePtr = tierType->getPointerTo();
+    llvm::Value* tableBase = builder.CreateIntToPtr(builder.getInt64(reinterpret_cast<uintptr_t>(tier->table)),
+                                                    nativePtr->getPointerTo());
+    llvm::Value* native = builder.CreateLoad(nativePtr, builder.CreateConstGEP1_32(nativePtr, tableBase, callee->name));
+
+    llvm::Function* func = builder.GetInsertBlock()->getParent();
+    llvm::BasicBlock* nativeBB = llvm::BasicBlock::Create(context, "native", func);
+    llvm::BasicBlock* interpretBB = llvm::BasicBlock::Create(context, "interpret", func);
+    llvm::BasicBlock* doneBB = llvm::BasicBlock::Create(context, "called", func);
+    builder.CreateCondBr(builder.CreateIsNull(native), interpretBB, nativeBB);
+
+    builder.SetInsertPoint(nativeBB);
+    llvm::Value* nativeResult = builder.CreateCall(tierType, native, {interpreter, argsPtr, entry});
+    builder.CreateBr(doneBB);
+
+    builder.SetInsertPoint(interpretBB);
+    llvm::Type* i32 = builder.getInt32Ty();
+    llvm::Value* calleeAddress = builder.CreateIntToPtr(builder.getInt64(reinterpret_cast<uintptr_t>(callee)),
+                                                        builder.getInt8PtrTy());
+    llvm::FunctionCallee call = module->getOrInsertFunction(
+        kTierCallName,
+        llvm::FunctionType::get(i32, {builder.getInt8PtrTy(), builder.getInt8PtrTy(), i32->getPointerTo(), i32}, false));
+    llvm::Value* interpretedResult = builder.CreateCall(call, {interpreter, calleeAddress, argsPtr, entry});
+    builder.CreateBr(doneBB);
+
+    // у called два предшественника, и переменные до вызова найдутся
+    // через phi, которые readVariable сразу уберёт как тривиальные
+    builder.SetInsertPoint(doneBB);
+    llvm::PHINode* result = builder.CreatePHI(i32, 2, "calltmp");
+    result->addIncoming(nativeResult, nativeBB);
+    result->addIncoming(interpretedResult, interpretBB);
+    return result;
+}
+
+void LLVMCodeGenVisitor::emitTierOutput(const char* name, llvm::Value* value) {
+    llvm::FunctionCallee output = module->getOrInsertFunction(
+        name, llvm::FunctionType::get(builder.getVoidTy(), {builder.getInt8PtrTy(), builder.getInt32Ty()}, false));
+    builder.CreateCall(output, {tier->function->getArg(0), value});
+}
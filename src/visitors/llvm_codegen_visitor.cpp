@@ -1,16 +1,23 @@
 #include <llvm/Support/FileSystem.h>
 #include <llvm/Support/raw_ostream.h>
 #include <llvm/IR/Verifier.h>
+#include <llvm/Passes/PassBuilder.h>
 
 #include "llvm_codegen_visitor.hpp"
 
-LLVMCodeGenVisitor::LLVMCodeGenVisitor() 
-    : module(std::make_unique<llvm::Module>("main", context)), builder(context) {}
+#include <algorithm>
+#include <climits>
+#include <unordered_set>
 
-// Генерация аллокации переменной в entry block
-llvm::AllocaInst* LLVMCodeGenVisitor::createEntryBlockAlloca(llvm::Function* func, const std::string& name) {
-    llvm::IRBuilder<> tmpBuilder(&func->getEntryBlock(), func->getEntryBlock().begin());
-    return tmpBuilder.CreateAlloca(llvm::Type::getInt32Ty(context), nullptr, name);
+LLVMCodeGenVisitor::LLVMCodeGenVisitor(bool forJit)
+    : ownedContext(std::make_unique<llvm::LLVMContext>()), context(*ownedContext),
+      module(std::make_unique<llvm::Module>("main", context)), builder(context), forJit(forJit) {}
+
+llvm::Function*& LLVMCodeGenVisitor::lookupFunction(SymbolId name) {
+    if (functionTable.size() <= name) {
+        functionTable.resize(std::max<size_t>(name + 1, Interner::Global().Size()), nullptr);
+    }
+    return functionTable[name];
 }
 
 llvm::Type* LLVMCodeGenVisitor::getLLVMType(Type* type) {
@@ -28,47 +35,63 @@ void LLVMCodeGenVisitor::Visit(std::string& program) {
 }
 
 void LLVMCodeGenVisitor::Visit(ProgramBlocks* programBlocks) {
+    declareFunctions(programBlocks);
     for (auto&& block : programBlocks->blocks) {
         block->Accept(this);
     }
 }
-void LLVMCodeGenVisitor::Visit(ProgramBlock* programBlock) {
-    // cannot be called
-}
 
-void LLVMCodeGenVisitor::Visit(FunctionDeclaration* funcDecl) {
-    std::vector<llvm::Type*> paramTypes;
-    for (auto& param : funcDecl->params) {
-        paramTypes.push_back(getLLVMType(param->type.get()));
+void LLVMCodeGenVisitor::declareFunctions(ProgramBlocks* programBlocks) {
+    // функцию можно вызвать и выше её объявления
+    for (auto&& block : programBlocks->blocks) {
+        if (block->function != nullptr) {
+            declareFunction(block->function->name, block->function->params.size());
+        }
     }
+}
 
-    llvm::FunctionType* funcType = llvm::FunctionType::get(
-        getLLVMType(funcDecl->returnType.get()), paramTypes, false
-    );
-
-    llvm::Function* func = llvm::Function::Create(
-        funcType, llvm::Function::ExternalLinkage, funcDecl->name, module.get()
-    );
-
-    // Entry block
-    llvm::BasicBlock* entry = llvm::BasicBlock::Create(context, "entry", func);
-    builder.SetInsertPoint(entry);
-
-    // Добавляем параметры в symbolTable
-    unsigned idx = 0;
-    for (auto& arg : func->args()) {
-        llvm::AllocaInst* alloca = createEntryBlockAlloca(func, funcDecl->params[idx]->name);
-        builder.CreateStore(&arg, alloca);
-        symbolTable[funcDecl->params[idx]->name] = alloca;
-        idx++;
+void LLVMCodeGenVisitor::generatePart(ProgramBlocks* programBlocks, const std::vector<FunctionDeclaration*>& part) {
+    std::unordered_set<SymbolId> names;
+    std::unordered_set<const FunctionDeclaration*> first;
+    for (auto&& block : programBlocks->blocks) {
+        if (block->function != nullptr && names.insert(block->function->name).second) {
+            first.insert(block->function);
+        }
+    }
+    declareFunctions(programBlocks);
+    for (FunctionDeclaration* funcDecl : part) {
+        // тело первой функции с именем получает общее для всех частей
+        // объявление, а остальные никто не вызывает
+        llvm::Function* func = first.count(funcDecl) != 0
+            ? lookupFunction(funcDecl->name)
+            : createFunction(funcDecl->name, funcDecl->params.size(), llvm::Function::InternalLinkage);
+        emitFunction(funcDecl, func);
     }
+    // функции других частей, которые эта часть не вызывает
+    for (auto it = module->begin(); it != module->end();) {
+        llvm::Function& func = *it++;
+        if (func.isDeclaration() && func.use_empty()) {
+            func.eraseFromParent();
+        }
+    }
+}
+void LLVMCodeGenVisitor::Visit(ProgramBlock* programBlock) {
+    // cannot be called
+}
 
-    funcDecl->body->Accept(this);
+void LLVMCodeGenVisitor::Visit(FunctionDeclaration* funcDecl) {
+    emitFunction(funcDecl, functionFor(funcDecl->name, funcDecl->params.size()));
+}
 
-    // Очистка symbolTable от параметров 
+void LLVMCodeGenVisitor::emitFunction(FunctionDeclaration* funcDecl, llvm::Function* func) {
+    std::vector<SymbolId> params;
     for (auto& param : funcDecl->params) {
-        symbolTable.erase(param->name);
+        params.push_back(param->name);
     }
+    beginFunction(func, params);
+    funcDecl->body->Accept(this);
+    finishFunction();
+    emitEntryPoint(funcDecl->name, func);
 }
 void LLVMCodeGenVisitor::Visit(Parameter* parameter) {
     // not called
@@ -79,6 +102,10 @@ void LLVMCodeGenVisitor::Visit(Type* type) {
 
 void LLVMCodeGenVisitor::Visit(StatementList* statementList) {
     for (auto&& statement : statementList->statements) {
+        // после return оператор не исполняется
+        if (builder.GetInsertBlock()->getTerminator()) {
+            break;
+        }
         statement->Accept(this);
     }
 }
@@ -92,26 +119,48 @@ void LLVMCodeGenVisitor::Visit(Assignment* assignment) {
     llvm::Value* value = valueStack.top();
     valueStack.pop();  
     
-    llvm::AllocaInst* var = symbolTable[assignment->variable];
-    builder.CreateStore(value, var);
+    if (forJit && assignment->inlinedReturn) {
+        emitEcho(value);
+    }
+    setLastValue(value);
+    assignVariable(assignment->variable, value);
 }
 void LLVMCodeGenVisitor::Visit(Declaration* declaration) {
-    llvm::Function* func = builder.GetInsertBlock()->getParent();
-    llvm::AllocaInst* alloca = createEntryBlockAlloca(func, declaration->varName);
-    symbolTable[declaration->varName] = alloca;
+    declareVariable(declaration->varName);
 }
 void LLVMCodeGenVisitor::Visit(PrintStatement* printStatement) {
-    declarePrintf(); 
-    
     printStatement->expression->Accept(this); 
     
     llvm::Value* value = valueStack.top();
     valueStack.pop();
     
-    llvm::Value* formatStr = builder.CreateGlobalString("%d\n");
+    setLastValue(value);
+    emitPrint(value);
+}
+
+void LLVMCodeGenVisitor::emitPrint(llvm::Value* value) {
+    if (tier) {
+        emitTierOutput(kTierPrintName, value);
+        return;
+    }
+    emitPrintf("%d\n", value);
+}
+
+void LLVMCodeGenVisitor::emitEcho(llvm::Value* value) {
+    if (tier) {
+        emitTierOutput(kTierEchoName, value);
+        return;
+    }
+    emitPrintf("expression = %d\n", value);
+}
+
+void LLVMCodeGenVisitor::emitPrintf(const char* format, llvm::Value* value) {
+    declarePrintf(); 
+
+    llvm::Value* formatStr = builder.CreateGlobalString(format);
     llvm::Value* formatCast = builder.CreatePointerCast(
         formatStr, 
-        llvm::PointerType::get(context, 0)
+        builder.getInt8PtrTy()
     );
 
     builder.CreateCall(
@@ -127,8 +176,30 @@ void LLVMCodeGenVisitor::Visit(ReturnStatement* returnStatement) {
     llvm::Value* retVal = valueStack.top();
     valueStack.pop();  
     
+    emitReturn(retVal);
+}
+
+void LLVMCodeGenVisitor::emitReturn(llvm::Value* retVal) {
+    if (forJit) {
+        // строка печатается после вызова, так что он уже не хвостовой
+        emitEcho(retVal);
+    } else {
+        markTailCall(retVal);
+    }
     builder.CreateRet(retVal);
 }
+
+void LLVMCodeGenVisitor::markTailCall(llvm::Value* retVal) {
+    // `return f(...)`: вызов - последняя инструкция блока перед ret
+    auto* call = llvm::dyn_cast<llvm::CallInst>(retVal);
+    llvm::BasicBlock* block = builder.GetInsertBlock();
+    if (call == nullptr || block->empty() || &block->back() != call) {
+        return;
+    }
+    // musttail гарантирует постоянный стек, но требует одинаковых сигнатур
+    bool sameType = call->getFunctionType() == block->getParent()->getFunctionType();
+    call->setTailCallKind(sameType ? llvm::CallInst::TCK_MustTail : llvm::CallInst::TCK_Tail);
+}
 void LLVMCodeGenVisitor::Visit(IfStatement* statement) {
     llvm::Function* func = builder.GetInsertBlock()->getParent();
     
@@ -140,14 +211,13 @@ void LLVMCodeGenVisitor::Visit(IfStatement* statement) {
     statement->condition->Accept(this);
     llvm::Value* cond = valueStack.top();
     valueStack.pop();
-    builder.CreateCondBr(cond, thenBB, elseBB);
+    setLastValue(cond);
+    builder.CreateCondBr(toCondition(cond), thenBB, elseBB);
     
     // Then
     builder.SetInsertPoint(thenBB);
     statement->thenBranch->Accept(this);
-    if (!builder.GetInsertBlock()->getTerminator()) {
-        builder.CreateBr(mergeBB);
-    }
+    branchTo(mergeBB);
 
     // Else
     elseBB->insertInto(func);
@@ -155,11 +225,10 @@ void LLVMCodeGenVisitor::Visit(IfStatement* statement) {
     if (statement->elseBranch) {
         statement->elseBranch->Accept(this);
     }
-    if (!builder.GetInsertBlock()->getTerminator()) {
-        builder.CreateBr(mergeBB);
-    }
+    branchTo(mergeBB);
 
-    // Merge (исправлено: используем insertInto)
+    // Merge: переменные, которые ветки задают по-разному, получат phi
+    // при первом чтении (см. llvm_codegen_ssa.cpp)
     mergeBB->insertInto(func);
     builder.SetInsertPoint(mergeBB);
 }
@@ -168,11 +237,10 @@ void LLVMCodeGenVisitor::Visit(Expression* expression) {
     // cannot be called
 }
 void LLVMCodeGenVisitor::Visit(Number* expression) {
-    valueStack.push(llvm::ConstantInt::get(context, llvm::APInt(32, expression->value)));
+    pushValue(llvm::ConstantInt::get(context, llvm::APInt(32, expression->value)));
 }
 void LLVMCodeGenVisitor::Visit(Variable* expression) {
-    llvm::AllocaInst* alloca = symbolTable[expression->name];
-    valueStack.push(builder.CreateLoad(alloca->getAllocatedType(), alloca, expression->name));
+    pushValue(variable(expression->name));
 }
 void LLVMCodeGenVisitor::Visit(BinaryExpression* expression) {
     expression->left->Accept(this);
@@ -186,16 +254,16 @@ void LLVMCodeGenVisitor::Visit(BinaryExpression* expression) {
     
     switch (expression->op[0]) {
         case '+': 
-            valueStack.push(builder.CreateAdd(left, right, "addtmp"));
+            pushValue(builder.CreateAdd(left, right, "addtmp"));
             break;
         case '-': 
-            valueStack.push(builder.CreateSub(left, right, "subtmp"));
+            pushValue(builder.CreateSub(left, right, "subtmp"));
             break;
         case '*': 
-            valueStack.push(builder.CreateMul(left, right, "multmp"));
+            pushValue(builder.CreateMul(left, right, "multmp"));
             break;
         case '/': 
-            valueStack.push(builder.CreateSDiv(left, right, "divtmp"));
+            pushValue(emitDivide(left, right));
             break;
         default: 
             throw std::runtime_error("Unknown operator");
@@ -210,19 +278,10 @@ void LLVMCodeGenVisitor::Visit(Comparison* comparison) {
     llvm::Value* right = valueStack.top();
     valueStack.pop();
     
-    llvm::CmpInst::Predicate pred;
-    if (comparison->op == "==") pred = llvm::CmpInst::ICMP_EQ;
-    else if (comparison->op == "!=") pred = llvm::CmpInst::ICMP_NE;
-    else if (comparison->op == "<") pred = llvm::CmpInst::ICMP_SLT;
-    else if (comparison->op == ">") pred = llvm::CmpInst::ICMP_SGT;
-    else if (comparison->op == "<=") pred = llvm::CmpInst::ICMP_SLE;
-    else if (comparison->op == ">=") pred = llvm::CmpInst::ICMP_SGE;
-    else throw std::runtime_error("Unknown comparison operator");
-    
-    valueStack.push(builder.CreateICmp(pred, left, right, "cmptmp"));
+    llvm::CmpInst::Predicate pred = comparePredicate(CompareOpFromSpelling(comparison->op));
+    pushValue(compareToInt(builder.CreateICmp(pred, left, right, "cmptmp")));
 }
 void LLVMCodeGenVisitor::Visit(FunctionCall* funcCall) {
-    llvm::Function* callee = module->getFunction(funcCall->name);
     std::vector<llvm::Value*> args;
     
     for (auto& argExpr : funcCall->args) {
@@ -231,8 +290,152 @@ void LLVMCodeGenVisitor::Visit(FunctionCall* funcCall) {
         valueStack.pop();
     }
     
-    llvm::Value* result = builder.CreateCall(callee, args);
-    valueStack.push(result); 
+    pushValue(tier ? emitTierCall(funcCall, args) : emitCall(funcCall->name, args));
+}
+
+void LLVMCodeGenVisitor::pushValue(llvm::Value* value) {
+    // в Interpreter каждое вычисленное выражение - новое "последнее
+    // значение", и с ним входит вызов: у вызова без аргументов это,
+    // например, левый операнд
+    setLastValue(value);
+    valueStack.push(value);
+}
+
+llvm::Value* LLVMCodeGenVisitor::emitDivide(llvm::Value* left, llvm::Value* right) {
+    if (!forJit) {
+        return builder.CreateSDiv(left, right, "divtmp");
+    }
+    // sdiv на 0 в LLVM - неопределённое поведение, а Interpreter падает:
+    // такие операнды делит kDivideName, и программа падает так же
+    llvm::Value* byZero = builder.CreateICmpEQ(right, builder.getInt32(0));
+    llvm::Value* overflow = builder.CreateAnd(builder.CreateICmpEQ(left, builder.getInt32(INT_MIN)),
+                                              builder.CreateICmpEQ(right, builder.getInt32(-1)));
+    llvm::Function* func = builder.GetInsertBlock()->getParent();
+    llvm::BasicBlock* faultBB = llvm::BasicBlock::Create(context, "div.fault", func);
+    llvm::BasicBlock* divBB = llvm::BasicBlock::Create(context, "div", func);
+    builder.CreateCondBr(builder.CreateOr(byZero, overflow), faultBB, divBB);
+
+    builder.SetInsertPoint(faultBB);
+    llvm::FunctionCallee divide = module->getOrInsertFunction(
+        kDivideName, llvm::FunctionType::get(builder.getVoidTy(), {builder.getInt32Ty(), builder.getInt32Ty()}, false));
+    builder.CreateCall(divide, {left, right});
+    builder.CreateUnreachable();
+
+    // у div один предшественник, поэтому phi для переменных не нужны
+    builder.SetInsertPoint(divBB);
+    return builder.CreateSDiv(left, right, "divtmp");
+}
+
+llvm::Function* LLVMCodeGenVisitor::functionFor(SymbolId name, size_t paramCount) {
+    llvm::Function*& known = lookupFunction(name);
+    if (known == nullptr) {
+        known = createFunction(name, paramCount, llvm::Function::ExternalLinkage);
+        return known;
+    }
+    // заранее объявленная функция получает первое тело с этим именем,
+    // как и в Interpreter вызов находит первую функцию; остальные
+    // функции с этим именем никто не вызывает
+    if (known->empty() && known->arg_size() == paramCount + 1) {
+        return known;
+    }
+    return createFunction(name, paramCount, llvm::Function::InternalLinkage);
+}
+
+void LLVMCodeGenVisitor::declareFunction(SymbolId name, size_t paramCount) {
+    if (lookupFunction(name) == nullptr) {
+        functionFor(name, paramCount);
+    }
+}
+
+llvm::Function* LLVMCodeGenVisitor::createFunction(SymbolId name, size_t paramCount,
+                                                   llvm::GlobalValue::LinkageTypes linkage) {
+    // последний параметр - "последнее значение" вызывающей функции
+    std::vector<llvm::Type*> paramTypes(paramCount + 1, llvm::Type::getInt32Ty(context));
+    llvm::FunctionType* funcType = llvm::FunctionType::get(llvm::Type::getInt32Ty(context), paramTypes, false);
+    // имя main занимает точка входа C (см. emitEntryPoint)
+    std::string funcName = name == mainName ? kMainBodyName : std::string(Interner::Global().Name(name));
+    return llvm::Function::Create(funcType, linkage, funcName, module.get());
+}
+
+void LLVMCodeGenVisitor::beginFunction(llvm::Function* func, const std::vector<SymbolId>& params) {
+    llvm::BasicBlock* entry = llvm::BasicBlock::Create(context, "entry", func);
+    builder.SetInsertPoint(entry);
+
+    for (size_t i = 0; i < params.size(); ++i) {
+        llvm::Argument* arg = func->getArg(i);
+        arg->setName(Interner::Global().Name(params[i]));
+        assignVariable(params[i], arg);
+    }
+    // тело начинается со значения вызывающей функции, как и в Interpreter
+    // (если аргументы есть, это последний из них)
+    llvm::Argument* last = func->getArg(params.size());
+    last->setName("last");
+    setLastValue(last);
+}
+
+void LLVMCodeGenVisitor::emitEntryPoint(SymbolId name, llvm::Function* func) {
+    // вызовы main находят первую функцию с этим именем
+    if (name != mainName || func != lookupFunction(name)) {
+        return;
+    }
+    // Interpreter начинает main с "последним значением" 0
+    llvm::Function* entry = llvm::Function::Create(llvm::FunctionType::get(builder.getInt32Ty(), false),
+                                                   llvm::Function::ExternalLinkage, "main", module.get());
+    builder.SetInsertPoint(llvm::BasicBlock::Create(context, "entry", entry));
+    std::vector<llvm::Value*> args(func->arg_size(), builder.getInt32(0));
+    builder.CreateRet(builder.CreateCall(func, args));
+}
+
+void LLVMCodeGenVisitor::finishFunction() {
+    // функция без return возвращает последнее вычисленное значение
+    if (!builder.GetInsertBlock()->getTerminator()) {
+        builder.CreateRet(readVariable(kLastValue, builder.GetInsertBlock()));
+    }
+    // переменные локальны для функции
+    functionVariables.clear();
+    currentDef.clear();
+}
+
+void LLVMCodeGenVisitor::branchTo(llvm::BasicBlock* merge) {
+    if (!builder.GetInsertBlock()->getTerminator()) {
+        builder.CreateBr(merge);
+    }
+}
+
+llvm::Value* LLVMCodeGenVisitor::compareToInt(llvm::Value* comparison) {
+    // в языке сравнение - число 0 или 1
+    return builder.CreateZExt(comparison, builder.getInt32Ty(), "cmpint");
+}
+
+llvm::Value* LLVMCodeGenVisitor::toCondition(llvm::Value* value) {
+    return builder.CreateICmpNE(value, builder.getInt32(0), "cond");
+}
+
+llvm::Value* LLVMCodeGenVisitor::emitCall(SymbolId name, const std::vector<llvm::Value*>& args) {
+    llvm::Function* callee = lookupFunction(name);
+    // в Interpreter это ошибка "no such function" / "wrong argument number"
+    if (callee == nullptr || callee->arg_size() != args.size() + 1) {
+        return builder.getInt32(0);
+    }
+    std::vector<llvm::Value*> callArgs(args);
+    callArgs.push_back(readVariable(kLastValue, builder.GetInsertBlock()));
+    return builder.CreateCall(callee, callArgs);
+}
+
+llvm::CmpInst::Predicate LLVMCodeGenVisitor::comparePredicate(CompareOp op) {
+    switch (op) {
+        case CompareOp::Eq: return llvm::CmpInst::ICMP_EQ;
+        case CompareOp::Ne: return llvm::CmpInst::ICMP_NE;
+        case CompareOp::Lt: return llvm::CmpInst::ICMP_SLT;
+        case CompareOp::Gt: return llvm::CmpInst::ICMP_SGT;
+        case CompareOp::Le: return llvm::CmpInst::ICMP_SLE;
+        case CompareOp::Ge: return llvm::CmpInst::ICMP_SGE;
+    }
+    throw std::runtime_error("Unknown comparison operator");
+}
+
+llvm::orc::ThreadSafeModule LLVMCodeGenVisitor::takeModule() {
+    return llvm::orc::ThreadSafeModule(std::move(module), std::move(ownedContext));
 }
 
 void LLVMCodeGenVisitor::generateIR(const std::string& outputFilename) {
@@ -241,10 +444,54 @@ void LLVMCodeGenVisitor::generateIR(const std::string& outputFilename) {
     module->print(out, nullptr);
 }
 
+bool LLVMCodeGenVisitor::optimize(int level, bool size, std::string& errors) {
+    llvm::raw_string_ostream errorStream(errors);
+    // проходы рассчитаны на корректный модуль
+    if (llvm::verifyModule(*module, &errorStream)) {
+        errorStream.flush();
+        return false;
+    }
+    if (size) {
+        runPipeline(*module, llvm::OptimizationLevel::Os);
+    } else if (level >= 3) {
+        runPipeline(*module, llvm::OptimizationLevel::O3);
+    } else if (level == 2) {
+        runPipeline(*module, llvm::OptimizationLevel::O2);
+    } else if (level == 1) {
+        runPipeline(*module, llvm::OptimizationLevel::O1);
+    }
+    return true;
+}
+
+void LLVMCodeGenVisitor::runPipeline(llvm::Module& module, llvm::OptimizationLevel level) {
+    if (level == llvm::OptimizationLevel::O0) {
+        return;
+    }
+    llvm::LoopAnalysisManager loops;
+    llvm::FunctionAnalysisManager functions;
+    llvm::CGSCCAnalysisManager cgscc;
+    llvm::ModuleAnalysisManager modules;
+    llvm::PassBuilder passes;
+    passes.registerModuleAnalyses(modules);
+    passes.registerCGSCCAnalyses(cgscc);
+    passes.registerFunctionAnalyses(functions);
+    passes.registerLoopAnalyses(loops);
+    passes.crossRegisterProxies(loops, functions, cgscc, modules);
+    passes.buildPerModuleDefaultPipeline(level).run(module, modules);
+}
+
+size_t LLVMCodeGenVisitor::instructionCount() const {
+    size_t count = 0;
+    for (const llvm::Function& func : *module) {
+        count += func.getInstructionCount();
+    }
+    return count;
+}
+
 void LLVMCodeGenVisitor::declarePrintf() {
     if (!module->getFunction("printf")) {
         std::vector<llvm::Type*> printfArgs;
-        printfArgs.push_back(llvm::PointerType::get(context, 0));
+        printfArgs.push_back(builder.getInt8PtrTy());
         
         llvm::FunctionType* printfType = llvm::FunctionType::get(
             llvm::Type::getInt32Ty(context),
@@ -1,19 +1,90 @@
 #pragma once
 
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/DenseSet.h>
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
 #include <llvm/IR/IRBuilder.h>
 #include <llvm/IR/Module.h>
 #include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/ValueHandle.h>
+#include <llvm/Passes/OptimizationLevel.h>
+#include <llvm/Target/TargetMachine.h>
+#include <limits>
 #include <stack>
 #include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "../parsing/ast.hpp"  
+#include "../parsing/flat_ast.hpp"
 #include "visitor.hpp"
 
 
+/// Кодогенерация LLVM IR. Переменные сразу строятся в SSA-форме без
+/// alloca (Braun et al., "Simple and Efficient Construction of Static
+/// Single Assignment Form", см. llvm_codegen_ssa.cpp), поэтому IR уже
+/// на -O0 не содержит load/store переменных. Функция без return
+/// возвращает последнее вычисленное значение, как и в Interpreter;
+/// при входе это значение вызывающей функции, которое передаётся
+/// скрытым последним параметром.
 class LLVMCodeGenVisitor : public Visitor {
 public:
-    LLVMCodeGenVisitor();
+    /// `forJit` - модуль для ProgramJit, вывод которого совпадает с
+    /// Interpreter: return и Assignment::inlinedReturn печатают
+    /// "expression = v", а деление, на котором Interpreter падает
+    /// (на 0, INT_MIN / -1), вызывает функцию kDivideName.
+    explicit LLVMCodeGenVisitor(bool forJit = false);
     void generateIR(const std::string& outputFilename);
+    /// Отдаёт модуль вместе с контекстом; после этого посетитель не нужен.
+    llvm::orc::ThreadSafeModule takeModule();
+
+    /// Имя функции main языка; `main` - точка входа C, которая её вызывает.
+    static constexpr const char* kMainBodyName = "main.body";
+    /// Деление с операндами, на которых падает Interpreter (только forJit).
+    static constexpr const char* kDivideName = "jit.divide";
+    /// Функции Interpreter, которые вызывает код generateTier.
+    static constexpr const char* kTierPrintName = "tier.print";
+    static constexpr const char* kTierEchoName = "tier.echo";
+    static constexpr const char* kTierCallName = "tier.call";
+
+    /// Куда ведёт каждый вызов в теле функции (см. NativeCheck).
+    using TierCallees = std::unordered_map<const FunctionCall*, FunctionDeclaration*>;
+
+    /// Создаёт TargetMachine для машины, на которой запущен компилятор
+    /// (`level` 0-3 - уровень генерации машинного кода), и задаёт модулю
+    /// её триплет и DataLayout. Вызывается до optimize, чтобы проходы
+    /// видели размеры типов цели (см. llvm_codegen_emit.cpp).
+    bool setHostTarget(int level, std::string& errors);
+    /// Триплет и DataLayout цели, код для которой строит кто-то другой
+    /// (ORC LLJIT в ProgramJit).
+    void setTarget(const llvm::Triple& triple, const llvm::DataLayout& layout);
+    /// Уровень генерации машинного кода для -O0..-O3.
+    static llvm::CodeGenOpt::Level codeGenLevel(int level);
+    /// Объектный файл (`assembly` - ассемблер) прямо из модуля в памяти.
+    bool emitNative(const std::string& outputFilename, bool assembly, std::string& errors);
+    bool emitBitcode(const std::string& outputFilename, std::string& errors);
+
+    /// Проверяет модуль (verifyModule) и, если он корректен, прогоняет
+    /// стандартный конвейер LLVM уровня `level` (0-3, `size` - -Os).
+    /// false - модуль некорректен, ошибки проверки в `errors`.
+    bool optimize(int level, bool size, std::string& errors);
+    /// Конвейер нового PassManager: instcombine, GVN, встраивание
+    /// и остальное, что LLVM включает на этом уровне. На O0 ничего не делает.
+    static void runPipeline(llvm::Module& module, llvm::OptimizationLevel level);
+    /// Число инструкций во всех функциях модуля.
+    size_t instructionCount() const;
+
+    /// Строит модуль по плоскому AST (см. llvm_codegen_flat.cpp).
+    void generate(const FlatAst& ast);
+    /// Строит только функции `part` (см. ParallelCodeGen); функции других
+    /// частей, которые они вызывают, остаются внешними объявлениями.
+    void generatePart(ProgramBlocks* programBlocks, const std::vector<FunctionDeclaration*>& part);
+    /// Строит одну горячую функцию `name` для TieredJit в режиме forJit
+    /// (см. llvm_codegen_tier.cpp); `table` - таблица машинного кода
+    /// TieredJit, индекс - SymbolId.
+    llvm::Function* generateTier(FunctionDeclaration* funcDecl, const std::string& name, const TierCallees& callees,
+                                 const void* table);
 
     void Visit(ASTNode* node) override;
     
@@ -44,14 +115,89 @@ public:
     void Visit(FunctionCall* statement) override;
 
 private:
-    llvm::LLVMContext context;
+    std::unique_ptr<llvm::LLVMContext> ownedContext;
+    llvm::LLVMContext& context;
     std::unique_ptr<llvm::Module> module;
     llvm::IRBuilder<> builder;
+    std::unique_ptr<llvm::TargetMachine> targetMachine;     // nullptr до setHostTarget
+    bool forJit;
+    SymbolId mainName = Interner::Global().Intern("main");
+
+    /// Функция, которую строит generateTier.
+    struct TierFunction {
+        const TierCallees& callees;
+        const void* table;
+        FunctionDeclaration* declaration;
+        llvm::Function* function;
+        llvm::AllocaInst* args;         // аргументы вызовов из тела
+    };
+    std::unique_ptr<TierFunction> tier; // nullptr вне generateTier
+    llvm::FunctionType* tierType = nullptr;
     
+    /// Псевдопеременная для "последнего значения" функции.
+    static constexpr SymbolId kLastValue = std::numeric_limits<SymbolId>::max() - 2;
+
     std::stack<llvm::Value*> valueStack;  
-    std::map<std::string, llvm::AllocaInst*> symbolTable; 
-    
-    llvm::AllocaInst* createEntryBlockAlloca(llvm::Function* func, const std::string& name);
+    std::vector<llvm::Function*> functionTable;     // индекс - SymbolId
+    llvm::DenseSet<SymbolId> functionVariables;     // переменные, уже встреченные в текущей функции
+    // текущее значение переменной в конце блока; WeakTrackingVH следует
+    // за replaceAllUsesWith, когда тривиальная phi заменяется значением
+    llvm::DenseMap<std::pair<llvm::BasicBlock*, SymbolId>, llvm::WeakTrackingVH> currentDef;
+
+    llvm::Function*& lookupFunction(SymbolId name);
     llvm::Type* getLLVMType(Type* type);
     void declarePrintf();
+
+    /// Функция с этим именем: заранее объявленная, если её тело ещё
+    /// не построено, иначе новая с внутренней компоновкой.
+    llvm::Function* functionFor(SymbolId name, size_t paramCount);
+    /// Объявляет первую функцию с этим именем.
+    void declareFunction(SymbolId name, size_t paramCount);
+    void declareFunctions(ProgramBlocks* programBlocks);
+    llvm::Function* createFunction(SymbolId name, size_t paramCount, llvm::GlobalValue::LinkageTypes linkage);
+    void emitFunction(FunctionDeclaration* funcDecl, llvm::Function* func);
+    void beginFunction(llvm::Function* func, const std::vector<SymbolId>& params);
+    /// Если `func` - первая main, добавляет `i32 main()`, которая её вызывает.
+    void emitEntryPoint(SymbolId name, llvm::Function* func);
+    /// Завершает функцию без return и забывает её переменные.
+    void finishFunction();
+    /// Значение переменной в текущем блоке; незаданная переменная - 0.
+    llvm::Value* variable(SymbolId name);
+    void assignVariable(SymbolId name, llvm::Value* value);
+    void declareVariable(SymbolId name);
+    void setLastValue(llvm::Value* value);
+    /// Переход из текущего блока в `merge`, если блок ещё не завершён.
+    void branchTo(llvm::BasicBlock* merge);
+
+    void writeVariable(SymbolId name, llvm::BasicBlock* block, llvm::Value* value);
+    llvm::Value* readVariable(SymbolId name, llvm::BasicBlock* block);
+    llvm::Value* readVariableRecursive(SymbolId name, llvm::BasicBlock* block);
+    /// phi с одним значением (не считая её самой) заменяется этим значением.
+    llvm::Value* tryRemoveTrivialPhi(llvm::PHINode* phi);
+    llvm::Value* compareToInt(llvm::Value* comparison);
+    llvm::Value* toCondition(llvm::Value* value);
+    /// Вызов; неизвестная функция или неверное число аргументов дают 0.
+    llvm::Value* emitCall(SymbolId name, const std::vector<llvm::Value*>& args);
+    /// Кладёт значение выражения на valueStack.
+    void pushValue(llvm::Value* value);
+    /// Вызов из generateTier: машинный код вызываемой функции, если он
+    /// уже есть в таблице, иначе kTierCallName.
+    llvm::Value* emitTierCall(FunctionCall* funcCall, const std::vector<llvm::Value*>& args);
+    /// print или "expression = v" через Interpreter (kTierPrintName, kTierEchoName).
+    void emitTierOutput(const char* name, llvm::Value* value);
+
+    void emitFlatFunction(const FlatAst& ast, const FlatFunction& func);
+    void emitFlatBlock(const FlatAst& ast, FlatRef block);
+    void emitFlatStmt(const FlatAst& ast, FlatRef stmt);
+    llvm::Value* emitFlatExpr(const FlatAst& ast, FlatRef expr);
+    llvm::Value* emitFlatValue(const FlatAst& ast, FlatRef expr);
+    void emitPrint(llvm::Value* value);
+    /// "expression = v", как у return в Interpreter (только forJit).
+    void emitEcho(llvm::Value* value);
+    void emitPrintf(const char* format, llvm::Value* value);
+    void emitReturn(llvm::Value* retVal);
+    llvm::Value* emitDivide(llvm::Value* left, llvm::Value* right);
+    /// Помечает tail/musttail вызов, результат которого сразу возвращается.
+    void markTailCall(llvm::Value* retVal);
+    llvm::CmpInst::Predicate comparePredicate(CompareOp op);
 };
\ No newline at end of file
@@ -0,0 +1,57 @@
+#include "parallel_codegen.hpp"
+
+#include <algorithm>
+#include <future>
+
+#include "llvm_codegen_visitor.hpp"
+#include "../passes/node_counter.hpp"
+#include "../util/thread_pool.hpp"
+
+ParallelCodeGen::ParallelCodeGen(ProgramBlocks* blocks, ThreadPool& pool) : blocks(blocks), pool(pool) {
+    std::vector<FunctionDeclaration*> functions;
+    std::vector<size_t> sizes;
+    size_t total = 0;
+    for (ProgramBlock* block : blocks->blocks) {
+        if (block->function != nullptr) {
+            functions.push_back(block->function);
+            sizes.push_back(NodeCounter().Count(block->function));
+            total += sizes.back();
+        }
+    }
+    size_t parts = std::max<size_t>(1, std::min(pool.Size(), total / kMinPartNodes));
+    // соседние функции часто вызывают друг друга: части идут подряд по тексту
+    size_t target = (total + parts - 1) / parts;
+    partFunctions.emplace_back();
+    size_t filled = 0;
+    for (size_t i = 0; i < functions.size(); ++i) {
+        if (filled >= target && partFunctions.size() < parts) {
+            partFunctions.emplace_back();
+            filled = 0;
+        }
+        partFunctions.back().push_back(functions[i]);
+        filled += sizes[i];
+    }
+}
+
+std::string ParallelCodeGen::run(const Job& job) {
+    std::vector<std::future<std::string>> done;
+    for (size_t i = 0; i < partFunctions.size(); ++i) {
+        done.push_back(pool.Submit([this, &job, i] {
+            LLVMCodeGenVisitor codegen;
+            codegen.generatePart(blocks, partFunctions[i]);
+            std::string errors;
+            if (!job(i, codegen, errors)) {
+                return errors.empty() ? std::string("part failed") : errors;
+            }
+            return std::string();
+        }));
+    }
+    std::string first;
+    for (auto& future : done) {
+        std::string errors = future.get();
+        if (first.empty()) {
+            first = std::move(errors);
+        }
+    }
+    return first;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "../parsing/ast.hpp"
+
+class LLVMCodeGenVisitor;
+class ThreadPool;
+
+/// Кодогенерация и конвейер LLVM на нескольких потоках. Функции программы
+/// делятся на части из соседних функций, примерно равные по числу узлов
+/// AST, и каждую часть на своём потоке строит отдельный LLVMCodeGenVisitor
+/// со своим LLVMContext и Module (см. generatePart). Функции других частей
+/// в модуле части - внешние объявления, поэтому части пишутся в отдельные
+/// объектные файлы и компонуются вместе. Встраивания между частями нет.
+class ParallelCodeGen {
+public:
+    /// Что сделать с построенной частью на её потоке: задать цель,
+    /// оптимизировать, записать. false - ошибка, описание в `errors`.
+    using Job = std::function<bool(size_t part, LLVMCodeGenVisitor& codegen, std::string& errors)>;
+
+    /// Части меньше этого числа узлов AST не делятся: на маленькой
+    /// программе потоки не окупаются.
+    static constexpr size_t kMinPartNodes = 4096;
+
+    /// Делит функции на части, не больше одной на поток `pool`.
+    ParallelCodeGen(ProgramBlocks* blocks, ThreadPool& pool);
+
+    size_t parts() const { return partFunctions.size(); }
+
+    /// Строит части на пуле и выполняет для каждой `job`. Пустая строка
+    /// или ошибка первой по порядку части, в которой она случилась.
+    std::string run(const Job& job);
+
+private:
+    ProgramBlocks* blocks;
+    ThreadPool& pool;
+    std::vector<std::vector<FunctionDeclaration*>> partFunctions;
+};
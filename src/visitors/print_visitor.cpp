@@ -32,7 +32,7 @@ void SymbolTreeVisitor::Visit(ProgramBlock* programBlock) {
 
 void SymbolTreeVisitor::Visit(FunctionDeclaration* funcDecl) {
     PrintTabs();
-    stream << "FunctionDeclaration: " << funcDecl->name << std::endl;
+    stream << "FunctionDeclaration: " << Interner::Global().Name(funcDecl->name) << std::endl;
     ++num_tabs;
     for (auto&& var : funcDecl->params) {
         var->Accept(this);
@@ -48,7 +48,7 @@ void SymbolTreeVisitor::Visit(FunctionDeclaration* funcDecl) {
 }
 void SymbolTreeVisitor::Visit(Parameter* parameter) {
     PrintTabs();
-    stream << "Parameter: " << parameter->name << std::endl;
+    stream << "Parameter: " << Interner::Global().Name(parameter->name) << std::endl;
     ++num_tabs;
     parameter->type->Accept(this);
     --num_tabs;
@@ -83,14 +83,14 @@ void SymbolTreeVisitor::Visit(Statement* statement) {
 }
 void SymbolTreeVisitor::Visit(Assignment* assignment) {
     PrintTabs();
-    stream << "Assignment: " << assignment->variable << std::endl;
+    stream << "Assignment: " << Interner::Global().Name(assignment->variable) << std::endl;
     ++num_tabs;
     assignment->expression->Accept(this);
     --num_tabs;
 }
 void SymbolTreeVisitor::Visit(Declaration* declaration) {
     PrintTabs();
-    stream << "Declaration: " << declaration->varName << std::endl;
+    stream << "Declaration: " << Interner::Global().Name(declaration->varName) << std::endl;
 }
 void SymbolTreeVisitor::Visit(PrintStatement* print_statement) {
     PrintTabs();
@@ -129,7 +129,7 @@ void SymbolTreeVisitor::Visit(Number* expression) {
 }
 void SymbolTreeVisitor::Visit(Variable* expression) {
     PrintTabs();
-    stream << "Variable: " << expression->name << std::endl;
+    stream << "Variable: " << Interner::Global().Name(expression->name) << std::endl;
 }
 void SymbolTreeVisitor::Visit(BinaryExpression* expression) {
     PrintTabs();
@@ -151,7 +151,7 @@ void SymbolTreeVisitor::Visit(Comparison* expression) {
 }
 void SymbolTreeVisitor::Visit(FunctionCall* funcCall) {
     PrintTabs();
-    stream << "FunctionCall: " << funcCall->name << std::endl;
+    stream << "FunctionCall: " << Interner::Global().Name(funcCall->name) << std::endl;
     ++num_tabs;
     for (auto&& var : funcCall->args) {
         var->Accept(this);
@@ -0,0 +1,134 @@
+#include "resolver.hpp"
+
+#include "../parsing/ast.hpp"
+
+void Resolver::Resolve(ProgramBlocks* program) {
+    slot_of_.assign(Interner::Global().Size(), kNoSlot);
+    program->Accept(this);
+}
+
+void Resolver::Visit(ASTNode* node) {
+    // cannot go here
+}
+
+void Resolver::Visit(std::string& program) {
+}
+
+void Resolver::Visit(ProgramBlocks* programBlocks) {
+    for (ProgramBlock* block : programBlocks->blocks) {
+        if (block->function != nullptr) {
+            block->function->Accept(this);
+        }
+    }
+}
+
+void Resolver::Visit(ProgramBlock* programBlock) {
+    // cannot go here
+}
+
+void Resolver::Visit(FunctionDeclaration* func) {
+    frame_size_ = 0;
+    for (Parameter* param : func->params) {
+        param->Accept(this);
+    }
+    func->body->Accept(this);
+
+    for (Variable* read : reads_) {
+        read->slot = read->name < slot_of_.size() ? slot_of_[read->name] : kNoSlot;
+    }
+    reads_.clear();
+    for (SymbolId name : touched_) {
+        slot_of_[name] = kNoSlot;
+    }
+    touched_.clear();
+    func->frameSize = frame_size_;
+}
+
+void Resolver::Visit(Parameter* parameter) {
+    // одноимённые параметры делят ячейку: остаётся значение последнего аргумента
+    parameter->slot = SlotFor(parameter->name);
+}
+
+void Resolver::Visit(Type* type) {
+}
+
+void Resolver::Visit(StatementList* statementList) {
+    for (Statement* statement : statementList->statements) {
+        statement->Accept(this);
+    }
+}
+
+void Resolver::Visit(Statement* statement) {
+    // cannot go here
+}
+
+void Resolver::Visit(Assignment* assignment) {
+    assignment->expression->Accept(this);
+    assignment->slot = SlotFor(assignment->variable);
+}
+
+void Resolver::Visit(Declaration* declaration) {
+    declaration->slot = SlotFor(declaration->varName);
+}
+
+void Resolver::Visit(PrintStatement* printStatement) {
+    printStatement->expression->Accept(this);
+}
+
+void Resolver::Visit(ReturnStatement* returnStatement) {
+    returnStatement->expression->Accept(this);
+    returnStatement->tailCall = call_;
+}
+
+void Resolver::Visit(IfStatement* statement) {
+    statement->condition->Accept(this);
+    statement->thenBranch->Accept(this);
+    if (statement->elseBranch != nullptr) {
+        statement->elseBranch->Accept(this);
+    }
+}
+
+void Resolver::Visit(Expression* expression) {
+    // cannot go here
+}
+
+// call_ помнит, было ли последнее обойдённое выражение вызовом
+
+void Resolver::Visit(Number* expression) {
+    call_ = nullptr;
+}
+
+void Resolver::Visit(Variable* expression) {
+    reads_.push_back(expression);
+    call_ = nullptr;
+}
+
+void Resolver::Visit(BinaryExpression* expression) {
+    expression->left->Accept(this);
+    expression->right->Accept(this);
+    call_ = nullptr;
+}
+
+void Resolver::Visit(Comparison* expression) {
+    expression->left->Accept(this);
+    expression->right->Accept(this);
+    call_ = nullptr;
+}
+
+void Resolver::Visit(FunctionCall* functionCall) {
+    for (Expression* arg : functionCall->args) {
+        arg->Accept(this);
+    }
+    call_ = functionCall;
+}
+
+uint32_t Resolver::SlotFor(SymbolId name) {
+    if (slot_of_.size() <= name) {
+        slot_of_.resize(name + 1, kNoSlot);
+    }
+    if (slot_of_[name] == kNoSlot) {
+        slot_of_[name] = frame_size_++;
+        touched_.push_back(name);
+    }
+    return slot_of_[name];
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "visitor.hpp"
+#include "../tokenization/interner.hpp"
+
+/// Раздаёт переменным функций номера ячеек в кадре вызова.
+/// Параметры получают ячейки 0..n-1 по порядку, затем каждое новое имя из
+/// присваиваний и объявлений - следующую. Чтение переменной получает ячейку
+/// её имени в той же функции или kNoSlot, если имя в функции нигде не
+/// задаётся. Заполняет `slot` у Variable, Assignment, Declaration и
+/// Parameter, `frameSize` у FunctionDeclaration и `tailCall` у ReturnStatement.
+/// Операторы верхнего уровня не исполняются и не разбираются.
+class Resolver : public Visitor {
+public:
+    void Resolve(ProgramBlocks* program);
+
+    void Visit(ASTNode* node) override;
+    void Visit(std::string& program) override;
+
+    void Visit(ProgramBlocks* programBlocks) override;
+    void Visit(ProgramBlock* programBlock) override;
+
+    void Visit(FunctionDeclaration* func) override;
+    void Visit(Parameter* parameter) override;
+    void Visit(Type* type) override;
+
+    void Visit(StatementList* statementList) override;
+
+    void Visit(Statement* statement) override;
+    void Visit(Assignment* assignment) override;
+    void Visit(Declaration* declaration) override;
+    void Visit(PrintStatement* printStatement) override;
+    void Visit(ReturnStatement* returnStatement) override;
+    void Visit(IfStatement* statement) override;
+
+    void Visit(Expression* expression) override;
+    void Visit(Number* expression) override;
+    void Visit(Variable* expression) override;
+    void Visit(BinaryExpression* expression) override;
+    void Visit(Comparison* expression) override;
+    void Visit(FunctionCall* functionCall) override;
+
+private:
+    std::vector<uint32_t> slot_of_;     // SymbolId -> ячейка в текущей функции
+    std::vector<SymbolId> touched_;     // имена, которым выдана ячейка
+    std::vector<Variable*> reads_;      // чтения ждут конца функции: имя может задаваться ниже
+    uint32_t frame_size_ = 0;
+    FunctionCall* call_ = nullptr;      // последнее выражение - вызов
+
+    uint32_t SlotFor(SymbolId name);
+};
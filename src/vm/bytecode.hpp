@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "../parsing/ast.hpp"
+#include "../tokenization/interner.hpp"
+
+/// Регистровый байткод. У каждого вызова своё окно регистров `r` размера
+/// frameSize: первые `slots` регистров - переменные функции в ячейках,
+/// которые раздал Resolver, выше - временные значения выражений.
+/// `last` - значение последнего вычисленного на уровне оператора
+/// выражения: его Interpreter держит в calced_value_, и оно становится
+/// результатом вызова функции, закончившейся без return.
+///
+/// Interpreter берёт результатом вызова calced_value_ - значение последнего
+/// вычисленного подвыражения. Если функция ничего не вычислила, это значение
+/// выражения перед вызовом. Компилятор отслеживает его статически: `c` у
+/// LoadVar и BeginCall - номер регистра с этим значением плюс один (0 - оно
+/// уже в last), а перед вызовом без аргументов при необходимости ставится SetLast.
+///
+/// Переменную, которая в этом месте точно определена, компилятор читает
+/// прямо из её регистра; проверяющий LoadVar нужен только там, где она
+/// могла ещё не получить значение.
+///
+/// Список кодов задан X-макросом, чтобы enum и таблица меток
+/// computed goto в Vm не могли разойтись.
+#define MYCOMPILER_VM_OPCODES(X)                                                \
+    X(LoadConst)    /* r[a] = b                                              */ \
+    X(Move)         /* r[a] = r[b]                                           */ \
+    X(LoadVar)      /* r[a] = r[var[b].slot]; если не определена - ошибка и  */ \
+                    /* значение предыдущего выражения (см. выше про c)       */ \
+    X(StoreVar)     /* r[b] = r[a], ячейка b определена; last = r[a]         */ \
+    X(Declare)      /* r[var[b].slot] = 0, ошибка если уже определена        */ \
+    X(Add)          /* r[a] = r[b] + r[c]                                    */ \
+    X(Sub)                                                                      \
+    X(Mul)                                                                      \
+    X(Div)                                                                      \
+    X(AddK)         /* r[a] = r[b] + c (c - константа)                       */ \
+    X(SubK)                                                                     \
+    X(MulK)                                                                     \
+    X(DivK)                                                                     \
+    X(Eq)           /* r[a] = r[b] == r[c]                                   */ \
+    X(Ne)                                                                       \
+    X(Lt)                                                                       \
+    X(Gt)                                                                       \
+    X(Le)                                                                       \
+    X(Ge)                                                                       \
+    X(EqK)          /* r[a] = r[b] == c                                      */ \
+    X(NeK)                                                                      \
+    X(LtK)                                                                      \
+    X(GtK)                                                                      \
+    X(LeK)                                                                      \
+    X(GeK)                                                                      \
+    X(Jump)         /* pc = b                                                */ \
+    X(JumpIfFalse)  /* last = r[a]; if (!r[a]) pc = b                        */ \
+    X(Print)        /* last = r[a]; печать r[a]                              */ \
+    X(Return)       /* last = r[a]; печать "expression = r[a]" и выход       */ \
+    X(Echo)         /* last = r[a]; печать "expression = r[a]" без выхода    */ \
+                    /* (return встроенной функции, см. Inliner)               */ \
+    X(BeginCall)    /* найти функцию call[b] и зарезервировать её кадр;      */ \
+                    /* при ошибке r[a] = значение предыдущего выражения      */ \
+                    /* и переход за Call                                     */ \
+    X(StoreArg)     /* параметр c в кадре из BeginCall = r[a]; last = r[a]   */ \
+    X(Call)         /* r[a] = результат вызова функции из BeginCall          */ \
+    X(SetLast)      /* last = r[a]                                           */ \
+    X(End)          /* конец тела: вернуть last                              */
+
+enum class OpCode : uint8_t {
+#define MYCOMPILER_VM_ENUM(name) name,
+    MYCOMPILER_VM_OPCODES(MYCOMPILER_VM_ENUM)
+#undef MYCOMPILER_VM_ENUM
+};
+
+/// 12 байт на инструкцию: регистр результата и два операнда.
+struct Instruction {
+    OpCode op;
+    uint16_t a = 0;
+    uint32_t b = 0;
+    uint32_t c = 0;
+};
+
+/// Место вызова: функция ищется по имени во время исполнения, как в
+/// Interpreter (видны только функции, объявленные до запуска main).
+struct CallSite {
+    SymbolId name;
+    uint32_t argCount;
+    uint32_t skipTo;    // первая инструкция после Call - переход при ошибке
+};
+
+/// Переменная, которую нужно проверять при чтении: имя нужно для сообщения об ошибке.
+struct VarSite {
+    SymbolId name;
+    uint32_t slot;      // kNoSlot - имя в функции не задаётся, чтение всегда ошибка
+};
+
+struct BytecodeFunction {
+    SymbolId name;
+    std::vector<uint32_t> paramSlots;   // регистр каждого параметра
+    uint32_t entry;     // индекс первой инструкции в BytecodeProgram::code
+    uint32_t slots;     // регистры переменных - начало окна
+    uint32_t frameSize; // число регистров
+};
+
+/// Скомпилированная программа: код всех функций в одном массиве
+/// и порядок объявлений верхнего уровня.
+struct BytecodeProgram {
+    std::vector<Instruction> code;
+    std::vector<CallSite> calls;
+    std::vector<VarSite> vars;
+    std::vector<BytecodeFunction> functions;    // в порядке объявления
+};
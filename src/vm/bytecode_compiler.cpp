@@ -0,0 +1,272 @@
+#include "bytecode_compiler.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "../parsing/ast.hpp"
+
+BytecodeProgram BytecodeCompiler::Compile(ProgramBlocks* program) {
+    program_ = BytecodeProgram{};
+    program->Accept(this);
+    return std::move(program_);
+}
+
+void BytecodeCompiler::Visit(ASTNode* node) {
+    // cannot go here
+}
+
+void BytecodeCompiler::Visit(std::string& program) {
+}
+
+void BytecodeCompiler::Visit(ProgramBlocks* programBlocks) {
+    // операторы верхнего уровня Interpreter не исполняет - компилируются только функции
+    for (ProgramBlock* block : programBlocks->blocks) {
+        if (block->function != nullptr) {
+            block->function->Accept(this);
+        }
+    }
+}
+
+void BytecodeCompiler::Visit(ProgramBlock* programBlock) {
+    // cannot go here
+}
+
+void BytecodeCompiler::Visit(FunctionDeclaration* func) {
+    if (func->frameSize > UINT16_MAX) {
+        throw std::runtime_error("Слишком много переменных в функции для байткода");
+    }
+    BytecodeFunction compiled;
+    compiled.name = func->name;
+    compiled.entry = static_cast<uint32_t>(program_.code.size());
+    compiled.slots = func->frameSize;
+
+    slots_ = func->frameSize;
+    frame_size_ = slots_;
+    assigned_.assign(slots_, 0);
+    for (Parameter* param : func->params) {
+        compiled.paramSlots.push_back(param->slot);
+        assigned_[param->slot] = 1;
+    }
+    func->body->Accept(this);
+    Emit(OpCode::End);
+
+    compiled.frameSize = std::max<uint32_t>(frame_size_, 1);
+    program_.functions.push_back(std::move(compiled));
+}
+
+void BytecodeCompiler::Visit(Parameter* parameter) {
+    // shouldn't go here
+}
+
+void BytecodeCompiler::Visit(Type* type) {
+    // shouldn't go here
+}
+
+void BytecodeCompiler::Visit(StatementList* statementList) {
+    for (Statement* statement : statementList->statements) {
+        statement->Accept(this);
+    }
+}
+
+void BytecodeCompiler::Visit(Statement* statement) {
+    // cannot go here
+}
+
+void BytecodeCompiler::Visit(Assignment* assignment) {
+    uint16_t value = CompileStatementValue(assignment->expression);
+    if (assignment->inlinedReturn) {
+        Emit(OpCode::Echo, value);
+    }
+    Emit(OpCode::StoreVar, value, assignment->slot);
+    assigned_[assignment->slot] = 1;
+}
+
+void BytecodeCompiler::Visit(Declaration* declaration) {
+    Emit(OpCode::Declare, 0, AddVarSite(declaration->varName, declaration->slot));
+    assigned_[declaration->slot] = 1;
+}
+
+void BytecodeCompiler::Visit(PrintStatement* printStatement) {
+    Emit(OpCode::Print, CompileStatementValue(printStatement->expression));
+}
+
+void BytecodeCompiler::Visit(ReturnStatement* returnStatement) {
+    Emit(OpCode::Return, CompileStatementValue(returnStatement->expression));
+}
+
+void BytecodeCompiler::Visit(IfStatement* statement) {
+    uint32_t branch = Emit(OpCode::JumpIfFalse, CompileStatementValue(statement->condition));
+    // после if переменная точно определена, только если её определили обе ветки
+    std::vector<char> before = assigned_;
+    statement->thenBranch->Accept(this);
+    if (statement->elseBranch != nullptr) {
+        std::vector<char> afterThen = std::move(assigned_);
+        assigned_ = before;
+        uint32_t skipElse = Emit(OpCode::Jump);
+        program_.code[branch].b = static_cast<uint32_t>(program_.code.size());
+        statement->elseBranch->Accept(this);
+        program_.code[skipElse].b = static_cast<uint32_t>(program_.code.size());
+        for (size_t i = 0; i < assigned_.size(); ++i) {
+            assigned_[i] &= afterThen[i];
+        }
+    } else {
+        program_.code[branch].b = static_cast<uint32_t>(program_.code.size());
+        assigned_ = std::move(before);
+    }
+}
+
+void BytecodeCompiler::Visit(Expression* expression) {
+    // cannot go here
+}
+
+void BytecodeCompiler::Visit(Number* expression) {
+    Emit(OpCode::LoadConst, target_, static_cast<uint32_t>(expression->value));
+    previous_ = target_;
+}
+
+void BytecodeCompiler::Visit(Variable* expression) {
+    uint32_t slot = expression->slot;
+    if (slot != kNoSlot && assigned_[slot]) {
+        Emit(OpCode::Move, target_, slot);
+    } else {
+        Emit(OpCode::LoadVar, target_, AddVarSite(expression->name, slot), PreviousOperand());
+    }
+    previous_ = target_;
+}
+
+void BytecodeCompiler::Visit(BinaryExpression* expression) {
+    switch (expression->op[0]) {
+        case '+': EmitBinary(OpCode::Add, OpCode::AddK, expression->left, expression->right); break;
+        case '-': EmitBinary(OpCode::Sub, OpCode::SubK, expression->left, expression->right); break;
+        case '*': EmitBinary(OpCode::Mul, OpCode::MulK, expression->left, expression->right); break;
+        case '/': EmitBinary(OpCode::Div, OpCode::DivK, expression->left, expression->right); break;
+        default:
+            throw std::runtime_error("Неизвестная бинарная операция " + std::string(expression->op));
+    }
+}
+
+void BytecodeCompiler::Visit(Comparison* expression) {
+    std::string_view op = expression->op;
+    if (op == "==") {
+        EmitBinary(OpCode::Eq, OpCode::EqK, expression->left, expression->right);
+    } else if (op == "!=") {
+        EmitBinary(OpCode::Ne, OpCode::NeK, expression->left, expression->right);
+    } else if (op == "<") {
+        EmitBinary(OpCode::Lt, OpCode::LtK, expression->left, expression->right);
+    } else if (op == ">") {
+        EmitBinary(OpCode::Gt, OpCode::GtK, expression->left, expression->right);
+    } else if (op == "<=") {
+        EmitBinary(OpCode::Le, OpCode::LeK, expression->left, expression->right);
+    } else if (op == ">=") {
+        EmitBinary(OpCode::Ge, OpCode::GeK, expression->left, expression->right);
+    } else {
+        throw std::runtime_error("Неизвестная операция сравнения " + std::string(op));
+    }
+}
+
+void BytecodeCompiler::Visit(FunctionCall* functionCall) {
+    uint16_t result = target_;
+    uint32_t site = static_cast<uint32_t>(program_.calls.size());
+    program_.calls.push_back({functionCall->name, static_cast<uint32_t>(functionCall->args.size()), 0});
+
+    if (functionCall->args.empty() && previous_ >= 0) {
+        // тело может ничего не вычислить - тогда результат вызова - это значение перед ним
+        Emit(OpCode::SetLast, static_cast<uint16_t>(previous_));
+        previous_ = -1;
+    }
+    Emit(OpCode::BeginCall, result, site, PreviousOperand());
+    for (size_t i = 0; i < functionCall->args.size(); ++i) {
+        uint32_t mark = next_reg_;
+        Emit(OpCode::StoreArg, CompileValue(functionCall->args[i]), 0, static_cast<uint32_t>(i));
+        previous_ = -1;
+        next_reg_ = mark;
+    }
+    Emit(OpCode::Call, result, site);
+    program_.calls[site].skipTo = static_cast<uint32_t>(program_.code.size());
+    previous_ = -1;     // результат вызова - это last
+}
+
+uint32_t BytecodeCompiler::Emit(OpCode op, uint16_t a, uint32_t b, uint32_t c) {
+    program_.code.push_back({op, a, b, c});
+    return static_cast<uint32_t>(program_.code.size() - 1);
+}
+
+uint16_t BytecodeCompiler::AllocateRegister() {
+    if (next_reg_ > UINT16_MAX) {
+        throw std::runtime_error("Слишком глубокое выражение для байткода");
+    }
+    uint16_t reg = static_cast<uint16_t>(next_reg_++);
+    frame_size_ = std::max(frame_size_, next_reg_);
+    return reg;
+}
+
+void BytecodeCompiler::CompileInto(Expression* expression, uint16_t reg) {
+    uint16_t saved = target_;
+    target_ = reg;
+    expression->Accept(this);
+    target_ = saved;
+}
+
+uint32_t BytecodeCompiler::CompileOperand(Expression* expression, bool& isConst) {
+    uint16_t reg = AllocateRegister();
+    CompileInto(expression, reg);
+    // константа не занимает регистр: LoadConst убирается, число идёт в операнд c
+    const Instruction& last = program_.code.back();
+    isConst = last.op == OpCode::LoadConst && last.a == reg;
+    if (isConst) {
+        uint32_t value = last.b;
+        program_.code.pop_back();
+        --next_reg_;
+        return value;
+    }
+    if (last.op == OpCode::Move && last.a == reg) {
+        uint32_t slot = last.b;
+        program_.code.pop_back();
+        --next_reg_;
+        previous_ = static_cast<int>(slot);
+        return slot;
+    }
+    return reg;
+}
+
+uint16_t BytecodeCompiler::CompileStatementValue(Expression* expression) {
+    next_reg_ = slots_;
+    previous_ = -1;     // значение предыдущего оператора уже в last
+    return CompileValue(expression);
+}
+
+uint16_t BytecodeCompiler::CompileValue(Expression* expression) {
+    bool isConst = false;
+    uint32_t operand = CompileOperand(expression, isConst);
+    if (isConst) {
+        uint16_t reg = AllocateRegister();
+        Emit(OpCode::LoadConst, reg, operand);
+        previous_ = reg;
+        return reg;
+    }
+    return static_cast<uint16_t>(operand);
+}
+
+void BytecodeCompiler::EmitBinary(OpCode regOp, OpCode constOp, Expression* left, Expression* right) {
+    uint16_t result = target_;
+    CompileInto(left, result);
+    uint32_t leftOperand = result;
+    const Instruction& last = program_.code.back();
+    if (last.op == OpCode::Move && last.a == result) {
+        // переменная слева читается прямо из своего регистра
+        leftOperand = last.b;
+        program_.code.pop_back();
+        previous_ = static_cast<int>(leftOperand);
+    }
+    uint32_t mark = next_reg_;
+    bool isConst = false;
+    uint32_t operand = CompileOperand(right, isConst);
+    Emit(isConst ? constOp : regOp, result, leftOperand, operand);
+    next_reg_ = mark;
+    previous_ = result;
+}
+
+uint32_t BytecodeCompiler::AddVarSite(SymbolId name, uint32_t slot) {
+    program_.vars.push_back({name, slot});
+    return static_cast<uint32_t>(program_.vars.size() - 1);
+}
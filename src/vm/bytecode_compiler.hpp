@@ -0,0 +1,66 @@
+#pragma once
+
+#include <vector>
+
+#include "bytecode.hpp"
+#include "../visitors/visitor.hpp"
+
+/// Переводит ProgramBlocks в BytecodeProgram (после Resolver). Переменные
+/// занимают нижние регистры окна, временные раздаются стеком над ними:
+/// результат выражения кладётся в `target_`, временные значения - в
+/// следующие свободные регистры; между операторами временные не живут.
+class BytecodeCompiler : public Visitor {
+public:
+    BytecodeProgram Compile(ProgramBlocks* program);
+
+    void Visit(ASTNode* node) override;
+    void Visit(std::string& program) override;
+
+    void Visit(ProgramBlocks* programBlocks) override;
+    void Visit(ProgramBlock* programBlock) override;
+
+    void Visit(FunctionDeclaration* func) override;
+    void Visit(Parameter* parameter) override;
+    void Visit(Type* type) override;
+
+    void Visit(StatementList* statementList) override;
+
+    void Visit(Statement* statement) override;
+    void Visit(Assignment* assignment) override;
+    void Visit(Declaration* declaration) override;
+    void Visit(PrintStatement* printStatement) override;
+    void Visit(ReturnStatement* returnStatement) override;
+    void Visit(IfStatement* statement) override;
+
+    void Visit(Expression* expression) override;
+    void Visit(Number* expression) override;
+    void Visit(Variable* expression) override;
+    void Visit(BinaryExpression* expression) override;
+    void Visit(Comparison* expression) override;
+    void Visit(FunctionCall* functionCall) override;
+
+private:
+    BytecodeProgram program_;
+    uint16_t target_ = 0;       // куда положить значение текущего выражения
+    uint32_t next_reg_ = 0;     // первый свободный регистр
+    uint32_t frame_size_ = 0;   // максимум next_reg_ в текущей функции
+    uint32_t slots_ = 0;        // число регистров переменных текущей функции
+    int previous_ = -1;         // регистр с последним вычисленным значением, -1 - оно в last
+    std::vector<char> assigned_;    // ячейка точно определена в этой точке кода
+
+    uint32_t Emit(OpCode op, uint16_t a = 0, uint32_t b = 0, uint32_t c = 0);
+    uint16_t AllocateRegister();
+    /// Вычисляет выражение в регистр `reg`.
+    void CompileInto(Expression* expression, uint16_t reg);
+    /// Значение выражения как операнд: для константы - само число
+    /// (тогда `isConst` = true), иначе номер временного регистра.
+    uint32_t CompileOperand(Expression* expression, bool& isConst);
+    /// Код выражения в отдельный регистр перед оператором.
+    uint16_t CompileStatementValue(Expression* expression);
+    /// Регистр со значением выражения: для точно определённой переменной -
+    /// её собственный (Move убирается), иначе новый временный.
+    uint16_t CompileValue(Expression* expression);
+    uint32_t AddVarSite(SymbolId name, uint32_t slot);
+    uint32_t PreviousOperand() const { return static_cast<uint32_t>(previous_ + 1); }
+    void EmitBinary(OpCode regOp, OpCode constOp, Expression* left, Expression* right);
+};
@@ -0,0 +1,217 @@
+#include "vm.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define MYCOMPILER_COMPUTED_GOTO 1
+#endif
+
+void Vm::Run() {
+    SymbolId mainId = Interner::Global().Intern("main");
+    functions_.assign(Interner::Global().Size(), kNoFunction);
+
+    for (uint32_t i = 0; i < program_.functions.size(); ++i) {
+        const BytecodeFunction& function = program_.functions[i];
+        if (functions_[function.name] == kNoFunction) {
+            functions_[function.name] = i;
+        }
+        if (function.name == mainId) {
+            Execute(function);
+        }
+    }
+}
+
+void Vm::ReserveFrame(size_t base, const BytecodeFunction& function) {
+    if (registers_.size() < base + function.frameSize) {
+        size_t size = std::max(registers_.size() * 2, base + function.frameSize + 1024);
+        registers_.resize(size);
+        defined_.resize(size);
+    }
+    std::fill_n(defined_.begin() + base, function.slots, 0);
+}
+
+void Vm::Execute(const BytecodeFunction& entry) {
+    const Instruction* code = program_.code.data();
+    const Instruction* pc = code + entry.entry;
+    const size_t stopDepth = frames_.size();
+    size_t base = 0;
+    size_t top = entry.frameSize;   // первый регистр за последним зарезервированным окном
+    ReserveFrame(base, entry);
+    int* r = registers_.data() + base;
+    char* defined = defined_.data() + base;
+
+#ifdef MYCOMPILER_COMPUTED_GOTO
+    static const void* const kLabels[] = {
+#define MYCOMPILER_VM_LABEL(name) &&op_##name,
+        MYCOMPILER_VM_OPCODES(MYCOMPILER_VM_LABEL)
+#undef MYCOMPILER_VM_LABEL
+    };
+#define VM_DISPATCH() goto *kLabels[static_cast<uint8_t>(pc->op)]
+#define VM_CASE(name) op_##name:
+#else
+#define VM_DISPATCH() goto dispatch
+#define VM_CASE(name) case OpCode::name:
+#endif
+#define VM_NEXT() do { ++pc; VM_DISPATCH(); } while (0)
+#define VM_BINARY(name, expr) VM_CASE(name) { int x = r[pc->b]; int y = r[pc->c]; r[pc->a] = (expr); VM_NEXT(); }
+#define VM_BINARY_K(name, expr) VM_CASE(name) { int x = r[pc->b]; int y = static_cast<int>(pc->c); r[pc->a] = (expr); VM_NEXT(); }
+
+#ifdef MYCOMPILER_COMPUTED_GOTO
+    VM_DISPATCH();
+#else
+dispatch:
+    switch (pc->op) {
+#endif
+
+    VM_CASE(LoadConst) {
+        r[pc->a] = static_cast<int>(pc->b);
+        VM_NEXT();
+    }
+    VM_CASE(Move) {
+        r[pc->a] = r[pc->b];
+        VM_NEXT();
+    }
+    VM_CASE(LoadVar) {
+        const VarSite& var = program_.vars[pc->b];
+        if (var.slot != kNoSlot && defined[var.slot]) {
+            r[pc->a] = r[var.slot];
+        } else {
+            std::cerr << "Ошибка: переменной " << Interner::Global().Name(var.name) << " не существует\n";
+            r[pc->a] = pc->c != 0 ? r[pc->c - 1] : last_;
+        }
+        VM_NEXT();
+    }
+    VM_CASE(StoreVar) {
+        last_ = r[pc->a];
+        r[pc->b] = last_;
+        defined[pc->b] = 1;
+        VM_NEXT();
+    }
+    VM_CASE(Declare) {
+        const VarSite& var = program_.vars[pc->b];
+        if (!defined[var.slot]) {
+            r[var.slot] = 0;
+            defined[var.slot] = 1;
+        } else {
+            std::cerr << "Ошибка: переменная" << Interner::Global().Name(var.name) << "уже существует\n";
+        }
+        VM_NEXT();
+    }
+
+    VM_BINARY(Add, x + y)
+    VM_BINARY(Sub, x - y)
+    VM_BINARY(Mul, x * y)
+    VM_BINARY(Div, x / y)
+    VM_BINARY_K(AddK, x + y)
+    VM_BINARY_K(SubK, x - y)
+    VM_BINARY_K(MulK, x * y)
+    VM_BINARY_K(DivK, x / y)
+    VM_BINARY(Eq, x == y)
+    VM_BINARY(Ne, x != y)
+    VM_BINARY(Lt, x < y)
+    VM_BINARY(Gt, x > y)
+    VM_BINARY(Le, x <= y)
+    VM_BINARY(Ge, x >= y)
+    VM_BINARY_K(EqK, x == y)
+    VM_BINARY_K(NeK, x != y)
+    VM_BINARY_K(LtK, x < y)
+    VM_BINARY_K(GtK, x > y)
+    VM_BINARY_K(LeK, x <= y)
+    VM_BINARY_K(GeK, x >= y)
+
+    VM_CASE(Jump) {
+        pc = code + pc->b;
+        VM_DISPATCH();
+    }
+    VM_CASE(JumpIfFalse) {
+        last_ = r[pc->a];
+        pc = last_ ? pc + 1 : code + pc->b;
+        VM_DISPATCH();
+    }
+    VM_CASE(Print) {
+        last_ = r[pc->a];
+        std::cout << last_ << std::endl;
+        VM_NEXT();
+    }
+    VM_CASE(Return) {
+        last_ = r[pc->a];
+        std::cout << "expression = " << last_ << std::endl;
+        goto leave;
+    }
+    VM_CASE(Echo) {
+        last_ = r[pc->a];
+        std::cout << "expression = " << last_ << std::endl;
+        VM_NEXT();
+    }
+    VM_CASE(BeginCall) {
+        const CallSite& site = program_.calls[pc->b];
+        uint32_t callee = functions_[site.name];
+        if (callee == kNoFunction) {
+            std::cerr << "no such function: " << Interner::Global().Name(site.name) << std::endl;
+        } else if (program_.functions[callee].paramSlots.size() != site.argCount) {
+            std::cerr << "wrong argument number" << std::endl;
+        } else {
+            // кадр резервируется до вычисления аргументов: вложенные вызовы
+            // в аргументах займут окна выше него
+            const BytecodeFunction& function = program_.functions[callee];
+            pending_calls_.push_back({callee, top});
+            ReserveFrame(top, function);
+            top += function.frameSize;
+            r = registers_.data() + base;
+            defined = defined_.data() + base;
+            VM_NEXT();
+        }
+        last_ = pc->c != 0 ? r[pc->c - 1] : last_;
+        r[pc->a] = last_;
+        pc = code + site.skipTo;
+        VM_DISPATCH();
+    }
+    VM_CASE(StoreArg) {
+        const PendingCall& pending = pending_calls_.back();
+        size_t param = pending.base + program_.functions[pending.function].paramSlots[pc->c];
+        last_ = r[pc->a];
+        registers_[param] = last_;
+        defined_[param] = 1;
+        VM_NEXT();
+    }
+    VM_CASE(Call) {
+        PendingCall pending = pending_calls_.back();
+        pending_calls_.pop_back();
+        frames_.push_back({pc + 1, base, pc->a});
+        base = pending.base;
+        r = registers_.data() + base;
+        defined = defined_.data() + base;
+        pc = code + program_.functions[pending.function].entry;
+        VM_DISPATCH();
+    }
+    VM_CASE(SetLast) {
+        last_ = r[pc->a];
+        VM_NEXT();
+    }
+    VM_CASE(End)
+    leave: {
+        if (frames_.size() == stopDepth) {
+            return;
+        }
+        Frame frame = frames_.back();
+        frames_.pop_back();
+        top = base;     // окно вызванной функции освобождается
+        base = frame.base;
+        r = registers_.data() + base;
+        defined = defined_.data() + base;
+        r[frame.result] = last_;
+        pc = frame.return_pc;
+        VM_DISPATCH();
+    }
+
+#ifndef MYCOMPILER_COMPUTED_GOTO
+    }
+#endif
+
+#undef VM_BINARY_K
+#undef VM_BINARY
+#undef VM_NEXT
+#undef VM_CASE
+#undef VM_DISPATCH
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+
+#include "bytecode.hpp"
+
+/// Исполнитель байткода: один цикл выборки инструкций (computed goto там,
+/// где его поддерживает компилятор, иначе switch), кадры вызовов и окна
+/// регистров лежат в собственных массивах, а не на стеке C++.
+/// Поведение то же, что у Interpreter: переменные живут в кадре вызова,
+/// `print` печатает значение, `return` печатает "expression = v" и
+/// завершает функцию, иначе результат вызова - последнее вычисленное значение.
+class Vm {
+public:
+    explicit Vm(const BytecodeProgram& program) : program_(program) {}
+
+    /// Регистрирует функции в порядке объявления и запускает тело main
+    /// в момент её объявления - как Interpreter::Visit(ProgramBlocks*).
+    void Run();
+
+private:
+    struct Frame {
+        const Instruction* return_pc;
+        size_t base;            // начало окна регистров вызывающей функции
+        uint16_t result;        // регистр вызывающей функции для результата
+    };
+
+    /// Кадр между BeginCall и Call: аргументы пишутся прямо в него.
+    struct PendingCall {
+        uint32_t function;
+        size_t base;
+    };
+
+    static constexpr uint32_t kNoFunction = UINT32_MAX;
+
+    const BytecodeProgram& program_;
+    std::vector<uint32_t> functions_;       // SymbolId -> номер в program_.functions
+    std::vector<int> registers_;
+    std::vector<char> defined_;             // параллельно registers_: переменная определена
+    std::vector<Frame> frames_;
+    std::vector<PendingCall> pending_calls_;
+    int last_ = 0;
+
+    void Execute(const BytecodeFunction& function);
+    /// Выделяет окно [base, base + frameSize) и сбрасывает его переменные.
+    void ReserveFrame(size_t base, const BytecodeFunction& function);
+};
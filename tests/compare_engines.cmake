@@ -0,0 +1,32 @@
+# Исполняет SOURCE интерпретатором, машинным кодом всей программы
+# (--engine=jit) и собранным через --link файлом на каждом уровне из
+# OPT_LEVELS и сравнивает вывод с EXPECTED.
+#   cmake -DCOMPILER=... -DSOURCE=... -DEXPECTED=... -DWORK_DIR=...
+#         -DOPT_LEVELS=-O0;-O2 -P compare_engines.cmake
+file(READ ${EXPECTED} expected)
+file(MAKE_DIRECTORY ${WORK_DIR})
+
+function(check what actual)
+    if(NOT actual STREQUAL expected)
+        message(FATAL_ERROR "${what}: ожидался вывод\n${expected}получен\n${actual}")
+    endif()
+endfunction()
+
+foreach(level ${OPT_LEVELS})
+    foreach(engine interp jit)
+        execute_process(
+            COMMAND ${COMPILER} ${SOURCE} ${WORK_DIR}/ast.txt --no-ast-cache --engine=${engine} ${level}
+            WORKING_DIRECTORY ${WORK_DIR} OUTPUT_VARIABLE output)
+        check("--engine=${engine} ${level}" "${output}")
+    endforeach()
+
+    set(executable ${WORK_DIR}/program${level})
+    execute_process(
+        COMMAND ${COMPILER} ${SOURCE} ${WORK_DIR}/ast.txt --no-ast-cache --link -o${executable} ${level}
+        WORKING_DIRECTORY ${WORK_DIR} OUTPUT_QUIET RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "--link ${level}: код выхода ${result}")
+    endif()
+    execute_process(COMMAND ${executable} OUTPUT_VARIABLE output)
+    check("--link ${level}" "${output}")
+endforeach()